@@ -2,20 +2,26 @@
 #include "resources.h"          // IDR_SPRITES
 
 #include <microlib/support-machinery.hpp>
+#include <microlib/graphics.hpp>
 
 #include <microlib/winapi++.hpp>
 #include <microlib/winapi-header-wrappers/windowsx-h.for-utf8.hpp>   // Message crackers, e.g. HANDLE_WM_CLOSE.
 
 #include <algorithm>
+#include <chrono>
 #include <functional>           // std::invoke
 #include <memory>               // std::(unique_ptr, make_unique)
 #include <string>               // std::(string, to_string)
 #include <string_view>          // std::string_view
 #include <optional>
+#include <thread>               // std::this_thread::sleep_for
 #include <utility>
+#include <vector>
 
+#include <stdint.h>             // int64_t
 #include <stdio.h>              // fprintf
-#include <stdlib.h>             // EXIT_SUCCESS, EXIT_FAILURE
+#include <stdlib.h>             // EXIT_SUCCESS, EXIT_FAILURE, getenv
+#include <string.h>             // memcpy, strcmp
 
 #define FAIL SM_FAIL
 
@@ -25,60 +31,140 @@ namespace app {
     using   sm::const_, sm::ref_, sm::in_,
             sm::hopefully, sm::C_string_ptr,
             sm::zero_to,
-            sm::pop_exception, sm::push_current_exception;
+            sm::push_current_exception,
+            sm::Wait_operation, sm::Jitter_histogram, sm::Triple_buffer_, sm::Work_stealing_pool,
+            sm::Cancellation_source, sm::Cancellation_token,
+            sm::Dispatch_map_, sm::On_;
     using   std::min,                           // <algorithm>
             std::invoke,                        // <functional>
             std::unique_ptr, std::make_unique,  // <memory>
+            std::shared_ptr, std::make_shared,
             std::string, std::to_string,        // <string>
             std::string_view,
             std::optional,
-            std::move;                          // <utility>
+            std::move,                          // <utility>
+            std::vector;
+    namespace chrono = std::chrono;
+    namespace this_thread = std::this_thread;
 
     namespace main_window {
-        struct Cmd{ enum Enum: int { exit = 100, mystery }; };
+        struct Cmd{ enum Enum: int { exit = 100, mystery, start_work }; };
+        struct Msg{ enum Enum: UINT { work_done = WM_APP + 1 }; };
+
+        constexpr auto max_shutdown_time = chrono::seconds( 2 );   // For work, after cancellation.
+
+        // Opt-in via environment variable `MESSAGE_LATENCY_STATS`, summary to `stderr` at exit.
+        bool is_timing_messages = false;
+
+        // The gladiator sheet has one animation per row of 32×32 cells, on a white background.
+        namespace sprite_sheet {
+            constexpr auto cell_size                    = graphics::Size{ 32, 32 };
+            constexpr int  n_cached_mirrored_frames     = 8;    // The longest animation.
+            constexpr int  animation_fps                = 12;
+
+            inline auto new_atlas( in_<graphics::Const_bgra_view> pixels )
+                -> graphics::Sprite_atlas
+            {
+                const graphics::Bgra_pixel color_key = pixels( 0, 0 );
+                return graphics::Sprite_atlas::from_grid( pixels, cell_size, color_key,
+                    { "idle", "move", "attack", "hurt", "death" }
+                    );
+            }
+        }  // namespace sprite_sheet
+
+        // The gladiator is shown idle, or moving while some work is in progress.
+        namespace sprite_display {
+            constexpr auto position     = graphics::Point{ 10, 50 };
+            constexpr int  scale        = 2;
+
+            // The non-background part `r` of a frame, given in cell coordinates, as shown in the window.
+            inline auto bounds_of( in_<graphics::Rect> r )
+                -> graphics::Rect
+            {
+                return {
+                    position.x + scale*r.left,  position.y + scale*r.top,
+                    position.x + scale*r.right, position.y + scale*r.bottom
+                    };
+            }
+        }  // namespace sprite_display
+
+        namespace progress_display {
+            constexpr auto bar_rect     = graphics::Rect{ 10, 124, 260, 132 };
+            constexpr auto track_color  = graphics::Bgra_pixel{ 0x40, 0xB0, 0xFF, 0xFF };
+            constexpr auto bar_color    = graphics::Bgra_pixel{ 0x80, 0x30, 0x00, 0xFF };
+        }  // namespace progress_display
+
+        // Published by the worker thread, picked up by the GUI thread on animation frames.
+        struct Progress
+        {
+            int     n_steps_done    = 0;
+            int     n_steps         = 0;
+            char    status[64]      = {};   // Fixed size, so that publishing doesn't allocate.
+        };
+
+        constexpr auto bg_color = graphics::Bgra_pixel{ 0, 0x80, 0xFF, 0xFF };
 
         struct State
         {
-            string                          basic_title;
-            winapi::Unique_bmp_handle       h_sprites_bitmap;
-            winapi::Unique_brush_handle     h_bg_brush;
+            string                              basic_title;
+            graphics::Bmp_view                  sprites_bmp;        // Refers directly to the resource bytes.
+            graphics::Bgra_image                sprites;            // 32bpp, for blitting.
+            graphics::Sprite_atlas              sprite_atlas;
+            graphics::Sprite_atlas::Animation   idle_animation;     // Looked up once, used every frame.
+            graphics::Sprite_atlas::Animation   move_animation;
+            graphics::Mirrored_frame_cache      mirrored_sprites;   // Facing the other way, made on demand.
+            winapi::Brush_cache                 brushes;
+            graphics::Back_buffer               back_buffer;        // The client area, composed off-screen.
+            graphics::Fill                      background;
+            unique_ptr<Work_stealing_pool>      p_render_pool;      // Created by the first fill of a large area.
+            graphics::Dirty_rects               dirty_rects;        // To be repainted, in client coordinates.
+            winapi::Unique_region_handle        update_region;      // Scratch, for `winapi::Update_rects`.
+            int64_t                             n_pixels_repainted;
+            int64_t                             n_pixels_in_full_repaints;  // For comparison.
+            HWND                                status_display;
+            shared_ptr<Triple_buffer_<Progress>>    p_progress;     // From the worker thread, which co-owns it.
+            Cancellation_source                 work_cancellation;
+            int64_t                             sprite_frame_number;
+            bool                                is_facing_back;     // Shown mirrored, turned at each start of work.
+            unique_ptr<winapi::Frame_ticker>    p_animation;        // While working.
+            unique_ptr<Wait_operation>          p_work;             // Last, to be joined first.
             
             State( string a_title ):
                 basic_title( move( a_title ) ),
-                h_sprites_bitmap( 0 ),
-                h_bg_brush( 0 )
+                sprites_bmp( graphics::parse_bmp( winapi::resource_bytes( IDR_SPRITES, RT_BITMAP ) ) ),
+                sprites( graphics::to_bgra_image( sprites_bmp ) ),
+                sprite_atlas( sprite_sheet::new_atlas( sprites.view() ) ),
+                idle_animation( sprite_atlas.animation( "idle" ) ),
+                move_animation( sprite_atlas.animation( "move" ) ),
+                mirrored_sprites( sprites.view(), sprite_atlas, sprite_sheet::n_cached_mirrored_frames ),
+                brushes(),
+                back_buffer(),
+                background( graphics::Fill::solid_color( bg_color ) ),
+                p_render_pool(),
+                dirty_rects(),
+                update_region( ::CreateRectRgn( 0, 0, 0, 0 ) ),
+                n_pixels_repainted( 0 ),
+                n_pixels_in_full_repaints( 0 ),
+                status_display( 0 ),
+                p_progress( make_shared<Triple_buffer_<Progress>>() ),
+                work_cancellation(),
+                sprite_frame_number( 0 ),
+                is_facing_back( false ),
+                p_animation(),
+                p_work()
             {
-                // Saving the image with MS Paint ensures that it's compatible with `LoadImage`.
-                h_sprites_bitmap = static_cast<HBITMAP>( ::LoadImage(
-                    winapi::h_instance,
-                    winapi::as_pseudo_ptr( IDR_SPRITES ),
-                    IMAGE_BITMAP,
-                    0, 0,                           // w, h
-                    LR_CREATEDIBSECTION             // DIB instead of device compatible
-                    ) );
-                hopefully( h_sprites_bitmap != 0 )
-                    or FAIL( sb << "Failed to load sprites bitmap, error code " << GetLastError() << "." );
-      
-                // h_bg_brush = ::CreatePatternBrush( h_sprites_bitmap );
-                // hopefully( h_bg_brush != 0 )
-                    // or FAIL( "Failed to create background fill brush, error code " + to_string( GetLastError() ) + "." );
+                // background = graphics::Fill::pattern_of( sprites.view() );
             }
             
             ~State() {}
         };
         
         unique_ptr<State>   p_state;
-        
+
         void basic_fill_background( const HWND window, const HDC dc, const RECT& rect )
         {
-            const HBRUSH fill = ::CreateSolidBrush( RGB( 0xFF, 0x80, 0 ) );
+            const HBRUSH fill = p_state->brushes.solid_brush( RGB( bg_color.r, bg_color.g, bg_color.b ) );
             ::FillRect( dc, &rect, fill );
-            ::DeleteObject( fill );
-        }
-
-        void fill_background( const HWND window, const HDC dc, const RECT& update_rect )
-        {
-            basic_fill_background( window, dc, update_rect );
         }
 
         void fill_control_background( const HWND window, const int control_id, const HDC dc, const RECT& update_rect )
@@ -87,18 +173,202 @@ namespace app {
             basic_fill_background( window, dc, update_rect );
         }
 
-        auto i_first_difference( in_<string_view> a, in_<string_view> b )
+        auto i_current_sprite_frame()
             -> int
         {
-            const int n_bytes = static_cast<int>( min( a.length(), b.length() ) );
-            for( const int i: zero_to( n_bytes ) ) {
-                if( a[i] != b[i] ) { return i; }
+            const graphics::Sprite_atlas::Animation& animation =
+                (p_state->p_animation? p_state->move_animation : p_state->idle_animation);
+            return p_state->sprite_atlas.frame_index( animation, static_cast<int>( p_state->sprite_frame_number % animation.n_frames ) );
+        }
+
+        // The current frame's cell pixels, mirrored via the cache when facing back.
+        auto current_sprite_pixels()
+            -> graphics::Const_bgra_view
+        {
+            const int i_frame = i_current_sprite_frame();
+            if( p_state->is_facing_back ) {
+                return p_state->mirrored_sprites.frame_pixels( i_frame );
+            }
+            return p_state->sprites.view().part( p_state->sprite_atlas.frame( i_frame ).cell );
+        }
+
+        // The current frame's non-background bounds in the window.
+        auto current_sprite_bounds()
+            -> graphics::Rect
+        {
+            const int i_frame = i_current_sprite_frame();
+            if( p_state->is_facing_back ) {
+                return sprite_display::bounds_of( p_state->mirrored_sprites.frame_bounds( i_frame ) );
+            }
+            const graphics::Sprite_atlas::Frame& frame = p_state->sprite_atlas.frame( i_frame );
+            return sprite_display::bounds_of( graphics::offset_by( frame.bounds, -frame.cell.left, -frame.cell.top ) );
+        }
+
+        void invalidate( const HWND window, in_<graphics::Rect> area )
+        {
+            graphics::Dirty_rects& dirty_rects = p_state->dirty_rects;
+            dirty_rects.add( area );
+            for( const graphics::Rect& r: dirty_rects.rects() ) {
+                const RECT winapi_rect = winapi::to_winapi_rect( r );
+                ::InvalidateRect( window, &winapi_rect, false );
+            }
+        }
+
+        // Invalidates the old and new sprite bounds, after a change of the current sprite frame.
+        void invalidate_sprite( const HWND window, in_<graphics::Rect> old_bounds )
+        {
+            p_state->dirty_rects.add( old_bounds );
+            invalidate( window, current_sprite_bounds() );
+        }
+
+        // The dirty rectangles, plus the parts of the update region that they don't cover, e.g.
+        // parts uncovered by another window.
+        auto rects_to_repaint( in_<winapi::Update_rects> update_rects )
+            -> const vector<graphics::Rect>&
+        {
+            graphics::Dirty_rects& dirty_rects = p_state->dirty_rects;
+            for( const graphics::Rect& r: update_rects ) {
+                if( not dirty_rects.covers( r ) ) {
+                    dirty_rects.add( r );
+                }
+            }
+            return dirty_rects.rects();
+        }
+
+        // Background plus sprite, in the back buffer. Only the given area is touched.
+        void compose( in_<graphics::Rect> area )
+        {
+            const graphics::Rect r = graphics::intersection_of( area, p_state->back_buffer.bounds() );
+            if( graphics::is_empty( r ) ) {
+                return;
+            }
+            const graphics::Bgra_view buffer = p_state->back_buffer.view();
+            if( graphics::is_rendered_in_parallel( buffer, r ) ) {
+                if( not p_state->p_render_pool ) {
+                    p_state->p_render_pool = make_unique<Work_stealing_pool>();
+                }
+                graphics::render_fill( buffer, r, p_state->background, *p_state->p_render_pool );
+            } else {
+                graphics::render_fill( buffer, r, p_state->background );
+            }
+            const graphics::Bgra_view pixels = p_state->back_buffer.view().part( r );
+
+            const auto fill_visible_part = [&]( in_<graphics::Rect> rect, in_<graphics::Bgra_pixel> color )
+            {
+                const graphics::Rect part = graphics::intersection_of( rect, r );
+                if( not graphics::is_empty( part ) ) {
+                    graphics::fill( p_state->back_buffer.view().part( part ), color );
+                }
+            };
+            const Progress& progress = p_state->p_progress->front();
+            graphics::Rect bar = progress_display::bar_rect;
+            fill_visible_part( bar, progress_display::track_color );
+            if( progress.n_steps > 0 ) {
+                bar.right = bar.left + graphics::width_of( bar )*progress.n_steps_done/progress.n_steps;
+                fill_visible_part( bar, progress_display::bar_color );
+            }
+
+            using sprite_display::position;
+            graphics::blit(
+                current_sprite_pixels(),
+                pixels, {position.x - r.left, position.y - r.top},
+                graphics::Blit_mode::with_color_key( p_state->sprites.view()( 0, 0 ) ),
+                sprite_display::scale
+                );
+        }
+
+        // Picks up only the newest progress, if any, from the worker thread.
+        void update_progress_display( const HWND window )
+        {
+            char old_status[sizeof( Progress::status )];      // Not a `string`: this is done every frame.
+            memcpy( old_status, p_state->p_progress->front().status, sizeof( old_status ) );
+            if( not p_state->p_progress->update() ) {
+                return;
+            }
+            invalidate( window, progress_display::bar_rect );
+            const C_string_ptr status = p_state->p_progress->front().status;
+            if( strcmp( status, old_status ) != 0 ) {
+                ::SetWindowText( p_state->status_display, status );
+            }
+        }
+
+        void on_animation_frame( const HWND window, in_<winapi::Frame_ticker::Tick> tick )
+        {
+            update_progress_display( window );
+            const graphics::Rect old_bounds = current_sprite_bounds();
+            p_state->sprite_frame_number = tick.frame_number;
+            invalidate_sprite( window, old_bounds );
+        }
+
+        // Stand-in for some long running work such as a download or a computation.
+        void simulated_work( Triple_buffer_<Progress>& progress, in_<Cancellation_token> cancellation )
+        {
+            constexpr int n_steps = 300;
+            for( const int i: sm::one_through( n_steps ) ) {
+                if( cancellation.is_cancelled() ) {
+                    return;
+                }
+                this_thread::sleep_for( chrono::milliseconds( 10 ) );
+                Progress& p = progress.back();
+                p.n_steps_done = i;
+                p.n_steps = n_steps;
+                snprintf( p.status, sizeof( p.status ), "Step %d of %d.", i, n_steps );
+                progress.publish();
+            }
+        }
+
+        void start_work( const HWND window )
+        {
+            if( p_state->p_work ) {
+                winapi::message_box( window, "Already working, please wait." );
+                return;
+            }
+            p_state->n_pixels_repainted = 0;
+            p_state->n_pixels_in_full_repaints = 0;
+            const graphics::Rect old_sprite_bounds = current_sprite_bounds();
+            p_state->is_facing_back = not p_state->is_facing_back;
+            p_state->p_animation = make_unique<winapi::Frame_ticker>( sprite_sheet::animation_fps,
+                [window]( in_<winapi::Frame_ticker::Tick> tick ) { on_animation_frame( window, tick ); }
+                );
+            invalidate_sprite( window, old_sprite_bounds );
+            p_state->work_cancellation = Cancellation_source();
+            p_state->p_work = make_unique<Wait_operation>(
+                [p_progress = p_state->p_progress, cancellation = p_state->work_cancellation.token()]
+                {
+                    simulated_work( *p_progress, cancellation );
+                },
+                winapi::message_poster( window, Msg::work_done )
+                );
+        }
+
+        // Cancels any work in progress, and waits a bounded time for it to stop.
+        void stop_work()
+        {
+            if( not p_state->p_work ) {
+                return;
+            }
+            p_state->work_cancellation.cancel();
+            const bool work_stopped = p_state->p_work->wait_for( max_shutdown_time );
+            p_state->p_animation.reset();   // Now, while this thread's event loop that it uses exists.
+            if( not work_stopped ) {
+                // Abandoned, i.e. deliberately leaked: the stuck worker thread still uses it, and
+                // destroying it would wait for that thread without a time limit. The thread co-owns the
+                // progress buffer and the cancellation state, so it doesn't use `State` afterwards.
+                (void) p_state->p_work.release();
+                FAIL( "The work didn’t stop within " + to_string( max_shutdown_time.count() ) + " seconds of cancellation." );
             }
-            return (a.length() == b.length()? -1 : n_bytes);
+            p_state->p_work.reset();        // Any exception from the work is ignored.
         }
 
         void on_command( const HWND window, const int id )
         {
+            if( id == Cmd::exit ) {
+                ::SendMessage( window, WM_CLOSE, 0, 0 );
+                return;
+            } else if( id == Cmd::start_work ) {
+                start_work( window );
+                return;
+            }
             // MessageBox( window,
                 // sb << "Button press, id " << id << ".",
                 // ~p_state->basic_title,
@@ -126,6 +396,16 @@ namespace app {
                         
         auto is_button( const HWND ) -> bool { return true; }
 
+        // Adapts a handler of a specific notification struct, e.g. `NMCUSTOMDRAW`, to the `NMHDR` prefix.
+        template< class Info, auto handler >
+        auto with_nmhdr( const HWND window, const int control_id, const_<const NMHDR*> p_header )
+            -> optional<LRESULT>
+        { return handler( window, control_id, reinterpret_cast<const Info*>( p_header ) ); }
+
+        using Notification_map = Dispatch_map_<LRESULT( UINT, HWND, int, const NMHDR* ),
+            On_<NM_CUSTOMDRAW,      &with_nmhdr<NMCUSTOMDRAW, on_nm_custom_draw>>
+            >;
+
         namespace message_handlers {
             // The handler signature comments are from the Visual C++ version of `<windowsx.h>`.
             // The g++ version of that header is unfortunately sans comments.
@@ -133,6 +413,7 @@ namespace app {
             // void Cls_OnClose(HWND hwnd)
             void on_wm_close( const HWND )
             {
+                stop_work();
                 ::PostQuitMessage( 0 );
             }
 
@@ -156,17 +437,19 @@ namespace app {
             {
                 // p_params->lpszName is buggy, possibly a truncated UTF-8 back-translation, so:
                 (void) p_params;
-                p_state = make_unique<State>( winapi::title_of( window ) );
-
-                using namespace winapi::option_parameter_types;
-                winapi::new_child_window_of( window, "button",
-                    With_position{ 10, 10 },
-                    With_rect_size{ 120, winapi::good_button_height },
-                    With_text{ "Click me" },
-                    With_id{ Cmd::exit },
-                    With_styles{ BS_DEFPUSHBUTTON | WS_VISIBLE }
-                    )
-                    or FAIL( "Failed to create button." );
+                p_state = make_unique<State>( string( winapi::cached_title_of( window ) ) );
+
+                const vector<graphics::Control_spec> controls =
+                {
+                    { "button", "Exit", Cmd::exit, BS_DEFPUSHBUTTON | WS_VISIBLE,
+                        {120, winapi::good_button_height} },
+                    { "button", "Start work", Cmd::start_work, BS_PUSHBUTTON | WS_VISIBLE,
+                        {120, winapi::good_button_height} },
+                    { "static", "", 0, SS_LEFT | SS_NOPREFIX | WS_VISIBLE,
+                        {250, 20}, graphics::Point{ 10, 140 } }
+                };
+                const vector<HWND> windows = winapi::new_child_windows_of( window, controls, {{10, 10, 270, 10}} );
+                p_state->status_display = windows.back();
                 return true;
             }
 
@@ -180,27 +463,160 @@ namespace app {
             auto on_wm_erasebkgnd( const HWND window, const HDC dc )
                 -> bool
             {
-                RECT update_rect;
-                ::GetUpdateRect( window, &update_rect, false );
-                fill_background( window, dc, update_rect );
+                (void) window; (void) dc;
+                // The background is composed in the back buffer and presented in `on_wm_paint`,
+                // so erasing here would just add flicker.
                 // In Windows 11 it looks like the return value is ignored. Must call DefWindowProc
                 // to get the default erasing. But per docs `true` means the job is done.
                 return true;
             }
 
+            // "HBRUSH Cls_OnCtlColor(HWND hwnd, HDC hdc, HWND hwndChild, int type)"
+            auto on_wm_ctlcolorstatic( const HWND, const HDC dc, const HWND, int )
+                -> HBRUSH
+            {
+                ::SetBkMode( dc, TRANSPARENT );
+                return p_state->brushes.solid_brush( RGB( bg_color.r, bg_color.g, bg_color.b ) );
+            }
+
+            // No message cracker. E.g. the UI font size may have changed.
+            void on_wm_settingchange( const HWND window )
+            {
+                winapi::refresh_ui_fonts_of( window );
+            }
+
+            // No message cracker. Posted by the worker thread of `p_state->p_work`.
+            void on_work_done( const HWND window )
+            {
+                const auto notification_time = Wait_operation::Clock::now();
+                if( not p_state->p_work ) {
+                    return;     // Already stopped by `stop_work`.
+                }
+                const unique_ptr<Wait_operation> p_work = move( p_state->p_work );
+                p_work->wait();
+                const auto as_ms = []( const auto d ) { return chrono::duration_cast<chrono::milliseconds>( d ).count(); };
+                const auto as_us = []( const auto d ) { return chrono::duration_cast<chrono::microseconds>( d ).count(); };
+                const auto work_duration    = p_work->completion_time() - p_work->start_time();
+                const auto wakeup_latency   = notification_time - p_work->completion_time();
+
+                update_progress_display( window );     // The final progress.
+                const graphics::Rect old_sprite_bounds = current_sprite_bounds();
+                const unique_ptr<winapi::Frame_ticker> p_animation = move( p_state->p_animation );
+                const Jitter_histogram& jitter = p_animation->pacer().jitter();
+                p_state->sprite_frame_number = 0;
+                invalidate_sprite( window, old_sprite_bounds );
+
+                p_work->finish();       // Rethrows any exception from the work.
+                winapi::message_box( window, sb
+                    << "Work finished in " << as_ms( work_duration ) << " ms; "
+                    << "the GUI was notified " << as_us( wakeup_latency ) << " µs after completion.\n"
+                    << "\n"
+                    << "Animation: " << jitter.n_samples() << " frames shown, "
+                    << p_animation->pacer().n_dropped() << " dropped; tick lateness "
+                    << "median ≤ " << as_us( jitter.percentile( 0.5 ) ) << " µs, "
+                    << "99% ≤ " << as_us( jitter.percentile( 0.99 ) ) << " µs, "
+                    << "max " << as_us( jitter.max() ) << " µs.\n"
+                    << "Repainted " << p_state->n_pixels_repainted << " pixels, versus "
+                    << p_state->n_pixels_in_full_repaints << " with full client area repaints."
+                    );
+            }
+
+            // "void Cls_OnPaint(HWND hwnd)"
+            void on_wm_paint( const HWND window )
+            {
+                const auto update_rects = winapi::Update_rects( window, p_state->update_region );
+                PAINTSTRUCT info;
+                const HDC dc = ::BeginPaint( window, &info );
+                RECT client_rect;
+                ::GetClientRect( window, &client_rect );
+
+                graphics::Back_buffer& back_buffer = p_state->back_buffer;
+                graphics::Dirty_rects& dirty_rects = p_state->dirty_rects;
+                if( back_buffer.resize( graphics::size_of( winapi::to_graphics_rect( client_rect ) ) ) ) {
+                    dirty_rects.clear();
+                    dirty_rects.add( back_buffer.bounds() );        // All pixels are new.
+                }
+                for( const graphics::Rect& r: rects_to_repaint( update_rects ) ) {
+                    compose( r );
+                }
+                const graphics::Rect presented = graphics::intersection_of( dirty_rects.bounds(), back_buffer.bounds() );
+                if( not graphics::is_empty( presented ) ) {
+                    winapi::draw_pixels(        // A single blit; pixels outside the dirty rects are unchanged.
+                        dc, {presented.left, presented.top}, back_buffer.storage_view(), presented
+                        );
+                }
+
+                p_state->n_pixels_repainted += dirty_rects.area();
+                p_state->n_pixels_in_full_repaints += graphics::area_of( winapi::to_graphics_rect( client_rect ) );
+                dirty_rects.clear();
+                ::EndPaint( window, &info );
+            }
+
             // No message cracker.
             auto on_wm_notify( const HWND window, const int control_id, const_<const NMHDR*> p_header )
                 -> optional<LRESULT>
             {
-                switch( p_header->code ) {
-                    case NM_CUSTOMDRAW: return on_nm_custom_draw(
-                        window, control_id, reinterpret_cast<const NMCUSTOMDRAW*>( p_header )
-                        );
-                }
-                return {};
+                return Notification_map::dispatch( p_header->code, window, control_id, p_header );
             }
         }  // namespace message_handlers
 
+        // A message handler adapted to the common signature of `Message_map` handlers.
+        template< UINT msg_id >
+        auto cracked( HWND window, WPARAM w_param, LPARAM ell_param ) -> optional<LRESULT>;
+
+        #define CRACKED( m, f ) \
+            template<> auto cracked<m>( const HWND window, const WPARAM w_param, const LPARAM ell_param ) \
+                -> optional<LRESULT> \
+            { return HANDLE_##m( window, w_param, ell_param, f ); }
+
+        CRACKED( WM_CLOSE,          message_handlers::on_wm_close )
+        CRACKED( WM_COMMAND,        message_handlers::on_wm_command )
+        CRACKED( WM_CREATE,         message_handlers::on_wm_create )
+        CRACKED( WM_CTLCOLORSTATIC, message_handlers::on_wm_ctlcolorstatic )
+        CRACKED( WM_ERASEBKGND,     message_handlers::on_wm_erasebkgnd )
+        CRACKED( WM_PAINT,          message_handlers::on_wm_paint )
+        #undef CRACKED
+
+        template<>
+        auto cracked<WM_NOTIFY>( const HWND window, const WPARAM w_param, const LPARAM ell_param )
+            -> optional<LRESULT>
+        {
+            return message_handlers::on_wm_notify(
+                window,
+                static_cast<int>( w_param ),                                            // Control id.
+                reinterpret_cast<const NMHDR*>( static_cast<uintptr_t>( ell_param ) )   // NMHDR
+                );
+        }
+
+        template<>
+        auto cracked<WM_SETTINGCHANGE>( const HWND window, WPARAM, LPARAM )
+            -> optional<LRESULT>
+        {
+            message_handlers::on_wm_settingchange( window );
+            return {};      // Also default processing.
+        }
+
+        template<>
+        auto cracked<Msg::work_done>( const HWND window, WPARAM, LPARAM )
+            -> optional<LRESULT>
+        {
+            message_handlers::on_work_done( window );
+            return 0;
+        }
+
+        // A perfect hash of the message id selects the handler; other messages go to `DefWindowProc`.
+        using Message_map = Dispatch_map_<LRESULT( UINT, HWND, WPARAM, LPARAM ),
+            On_<WM_CLOSE,           &cracked<WM_CLOSE>>,
+            On_<WM_COMMAND,         &cracked<WM_COMMAND>>,
+            On_<WM_CREATE,          &cracked<WM_CREATE>>,
+            On_<WM_CTLCOLORSTATIC,  &cracked<WM_CTLCOLORSTATIC>>,
+            On_<WM_ERASEBKGND,      &cracked<WM_ERASEBKGND>>,
+            On_<WM_PAINT,           &cracked<WM_PAINT>>,
+            On_<WM_SETTINGCHANGE,   &cracked<WM_SETTINGCHANGE>>,
+            On_<WM_NOTIFY,          &cracked<WM_NOTIFY>>,
+            On_<Msg::work_done,     &cracked<Msg::work_done>>
+            >;
+
         auto message_handler(
             const HWND      window,
             const UINT      msg_id,
@@ -209,27 +625,11 @@ namespace app {
             )
             -> LRESULT
         {
+            const auto timing = winapi::Message_timing( msg_id, is_timing_messages );
             try {
-                #define CASE( m, f ) case m: return HANDLE_##m( window, w_param, ell_param, f )
-                switch( msg_id ) {
-                    CASE( WM_CLOSE,         message_handlers::on_wm_close );
-                    CASE( WM_COMMAND,       message_handlers::on_wm_command );
-                    CASE( WM_CREATE,        message_handlers::on_wm_create );
-                    CASE( WM_ERASEBKGND,    message_handlers::on_wm_erasebkgnd );
-
-                    case WM_NOTIFY:         {
-                        const optional<LRESULT> retvalue = message_handlers::on_wm_notify(
-                            window,
-                            static_cast<int>( w_param ),                                            // Control id.
-                            reinterpret_cast<const NMHDR*>( static_cast<uintptr_t>( ell_param ) )   // NMHDR
-                            );
-                        if( retvalue ) { return *retvalue; }
-                        break;
-                    }
-                }
-                #undef CASE
+                const optional<LRESULT> retvalue = Message_map::dispatch( msg_id, window, w_param, ell_param );
+                if( retvalue ) { return *retvalue; }
             } catch( ... ) {
-                pop_exception();        // Shouldn't be necessary, but.
                 push_current_exception();
             }
             return ::DefWindowProc( window, msg_id, w_param, ell_param );
@@ -265,6 +665,7 @@ namespace app {
     void run()
     {
         SM_WITH( comctl32::Library_envelope() ) {   // Initialization for modern look and feel.
+            main_window::is_timing_messages = (getenv( "MESSAGE_LATENCY_STATS" ) != nullptr);
             const HWND window = main_window::new_titled( "日本国 кошка 🐈" );
             ShowWindow( window, SW_SHOWDEFAULT );
             try {
@@ -272,6 +673,9 @@ namespace app {
             } catch( ... ) {
                 FAIL( "Something failed, I’m terminating; really sorry!" );
             }
+            if( main_window::is_timing_messages ) {
+                winapi::write_message_latency_summary_to( stderr );
+            }
         }
     }
 }  // namespace app
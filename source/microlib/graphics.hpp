@@ -0,0 +1,17 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Portable pixel handling, no dependency on the Windows API.
+
+#include <microlib/graphics/Back_buffer.hpp>        // Back_buffer
+#include <microlib/graphics/blitting.hpp>           // Blit_mode, blit, blit_row_kernels
+#include <microlib/graphics/bmp-decoding.hpp>       // Bmp_format, Bmp_view, parse_bmp, to_bgra_image
+#include <microlib/graphics/Dirty_rects.hpp>        // Dirty_rects
+#include <microlib/graphics/Font_cache_.hpp>        // Font_cache_
+#include <microlib/graphics/Font_key.hpp>           // Font_key, scaled_for_dpi, standard_dpi
+#include <microlib/graphics/form-layout.hpp>        // Control_spec, Flow_layout, placements_of, create_controls
+#include <microlib/graphics/geometry.hpp>           // Point, Size, Rect, width_of, height_of, intersection_of, contains
+#include <microlib/graphics/Mirrored_frame_cache.hpp>   // Mirrored_frame_cache, mirror_horizontally
+#include <microlib/graphics/pixels.hpp>             // Bgr_pixel, Bgra_pixel, Pixel_view_, Bgra_image, fill
+#include <microlib/graphics/Sprite_atlas.hpp>       // Sprite_atlas, save_sidecar, load_sidecar
+#include <microlib/graphics/tiled-rendering.hpp>   // Fill, render_fill, cache_sized_tile_size_for
+#include <microlib/graphics/tiling.hpp>            // Tiles, tiles_of, rows_of, columns_of
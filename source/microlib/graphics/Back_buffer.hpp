@@ -0,0 +1,79 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A persistent off-screen 32bpp top-down pixel buffer, e.g. for a window's client area, where
+// a frame is composed before it's presented with a single blit.
+//
+// The pixels are reallocated only when the buffer grows beyond its capacity, with geometric
+// growth, or when it shrinks to less than a quarter of the capacity area. Otherwise the pixels
+// are kept as is, so that only dirty areas need to be composed again.
+
+#include <microlib/graphics/geometry.hpp>       // Size, Rect
+#include <microlib/graphics/pixels.hpp>         // Bgra_pixel, Bgra_view, Const_bgra_view
+#include <microlib/support-machinery.hpp>       // Index, in_, hopefully, SM_FAIL
+
+#include <stdint.h>         // int64_t
+
+#include <algorithm>
+#include <vector>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::Index, sm::in_, sm::hopefully;
+    using   std::max,           // <algorithm>
+            std::vector;
+
+    class Back_buffer
+    {
+        vector<Bgra_pixel>      m_pixels;
+        Size                    m_capacity;
+        Size                    m_size;
+        int64_t                 m_n_allocations;
+
+        static auto grown( const int capacity, const int wanted )
+            -> int
+        { return (wanted <= capacity? capacity : max( wanted, capacity + capacity/2 )); }
+
+    public:
+        Back_buffer(): m_capacity{ 0, 0 }, m_size{ 0, 0 }, m_n_allocations( 0 ) {}
+
+        auto size() const           -> Size     { return m_size; }
+        auto capacity() const       -> Size     { return m_capacity; }
+        auto bounds() const         -> Rect     { return {0, 0, m_size.w, m_size.h}; }
+        auto n_allocations() const  -> int64_t  { return m_n_allocations; }
+
+        // Returns `true` if the pixels were reallocated, so that all of them must be composed.
+        auto resize( in_<Size> new_size )
+            -> bool
+        {
+            hopefully( new_size.w >= 0 and new_size.h >= 0 )
+                or SM_FAIL( "A back buffer size can't be negative." );
+            const bool must_grow = (new_size.w > m_capacity.w or new_size.h > m_capacity.h);
+            const bool may_shrink = (4*Index( new_size.w )*new_size.h < Index( m_capacity.w )*m_capacity.h);
+
+            m_size = new_size;
+            if( not (must_grow or may_shrink) ) {
+                return false;
+            }
+            m_capacity = (must_grow
+                ? Size{ grown( m_capacity.w, new_size.w ), grown( m_capacity.h, new_size.h ) }
+                : new_size
+                );
+            vector<Bgra_pixel>( Index( m_capacity.w )*m_capacity.h ).swap( m_pixels );
+            ++m_n_allocations;
+            return true;
+        }
+
+        auto view()
+            -> Bgra_view
+        { return Bgra_view( m_pixels.data(), m_size.w, m_size.h, Index( m_capacity.w )*Index( sizeof( Bgra_pixel ) ) ); }
+
+        auto view() const
+            -> Const_bgra_view
+        { return Const_bgra_view( m_pixels.data(), m_size.w, m_size.h, Index( m_capacity.w )*Index( sizeof( Bgra_pixel ) ) ); }
+
+        // The rows at full capacity width, which are contiguous, e.g. for presenting a part.
+        auto storage_view() const
+            -> Const_bgra_view
+        { return Const_bgra_view( m_pixels.data(), m_capacity.w, m_size.h ); }
+    };
+}  // namespace graphics
@@ -0,0 +1,120 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Accumulates the areas that need repainting, e.g. the old and new bounds of a moving sprite,
+// as at most `max_rects` non-overlapping rectangles.
+//
+// A rectangle that overlaps others is merged with them into their bounding rectangle. When
+// there are too many rectangles the pair whose bounding rectangle adds the least area is
+// merged. So the result can cover some pixels that weren't added, but never fewer.
+
+#include <microlib/graphics/geometry.hpp>       // Rect, area_of, bounding_rect_of, intersects, contains
+#include <microlib/support-machinery.hpp>       // in_, hopefully, SM_FAIL, zero_to
+
+#include <vector>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::hopefully, sm::zero_to;
+    using   std::vector;
+
+    class Dirty_rects
+    {
+        int             m_max_rects;
+        vector<Rect>    m_rects;
+
+        // Adds `r`, merging it with rectangles that it overlaps until none overlap.
+        void add_merged( Rect r )
+        {
+            for( int i = 0; i < n_rects(); ) {
+                if( intersects( m_rects[i], r ) ) {
+                    r = bounding_rect_of( r, m_rects[i] );
+                    m_rects[i] = m_rects.back();
+                    m_rects.pop_back();
+                    i = 0;          // The larger `r` may now overlap a rectangle already checked.
+                } else {
+                    ++i;
+                }
+            }
+            m_rects.push_back( r );
+        }
+
+        void merge_cheapest_pair()
+        {
+            int i_best = 0;
+            int j_best = 1;
+            long long best_added_area = -1;
+            for( const int i: zero_to( n_rects() ) ) {
+                for( int j = i + 1; j < n_rects(); ++j ) {
+                    const Rect& a = m_rects[i];
+                    const Rect& b = m_rects[j];
+                    const long long added_area = area_of( bounding_rect_of( a, b ) ) - area_of( a ) - area_of( b );
+                    if( best_added_area < 0 or added_area < best_added_area ) {
+                        i_best = i;  j_best = j;  best_added_area = added_area;
+                    }
+                }
+            }
+            const Rect merged = bounding_rect_of( m_rects[i_best], m_rects[j_best] );
+            m_rects.erase( m_rects.begin() + j_best );      // `j_best` > `i_best`.
+            m_rects.erase( m_rects.begin() + i_best );
+            add_merged( merged );
+        }
+
+    public:
+        explicit Dirty_rects( const int max_rects = 4 ):
+            m_max_rects( max_rects )
+        {
+            hopefully( max_rects >= 1 ) or SM_FAIL( "A dirty rectangle set needs room for at least one rectangle." );
+            m_rects.reserve( max_rects + 1 );
+        }
+
+        auto max_rects() const  -> int                  { return m_max_rects; }
+        auto n_rects() const    -> int                  { return static_cast<int>( m_rects.size() ); }
+        auto rects() const      -> const vector<Rect>&  { return m_rects; }
+        auto is_empty() const   -> bool                 { return m_rects.empty(); }
+
+        // The number of pixels to repaint. The rectangles don't overlap, so there's no double counting.
+        auto area() const
+            -> long long
+        {
+            long long result = 0;
+            for( const Rect& r: m_rects ) { result += area_of( r ); }
+            return result;
+        }
+
+        auto bounds() const
+            -> Rect
+        {
+            Rect result = {};
+            for( const Rect& r: m_rects ) { result = bounding_rect_of( result, r ); }
+            return result;
+        }
+
+        // Whether every pixel of `r` is in some of the rectangles.
+        auto covers( in_<Rect> r ) const
+            -> bool
+        {
+            long long covered_area = 0;
+            for( const Rect& dirty: m_rects ) {
+                const Rect common = intersection_of( dirty, r );
+                if( not graphics::is_empty( common ) ) { covered_area += area_of( common ); }
+            }
+            return covered_area == area_of( r ) or graphics::is_empty( r );
+        }
+
+        void add( in_<Rect> r )
+        {
+            if( graphics::is_empty( r ) ) {
+                return;
+            }
+            for( const Rect& dirty: m_rects ) {
+                if( contains( dirty, r ) ) { return; }
+            }
+            add_merged( r );
+            while( n_rects() > m_max_rects ) {
+                merge_cheapest_pair();
+            }
+        }
+
+        void clear() { m_rects.clear(); }
+    };
+}  // namespace graphics
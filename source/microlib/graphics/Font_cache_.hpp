@@ -0,0 +1,66 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A bounded, thread safe cache of fonts keyed by `Font_key`, for any font handle type, e.g. a
+// Windows `HFONT` owner.
+//
+// Windows keep using a font after it has been handed out, so no font that the cache has handed out
+// is destroyed before the next `invalidate()`. An evicted font is retired instead, and
+// `invalidate()` returns both the cached and the retired fonts, for the caller to keep until the
+// windows have new fonts. Between settings changes a program uses few distinct fonts, so the
+// retired fonts don't add up.
+
+#include <microlib/graphics/Font_key.hpp>                           // Font_key
+#include <microlib/support-machinery.hpp>                           // in_, Non_copyable
+#include <microlib/support-machinery/Shared_lru_cache_.hpp>         // Shared_lru_cache_, Cache_stats
+
+#include <limits.h>         // INT_MAX
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::Non_copyable, sm::Shared_lru_cache_, sm::Cache_stats;
+    using   std::shared_ptr,                // <memory>
+            std::forward, std::move,        // <utility>
+            std::vector;
+
+    template< class tp_Font >
+    class Font_cache_:
+        public Non_copyable
+    {
+    public:
+        using Font = tp_Font;
+        using Removed_fonts = vector<shared_ptr<const Font>>;
+
+    private:
+        Shared_lru_cache_<Font_key, Font, Font_key::Hash>    m_fonts;
+
+    public:
+        explicit Font_cache_( const int capacity = 16 ): m_fonts( capacity, INT_MAX ) {}
+
+        auto capacity() const   -> int          { return m_fonts.capacity(); }
+        auto size() const       -> int          { return m_fonts.size(); }
+        auto stats() const      -> Cache_stats  { return m_fonts.stats(); }
+        auto n_retired() const  -> int          { return m_fonts.n_retired(); }
+
+        // The cached font for `key`, or else `make_font()`, which is then cached. The font is valid
+        // until the result of the next `invalidate()` is destroyed.
+        template< class Factory >
+        auto font( in_<Font_key> key, Factory&& make_font )
+            -> const Font&
+        { return *m_fonts.get_or_make( key, forward<Factory>( make_font ) ); }
+
+        // E.g. on a system settings change: later requests get new fonts. The old fonts, cached
+        // and retired, are destroyed when the result is.
+        auto invalidate()
+            -> Removed_fonts
+        {
+            // Retired fonts first, so that a font evicted meanwhile is an old one, and is kept.
+            Removed_fonts result = m_fonts.take_retired();
+            for( shared_ptr<const Font>& p_font: m_fonts.invalidate() ) { result.push_back( move( p_font ) ); }
+            return result;
+        }
+    };
+}  // namespace graphics
@@ -0,0 +1,75 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// The identity of a font for caching, e.g. of Windows `HFONT`s: face name, size, weight,
+// slant and the DPI that the size is for. The face name is stored inline, so a key doesn't allocate.
+
+#include <microlib/support-machinery.hpp>       // in_
+
+#include <stddef.h>         // size_t
+#include <stdint.h>         // uint64_t
+#include <string.h>         // memcmp
+
+#include <algorithm>
+#include <string_view>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::in_;
+    using   std::min,               // <algorithm>
+            std::string_view;
+
+    constexpr int standard_dpi = 96;
+
+    // Rounded, e.g. for a font height in pixels at `standard_dpi` to `dpi`; as Windows' `MulDiv`.
+    constexpr auto scaled_for_dpi( const int value, const int dpi, const int from_dpi = standard_dpi )
+        -> int
+    {
+        const long long product = 1LL*value*dpi;
+        const long long half = from_dpi/2;
+        return static_cast<int>( (product >= 0? product + half : product - half)/from_dpi );
+    }
+
+    struct Font_key
+    {
+        static constexpr int max_face_length = 31;     // As Windows' `LF_FACESIZE` - 1.
+
+        char    face[max_face_length + 1];  // Null-padded.
+        int     height;                     // E.g. a `LOGFONT::lfHeight`, for `dpi`.
+        int     weight;                     // E.g. 400 for normal, 700 for bold.
+        bool    is_italic;
+        int     dpi;
+
+        static auto of( in_<string_view> face, const int height, const int weight, const bool is_italic, const int dpi )
+            -> Font_key
+        {
+            Font_key result = {};
+            face.copy( result.face, min<size_t>( face.size(), max_face_length ) );
+            result.height = height;  result.weight = weight;  result.is_italic = is_italic;  result.dpi = dpi;
+            return result;
+        }
+
+        auto face_name() const -> string_view { return string_view( face ); }
+
+        friend auto operator==( in_<Font_key> a, in_<Font_key> b )
+            -> bool
+        {
+            return memcmp( a.face, b.face, sizeof( a.face ) ) == 0 and a.height == b.height
+                and a.weight == b.weight and a.is_italic == b.is_italic and a.dpi == b.dpi;
+        }
+
+        struct Hash
+        {
+            auto operator()( in_<Font_key> key ) const
+                -> size_t
+            {
+                uint64_t h = 14695981039346656037u;     // 64-bit FNV-1a over the face name.
+                for( const char ch: key.face_name() ) { h = (h ^ static_cast<unsigned char>( ch ))*1099511628211u; }
+                h = 31*h + uint64_t( key.height );
+                h = 31*h + uint64_t( key.weight );
+                h = 31*h + uint64_t( key.is_italic );
+                h = 31*h + uint64_t( key.dpi );
+                return size_t( h ^ (h >> 32) );        // Folded, for a 32-bit `size_t`.
+            }
+        };
+    };
+}  // namespace graphics
@@ -0,0 +1,185 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Horizontally mirrored sprite frames made on demand, so that a sprite sheet needs only be
+// stored facing one way. A bounded number of mirrored frames are cached, keyed by frame index,
+// with the least recently used one replaced when the cache is full.
+//
+// The row reversal has SSE2 and AVX2 versions and a scalar fallback, selected at first use.
+
+#include <microlib/support-machinery.hpp>                   // in_, zero_to, hopefully, SM_FAIL
+#include <microlib/support-machinery/cpu-features.hpp>      // Simd_level, simd_level, SM_TARGET_AVX2
+#include <microlib/graphics/geometry.hpp>                   // Rect
+#include <microlib/graphics/pixels.hpp>                     // Bgra_pixel, Bgra_image, Const_bgra_view
+#include <microlib/graphics/Sprite_atlas.hpp>               // Sprite_atlas
+
+#include <assert.h>         // assert
+#include <stdint.h>         // uint64_t
+
+#include <vector>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::zero_to, sm::hopefully, sm::Simd_level;
+    using   std::vector;
+
+    using Mirror_row_kernel = void( const Bgra_pixel* p_source, Bgra_pixel* p_destination, int n );
+
+    namespace impl::scalar {
+        inline void mirror_row( const Bgra_pixel* p_source, Bgra_pixel* p_destination, const int n )
+        {
+            for( const int i: zero_to( n ) ) { p_destination[n - 1 - i] = p_source[i]; }
+        }
+    }  // namespace impl::scalar
+
+    #if SM_IS_X86
+    namespace impl::sse2 {
+        SM_TARGET_SSE2 inline void mirror_row( const Bgra_pixel* p_source, Bgra_pixel* p_destination, const int n )
+        {
+            int i = 0;
+            for( ; i + 4 <= n; i += 4 ) {
+                const __m128i s = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p_source + i ) );
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>( p_destination + n - 4 - i ),
+                    _mm_shuffle_epi32( s, _MM_SHUFFLE( 0, 1, 2, 3 ) )
+                    );
+            }
+            scalar::mirror_row( p_source + i, p_destination, n - i );
+        }
+    }  // namespace impl::sse2
+
+    namespace impl::avx2 {
+        SM_TARGET_AVX2 inline void mirror_row( const Bgra_pixel* p_source, Bgra_pixel* p_destination, const int n )
+        {
+            const __m256i reversed_order = _mm256_setr_epi32( 7, 6, 5, 4, 3, 2, 1, 0 );
+            int i = 0;
+            for( ; i + 8 <= n; i += 8 ) {
+                const __m256i s = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p_source + i ) );
+                _mm256_storeu_si256(
+                    reinterpret_cast<__m256i*>( p_destination + n - 8 - i ),
+                    _mm256_permutevar8x32_epi32( s, reversed_order )
+                    );
+            }
+            sse2::mirror_row( p_source + i, p_destination, n - i );
+        }
+    }  // namespace impl::avx2
+    #endif
+
+    inline auto mirror_row_kernel_for( const Simd_level::Enum level )
+        -> Mirror_row_kernel*
+    {
+        #if SM_IS_X86
+            switch( level ) {
+                case Simd_level::avx2:      return impl::avx2::mirror_row;
+                case Simd_level::sse2:      return impl::sse2::mirror_row;
+                case Simd_level::scalar:    break;
+            }
+        #else
+            (void) level;
+        #endif
+        return impl::scalar::mirror_row;
+    }
+
+    inline auto mirror_row_kernel()
+        -> Mirror_row_kernel*
+    {
+        static Mirror_row_kernel* const the_kernel = mirror_row_kernel_for( sm::simd_level() );
+        return the_kernel;
+    }
+
+    // `destination` must have the same size as `source`, and must not overlap it.
+    inline void mirror_horizontally(
+        in_<Const_bgra_view>        source,
+        in_<Bgra_view>              destination,
+        Mirror_row_kernel* const    mirror_row  = mirror_row_kernel()
+        )
+    {
+        assert( source.width() == destination.width() and source.height() == destination.height() );
+        for( const int y: zero_to( source.height() ) ) {
+            mirror_row( source.row( y ), destination.row( y ), source.width() );
+        }
+    }
+
+    // The rectangle `r` mirrored within `container`, e.g. a frame's bounds within its cell.
+    constexpr auto mirrored_within( in_<Rect> container, in_<Rect> r )
+        -> Rect
+    { return {container.left + (container.right - r.right), r.top, container.left + (container.right - r.left), r.bottom}; }
+
+    class Mirrored_frame_cache
+    {
+        struct Slot
+        {
+            int             i_frame;
+            uint64_t        last_use;
+            Bgra_image      pixels;
+        };
+
+        Const_bgra_view         m_sheet;
+        const Sprite_atlas*     m_p_atlas;
+        int                     m_capacity;
+        vector<int>             m_slot_indices;         // Per frame index, -1 if not cached.
+        vector<Slot>            m_slots;
+        uint64_t                m_n_uses;
+
+        auto new_slot_index()
+            -> int
+        {
+            if( static_cast<int>( m_slots.size() ) < m_capacity ) {
+                m_slots.push_back( Slot{ -1, 0, {} } );
+                return static_cast<int>( m_slots.size() ) - 1;
+            }
+            int i_oldest = 0;
+            for( const int i: zero_to( m_capacity ) ) {
+                if( m_slots[i].last_use < m_slots[i_oldest].last_use ) { i_oldest = i; }
+            }
+            m_slot_indices[m_slots[i_oldest].i_frame] = -1;
+            return i_oldest;
+        }
+
+    public:
+        // The `sheet` pixels and the `atlas` must outlive the cache.
+        Mirrored_frame_cache( in_<Const_bgra_view> sheet, in_<Sprite_atlas> atlas, const int capacity ):
+            m_sheet( sheet ),
+            m_p_atlas( &atlas ),
+            m_capacity( capacity ),
+            m_slot_indices( atlas.n_frames(), -1 ),
+            m_n_uses( 0 )
+        {
+            hopefully( capacity > 0 ) or SM_FAIL( "The mirrored frame cache capacity must be positive." );
+            m_slots.reserve( capacity );
+        }
+
+        auto capacity() const   -> int  { return m_capacity; }
+        auto n_cached() const   -> int  { return static_cast<int>( m_slots.size() ); }
+
+        // The mirrored pixels of the frame's cell. Valid at least until the next call of this function.
+        auto frame_pixels( const int i_frame )
+            -> Const_bgra_view
+        {
+            assert( 0 <= i_frame and i_frame < m_p_atlas->n_frames() );
+            int& i_slot = m_slot_indices[i_frame];
+            if( i_slot < 0 ) {
+                const int i_new_slot = new_slot_index();
+                Slot& slot = m_slots[i_new_slot];
+                const Rect cell = m_p_atlas->frame( i_frame ).cell;
+                if( slot.pixels.width() != width_of( cell ) or slot.pixels.height() != height_of( cell ) ) {
+                    slot.pixels = Bgra_image( width_of( cell ), height_of( cell ) );
+                }
+                mirror_horizontally( m_sheet.part( cell ), slot.pixels.view() );
+                slot.i_frame = i_frame;
+                i_slot = i_new_slot;
+            }
+            Slot& slot = m_slots[i_slot];
+            slot.last_use = ++m_n_uses;
+            return slot.pixels.view();
+        }
+
+        // The frame's non-background bounds in its mirrored cell, in cell coordinates.
+        auto frame_bounds( const int i_frame ) const
+            -> Rect
+        {
+            in_<Sprite_atlas::Frame> frame = m_p_atlas->frame( i_frame );
+            const Rect bounds = mirrored_within( frame.cell, frame.bounds );
+            return offset_by( bounds, -frame.cell.left, -frame.cell.top );
+        }
+    };
+}  // namespace graphics
@@ -0,0 +1,377 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// An index of the frames of a sprite sheet, e.g. the gladiator sheet in "sprites.bmp".
+//
+// The frames are stored as one flat array in animation order, each with its cell rectangle and
+// the trimmed bounds of its non-background pixels, so that drawing frame i of an animation is
+// just an array lookup. Animation names are resolved once to an `Animation` via a hash map.
+//
+// An atlas can be serialized to bytes, e.g. for a binary sidecar file, and restored from them.
+
+#include <microlib/support-machinery.hpp>           // Byte, Byte_span, SM_FAIL, hopefully, zero_to
+#include <microlib/graphics/geometry.hpp>           // Rect, Size
+#include <microlib/graphics/pixels.hpp>             // Bgra_pixel, Const_bgra_view
+
+#include <assert.h>         // assert
+#include <stdint.h>         // uint32_t, int32_t
+#include <stdio.h>          // fopen, fread, fwrite, fclose
+
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::Byte, sm::Byte_span, sm::Index, sm::const_, sm::in_, sm::hopefully, sm::zero_to;
+    using   std::initializer_list,          // <initializer_list>
+            std::optional,
+            std::string, std::to_string,    // <string>
+            std::string_view,
+            std::unordered_map,
+            std::move,                      // <utility>
+            std::vector;
+
+    // A pixel is background if it's fully transparent or has the same color as the color key.
+    inline auto is_background( in_<Bgra_pixel> pixel, in_<Bgra_pixel> color_key )
+        -> bool
+    { return pixel.a == 0 or has_same_rgb( pixel, color_key ); }
+
+    // Bounds of the non-background pixels in the `area` of `pixels`; empty if there are none.
+    inline auto trimmed_bounds_of( in_<Const_bgra_view> pixels, in_<Rect> area, in_<Bgra_pixel> color_key )
+        -> Rect
+    {
+        Rect result = {area.right, area.bottom, area.left, area.top};   // Empty.
+        for( int y = area.top; y < area.bottom; ++y ) {
+            const_<const Bgra_pixel*> p_row = pixels.row( y );
+            for( int x = area.left; x < area.right; ++x ) {
+                if( not is_background( p_row[x], color_key ) ) {
+                    result.left     = min( result.left, x );
+                    result.right    = max( result.right, x + 1 );
+                    result.top      = min( result.top, y );
+                    result.bottom   = max( result.bottom, y + 1 );
+                }
+            }
+        }
+        return (is_empty( result )? Rect{area.left, area.top, area.left, area.top} : result);
+    }
+
+    class Sprite_atlas
+    {
+    public:
+        struct Frame
+        {
+            Rect    cell;           // In sheet coordinates.
+            Rect    bounds;         // Non-background pixels, in sheet coordinates. Possibly empty.
+        };
+
+        struct Animation
+        {
+            int     i_first_frame;
+            int     n_frames;
+        };
+
+    private:
+        Size                            m_sheet_size;
+        vector<Frame>                   m_frames;
+        vector<string>                  m_animation_names;
+        vector<Animation>               m_animations;
+        unordered_map<string, int>      m_animation_ids;
+
+        // An animation has at least one frame, so that e.g. `frame_index` can't divide by zero.
+        void add_animation( string name, in_<Animation> animation )
+        {
+            hopefully( animation.n_frames > 0 )
+                or SM_FAIL( "The sprite animation “" + name + "” has no frames." );
+            const int id = static_cast<int>( m_animations.size() );
+            const bool is_new_name = m_animation_ids.emplace( name, id ).second;
+            hopefully( is_new_name )
+                or SM_FAIL( "Duplicate sprite animation name “" + name + "”." );
+            m_animation_names.push_back( move( name ) );
+            m_animations.push_back( animation );
+        }
+
+        Sprite_atlas( in_<Size> sheet_size ): m_sheet_size( sheet_size ) {}
+
+    public:
+        Sprite_atlas(): m_sheet_size{ 0, 0 } {}
+
+        // Each row of the fixed grid of `cell_size` cells is one animation, named by `row_names`.
+        // The frames of a row are its leading cells with non-background pixels.
+        static auto from_grid(
+            in_<Const_bgra_view>                    sheet,
+            in_<Size>                               cell_size,
+            in_<Bgra_pixel>                         color_key,
+            const initializer_list<string_view>     row_names
+            ) -> Sprite_atlas
+        {
+            hopefully( cell_size.w > 0 and cell_size.h > 0 )
+                or SM_FAIL( "Invalid sprite cell size." );
+            const int n_columns     = sheet.width()/cell_size.w;
+            const int n_rows        = sheet.height()/cell_size.h;
+            hopefully( int( row_names.size() ) <= n_rows )
+                or SM_FAIL( "More sprite animation names than sheet rows." );
+
+            auto result = Sprite_atlas( Size{ sheet.width(), sheet.height() } );
+            int i_row = 0;
+            for( const string_view name: row_names ) {
+                const int i_first_frame = static_cast<int>( result.m_frames.size() );
+                for( const int i_column: zero_to( n_columns ) ) {
+                    const Rect cell = rect_at( {i_column*cell_size.w, i_row*cell_size.h}, cell_size );
+                    const Rect bounds = trimmed_bounds_of( sheet, cell, color_key );
+                    if( is_empty( bounds ) ) {
+                        break;
+                    }
+                    result.m_frames.push_back( Frame{ cell, bounds } );
+                }
+                const int n_frames = static_cast<int>( result.m_frames.size() ) - i_first_frame;
+                result.add_animation( string( name ), Animation{ i_first_frame, n_frames } );
+                ++i_row;
+            }
+            return result;
+        }
+
+        // Detects horizontal bands of non-background rows, and within each band the runs of
+        // non-background columns. Runs separated by less than `min_gap` background columns are
+        // joined, which keeps e.g. a detached weapon pixel with its figure. Each band is one
+        // animation named by `row_names`, and each run in it is one frame, with the run's
+        // bounds as both cell and trimmed bounds. Best for sheets with irregular frame sizes.
+        static auto from_separators(
+            in_<Const_bgra_view>                    sheet,
+            in_<Bgra_pixel>                         color_key,
+            const initializer_list<string_view>     row_names,
+            const int                               min_gap = 2
+            ) -> Sprite_atlas
+        {
+            const auto is_background_row = [&]( const int y, const int x_first, const int x_beyond ) -> bool
+            {
+                const_<const Bgra_pixel*> p_row = sheet.row( y );
+                for( int x = x_first; x < x_beyond; ++x ) {
+                    if( not is_background( p_row[x], color_key ) ) { return false; }
+                }
+                return true;
+            };
+            const auto is_background_column = [&]( const int x, const int y_first, const int y_beyond ) -> bool
+            {
+                for( int y = y_first; y < y_beyond; ++y ) {
+                    if( not is_background( sheet( x, y ), color_key ) ) { return false; }
+                }
+                return true;
+            };
+
+            auto result = Sprite_atlas( Size{ sheet.width(), sheet.height() } );
+            auto it_name = row_names.begin();
+            int y = 0;
+            while( it_name != row_names.end() ) {
+                while( y < sheet.height() and is_background_row( y, 0, sheet.width() ) ) { ++y; }
+                hopefully( y < sheet.height() )
+                    or SM_FAIL( "Fewer sprite bands in the sheet than animation names." );
+                const int y_band_first = y;
+                while( y < sheet.height() and not is_background_row( y, 0, sheet.width() ) ) { ++y; }
+                const int y_band_beyond = y;
+
+                const int i_first_frame = static_cast<int>( result.m_frames.size() );
+                int x = 0;
+                for( ;; ) {
+                    while( x < sheet.width() and is_background_column( x, y_band_first, y_band_beyond ) ) { ++x; }
+                    if( x == sheet.width() ) {
+                        break;
+                    }
+                    const int x_run_first = x;
+                    int x_run_beyond = x;
+                    for( int n_gap = 0; x < sheet.width() and n_gap < min_gap; ++x ) {
+                        if( is_background_column( x, y_band_first, y_band_beyond ) ) {
+                            ++n_gap;
+                        } else {
+                            n_gap = 0;  x_run_beyond = x + 1;
+                        }
+                    }
+                    x = x_run_beyond;
+                    const Rect bounds = trimmed_bounds_of(
+                        sheet, Rect{ x_run_first, y_band_first, x_run_beyond, y_band_beyond }, color_key
+                        );
+                    result.m_frames.push_back( Frame{ bounds, bounds } );
+                }
+                const int n_frames = static_cast<int>( result.m_frames.size() ) - i_first_frame;
+                result.add_animation( string( *it_name ), Animation{ i_first_frame, n_frames } );
+                ++it_name;
+            }
+            return result;
+        }
+
+        auto sheet_size() const     -> Size                 { return m_sheet_size; }
+        auto n_frames() const       -> int                  { return static_cast<int>( m_frames.size() ); }
+        auto frames() const         -> const vector<Frame>& { return m_frames; }
+        auto n_animations() const   -> int                  { return static_cast<int>( m_animations.size() ); }
+
+        auto has_animation( in_<string> name ) const
+            -> bool
+        { return m_animation_ids.count( name ) > 0; }
+
+        auto animation( in_<string> name ) const
+            -> Animation
+        {
+            const auto it = m_animation_ids.find( name );
+            hopefully( it != m_animation_ids.end() )
+                or SM_FAIL( "No sprite animation named “" + name + "”." );
+            return m_animations[it->second];
+        }
+
+        auto animation_name( const int id ) const
+            -> const string&
+        { return m_animation_names.at( id ); }
+
+        // Frame numbers wrap around, so that a tick counter can be used directly.
+        auto frame_index( in_<Animation> animation, const int frame_number ) const
+            -> int
+        {
+            assert( animation.n_frames > 0 and frame_number >= 0 );
+            return animation.i_first_frame + frame_number % animation.n_frames;
+        }
+
+        auto frame( in_<Animation> animation, const int frame_number ) const
+            -> const Frame&
+        { return m_frames[frame_index( animation, frame_number )]; }
+
+        auto frame( const int i ) const
+            -> const Frame&
+        { return m_frames[i]; }
+
+
+        //------------------------------------------- Serialization:
+
+        static constexpr char       magic[]         = "SPRATLAS";
+        static constexpr uint32_t   format_version  = 1;
+
+        // Little-endian binary form: magic, version, sheet size, frames, then animations as
+        // (name length, name bytes, first frame index, number of frames).
+        auto to_bytes() const
+            -> vector<Byte>
+        {
+            vector<Byte> result( magic, magic + sizeof( magic ) - 1 );
+            const auto add_u32 = [&]( const uint32_t v )
+            {
+                for( const int i: zero_to( 4 ) ) { result.push_back( Byte( v >> (8*i) ) ); }
+            };
+            const auto add_i32 = [&]( const int v ) { add_u32( static_cast<uint32_t>( v ) ); };
+            const auto add_rect = [&]( in_<Rect> r )
+            {
+                add_i32( r.left );  add_i32( r.top );  add_i32( r.right );  add_i32( r.bottom );
+            };
+
+            add_u32( format_version );
+            add_i32( m_sheet_size.w );  add_i32( m_sheet_size.h );
+            add_i32( n_frames() );
+            for( in_<Frame> frame: m_frames ) { add_rect( frame.cell );  add_rect( frame.bounds ); }
+            add_i32( n_animations() );
+            for( const int id: zero_to( n_animations() ) ) {
+                in_<string> name = m_animation_names[id];
+                add_i32( static_cast<int>( name.size() ) );
+                result.insert( result.end(), name.begin(), name.end() );
+                add_i32( m_animations[id].i_first_frame );  add_i32( m_animations[id].n_frames );
+            }
+            return result;
+        }
+
+        // `expected_sheet_size` guards against a stale sidecar for a changed sheet.
+        static auto from_bytes( in_<Byte_span> bytes, in_<Size> expected_sheet_size )
+            -> Sprite_atlas
+        {
+            Index i = 0;
+            const auto need = [&]( const Index n )
+            {
+                hopefully( i + n <= bytes.size() ) or SM_FAIL( "Truncated sprite atlas data." );
+            };
+            const auto next_u32 = [&]() -> uint32_t
+            {
+                need( 4 );
+                uint32_t result = 0;
+                for( const int j: zero_to( 4 ) ) { result |= uint32_t( bytes[i + j] ) << (8*j); }
+                i += 4;
+                return result;
+            };
+            const auto next_i32 = [&]() -> int { return static_cast<int32_t>( next_u32() ); };
+            const auto next_count = [&]() -> int
+            {
+                const int n = next_i32();
+                hopefully( 0 <= n and n <= bytes.size() - i ) or SM_FAIL( "Invalid count in sprite atlas data." );
+                return n;
+            };
+            const auto next_rect = [&]() -> Rect
+            {
+                const int left = next_i32();  const int top = next_i32();
+                const int right = next_i32();  const int bottom = next_i32();
+                return {left, top, right, bottom};
+            };
+
+            need( sizeof( magic ) - 1 );
+            hopefully( string_view( reinterpret_cast<const char*>( bytes.data() ), sizeof( magic ) - 1 ) == magic )
+                or SM_FAIL( "Not sprite atlas data." );
+            i += sizeof( magic ) - 1;
+            hopefully( next_u32() == format_version )
+                or SM_FAIL( "Unsupported sprite atlas data format version." );
+            const int sheet_width = next_i32();  const int sheet_height = next_i32();
+            hopefully( sheet_width == expected_sheet_size.w and sheet_height == expected_sheet_size.h )
+                or SM_FAIL( "The sprite atlas data is for a different sheet size." );
+
+            auto result = Sprite_atlas( Size{ sheet_width, sheet_height } );
+            const Rect sheet_rect = {0, 0, sheet_width, sheet_height};
+            const int n_frames = next_count();
+            result.m_frames.reserve( n_frames );
+            while( result.n_frames() < n_frames ) {
+                const Rect cell = next_rect();  const Rect bounds = next_rect();
+                hopefully( not is_empty( cell ) and contains( sheet_rect, cell ) and contains( cell, bounds ) )
+                    or SM_FAIL( "Sprite atlas frame outside of the sheet." );
+                result.m_frames.push_back( Frame{ cell, bounds } );
+            }
+            const int n_animations = next_count();
+            while( result.n_animations() < n_animations ) {
+                const int name_length = next_count();
+                auto name = string( reinterpret_cast<const char*>( bytes.data() + i ), name_length );
+                i += name_length;
+                const int i_first_frame = next_i32();  const int n_animation_frames = next_i32();
+                hopefully( 0 <= i_first_frame and i_first_frame <= n_frames
+                    and 0 <= n_animation_frames and n_animation_frames <= n_frames - i_first_frame
+                    ) or SM_FAIL( "Sprite atlas animation frames out of range." );
+                result.add_animation( move( name ), Animation{ i_first_frame, n_animation_frames } );
+            }
+            return result;
+        }
+    };
+
+    //------------------------------------------- Sidecar file:
+
+    inline void save_sidecar( in_<Sprite_atlas> atlas, const sm::C_string_ptr path )
+    {
+        const vector<Byte> bytes = atlas.to_bytes();
+        FILE* const f = fopen( path, "wb" );
+        hopefully( f != nullptr )
+            or SM_FAIL( string() + "Failed to open “" + path + "” for writing." );
+        const size_t n_written = fwrite( bytes.data(), 1, bytes.size(), f );
+        const bool closed_ok = (fclose( f ) == 0);
+        hopefully( n_written == bytes.size() and closed_ok )
+            or SM_FAIL( string() + "Failed to write “" + path + "”." );
+    }
+
+    // Empty if there's no such file, e.g. on first run. Throws if the file is invalid or stale.
+    inline auto load_sidecar( const sm::C_string_ptr path, in_<Size> expected_sheet_size )
+        -> optional<Sprite_atlas>
+    {
+        FILE* const f = fopen( path, "rb" );
+        if( not f ) {
+            return {};
+        }
+        vector<Byte> bytes;
+        Byte buffer[4096];
+        while( const size_t n = fread( buffer, 1, sizeof( buffer ), f ) ) {
+            bytes.insert( bytes.end(), buffer, buffer + n );
+        }
+        fclose( f );
+        return Sprite_atlas::from_bytes(
+            Byte_span( bytes.data(), static_cast<Index>( bytes.size() ) ), expected_sheet_size
+            );
+    }
+}  // namespace graphics
@@ -0,0 +1,343 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Software blitting between 32bpp pixel views: opaque copy, color keyed copy and source-over
+// alpha blending, each optionally with integer (nearest neighbor) scaling.
+//
+// The per-row work is done by kernels with SSE2 and AVX2 versions and a scalar fallback; the
+// best version for the CPU is selected at first use. All versions produce identical results.
+// Blending uses straight, i.e. not premultiplied, source alpha:
+//
+//      result = (source·α + destination·(255 - α))/255, rounded,
+//
+// with the source's own alpha channel value taken as 255, which gives the result alpha
+// α + destination_α·(1 - α).
+
+#include <microlib/support-machinery.hpp>                   // in_, zero_to
+#include <microlib/support-machinery/cpu-features.hpp>      // Simd_level, simd_level, SM_TARGET_AVX2
+#include <microlib/graphics/geometry.hpp>                   // Point, Rect
+#include <microlib/graphics/pixels.hpp>                     // Bgra_pixel, Bgra_view, Const_bgra_view
+
+#include <assert.h>         // assert
+#include <stdint.h>         // uint32_t
+#include <string.h>         // memcpy
+
+#include <algorithm>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::const_, sm::in_, sm::zero_to, sm::Simd_level;
+    using   std::min, std::max;         // <algorithm>
+
+    // Bgra pixels as little-endian 32-bit values, as loaded into SIMD registers.
+    constexpr uint32_t  rgb_bits    = 0x00FF'FFFF;
+    constexpr uint32_t  alpha_bits  = 0xFF00'0000;
+
+    inline auto bits_of( in_<Bgra_pixel> pixel )
+        -> uint32_t
+    { return pixel.b | (pixel.g << 8) | (pixel.r << 16) | (uint32_t( pixel.a ) << 24); }
+
+    struct Blit_row_kernels
+    {
+        // Each processes `n` pixels; `p_source` and `p_destination` don't overlap.
+        void (*copy_color_keyed)( const Bgra_pixel* p_source, Bgra_pixel* p_destination, int n, Bgra_pixel key );
+        void (*blend_over)( const Bgra_pixel* p_source, Bgra_pixel* p_destination, int n );
+    };
+
+    namespace impl::scalar {
+        inline auto blended( const int s, const int d, const int alpha )
+            -> Byte
+        {
+            const int t = s*alpha + d*(255 - alpha) + 128;
+            return static_cast<Byte>( (t + (t >> 8)) >> 8 );   // Exact rounded division by 255.
+        }
+
+        inline void copy_color_keyed( const Bgra_pixel* p_source, Bgra_pixel* p_destination, const int n, const Bgra_pixel key )
+        {
+            for( const int i: zero_to( n ) ) {
+                const Bgra_pixel s = p_source[i];
+                if( not( s.a == 0 or has_same_rgb( s, key ) ) ) { p_destination[i] = s; }
+            }
+        }
+
+        inline void blend_over( const Bgra_pixel* p_source, Bgra_pixel* p_destination, const int n )
+        {
+            for( const int i: zero_to( n ) ) {
+                const Bgra_pixel s = p_source[i];
+                Bgra_pixel& d = p_destination[i];
+                d = Bgra_pixel{
+                    blended( s.b, d.b, s.a ), blended( s.g, d.g, s.a ), blended( s.r, d.r, s.a ),
+                    blended( 255, d.a, s.a )
+                    };
+            }
+        }
+    }  // namespace impl::scalar
+
+    #if SM_IS_X86
+    namespace impl::sse2 {
+        SM_TARGET_SSE2 inline auto keyed_mask( const __m128i s, const __m128i key_rgb )
+            -> __m128i      // All ones for the pixels that are not to be copied.
+        {
+            const __m128i rgb   = _mm_and_si128( s, _mm_set1_epi32( rgb_bits ) );
+            const __m128i alpha = _mm_and_si128( s, _mm_set1_epi32( int( alpha_bits ) ) );
+            return _mm_or_si128(
+                _mm_cmpeq_epi32( rgb, key_rgb ), _mm_cmpeq_epi32( alpha, _mm_setzero_si128() )
+                );
+        }
+
+        SM_TARGET_SSE2 inline void copy_color_keyed(
+            const Bgra_pixel* p_source, Bgra_pixel* p_destination, const int n, const Bgra_pixel key
+            )
+        {
+            const __m128i key_rgb = _mm_set1_epi32( bits_of( key ) & rgb_bits );
+            int i = 0;
+            for( ; i + 4 <= n; i += 4 ) {
+                const auto p_s = reinterpret_cast<const __m128i*>( p_source + i );
+                const auto p_d = reinterpret_cast<__m128i*>( p_destination + i );
+                const __m128i s         = _mm_loadu_si128( p_s );
+                const __m128i skipped   = keyed_mask( s, key_rgb );
+                const int     bits      = _mm_movemask_epi8( skipped );
+                if( bits == 0xFFFF ) {
+                    continue;       // All background, the common case for sprite margins.
+                } else if( bits == 0 ) {
+                    _mm_storeu_si128( p_d, s );
+                } else {
+                    const __m128i d = _mm_loadu_si128( p_d );
+                    _mm_storeu_si128( p_d, _mm_or_si128( _mm_andnot_si128( skipped, s ), _mm_and_si128( skipped, d ) ) );
+                }
+            }
+            scalar::copy_color_keyed( p_source + i, p_destination + i, n - i, key );
+        }
+
+        // 2 pixels as 8 16-bit lanes.
+        SM_TARGET_SSE2 inline auto blended( const __m128i s, const __m128i d, const __m128i alpha )
+            -> __m128i
+        {
+            const __m128i inv_alpha = _mm_sub_epi16( _mm_set1_epi16( 255 ), alpha );
+            const __m128i t = _mm_add_epi16(
+                _mm_add_epi16( _mm_mullo_epi16( s, alpha ), _mm_mullo_epi16( d, inv_alpha ) ),
+                _mm_set1_epi16( 128 )
+                );
+            return _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+        }
+
+        SM_TARGET_SSE2 inline auto broadcast_alpha( const __m128i pixels_16 )
+            -> __m128i
+        { return _mm_shufflehi_epi16( _mm_shufflelo_epi16( pixels_16, 0xFF ), 0xFF ); }
+
+        SM_TARGET_SSE2 inline void blend_over( const Bgra_pixel* p_source, Bgra_pixel* p_destination, const int n )
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i full_alpha = _mm_set1_epi32( int( alpha_bits ) );
+            int i = 0;
+            for( ; i + 4 <= n; i += 4 ) {
+                const auto p_s = reinterpret_cast<const __m128i*>( p_source + i );
+                const auto p_d = reinterpret_cast<__m128i*>( p_destination + i );
+                const __m128i s = _mm_loadu_si128( p_s );
+                const int alpha_bytes = _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( s, full_alpha ), zero ) );
+                if( alpha_bytes == 0xFFFF ) {
+                    continue;       // All transparent.
+                }
+                const __m128i d = _mm_loadu_si128( p_d );
+                const __m128i s_opaque = _mm_or_si128( s, full_alpha );
+                const __m128i lo = blended(
+                    _mm_unpacklo_epi8( s_opaque, zero ), _mm_unpacklo_epi8( d, zero ),
+                    broadcast_alpha( _mm_unpacklo_epi8( s, zero ) )
+                    );
+                const __m128i hi = blended(
+                    _mm_unpackhi_epi8( s_opaque, zero ), _mm_unpackhi_epi8( d, zero ),
+                    broadcast_alpha( _mm_unpackhi_epi8( s, zero ) )
+                    );
+                _mm_storeu_si128( p_d, _mm_packus_epi16( lo, hi ) );
+            }
+            scalar::blend_over( p_source + i, p_destination + i, n - i );
+        }
+    }  // namespace impl::sse2
+
+    namespace impl::avx2 {
+        SM_TARGET_AVX2 inline void copy_color_keyed(
+            const Bgra_pixel* p_source, Bgra_pixel* p_destination, const int n, const Bgra_pixel key
+            )
+        {
+            const __m256i key_rgb       = _mm256_set1_epi32( bits_of( key ) & rgb_bits );
+            const __m256i rgb_mask      = _mm256_set1_epi32( rgb_bits );
+            const __m256i alpha_mask    = _mm256_set1_epi32( int( alpha_bits ) );
+            int i = 0;
+            for( ; i + 8 <= n; i += 8 ) {
+                const auto p_s = reinterpret_cast<const __m256i*>( p_source + i );
+                const auto p_d = reinterpret_cast<__m256i*>( p_destination + i );
+                const __m256i s = _mm256_loadu_si256( p_s );
+                const __m256i skipped = _mm256_or_si256(
+                    _mm256_cmpeq_epi32( _mm256_and_si256( s, rgb_mask ), key_rgb ),
+                    _mm256_cmpeq_epi32( _mm256_and_si256( s, alpha_mask ), _mm256_setzero_si256() )
+                    );
+                const int bits = _mm256_movemask_epi8( skipped );
+                if( bits == -1 ) {
+                    continue;
+                } else if( bits == 0 ) {
+                    _mm256_storeu_si256( p_d, s );
+                } else {
+                    _mm256_storeu_si256( p_d, _mm256_blendv_epi8( s, _mm256_loadu_si256( p_d ), skipped ) );
+                }
+            }
+            sse2::copy_color_keyed( p_source + i, p_destination + i, n - i, key );
+        }
+
+        SM_TARGET_AVX2 inline auto blended( const __m256i s, const __m256i d, const __m256i alpha )
+            -> __m256i
+        {
+            const __m256i inv_alpha = _mm256_sub_epi16( _mm256_set1_epi16( 255 ), alpha );
+            const __m256i t = _mm256_add_epi16(
+                _mm256_add_epi16( _mm256_mullo_epi16( s, alpha ), _mm256_mullo_epi16( d, inv_alpha ) ),
+                _mm256_set1_epi16( 128 )
+                );
+            return _mm256_srli_epi16( _mm256_add_epi16( t, _mm256_srli_epi16( t, 8 ) ), 8 );
+        }
+
+        SM_TARGET_AVX2 inline auto broadcast_alpha( const __m256i pixels_16 )
+            -> __m256i
+        { return _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( pixels_16, 0xFF ), 0xFF ); }
+
+        SM_TARGET_AVX2 inline void blend_over( const Bgra_pixel* p_source, Bgra_pixel* p_destination, const int n )
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i full_alpha = _mm256_set1_epi32( int( alpha_bits ) );
+            int i = 0;
+            for( ; i + 8 <= n; i += 8 ) {
+                const auto p_s = reinterpret_cast<const __m256i*>( p_source + i );
+                const auto p_d = reinterpret_cast<__m256i*>( p_destination + i );
+                const __m256i s = _mm256_loadu_si256( p_s );
+                const int alpha_bytes = _mm256_movemask_epi8(
+                    _mm256_cmpeq_epi32( _mm256_and_si256( s, full_alpha ), zero )
+                    );
+                if( alpha_bytes == -1 ) {
+                    continue;
+                }
+                const __m256i d = _mm256_loadu_si256( p_d );
+                const __m256i s_opaque = _mm256_or_si256( s, full_alpha );
+                // The unpacking and packing both work within 128-bit lanes, so the order is preserved.
+                const __m256i lo = blended(
+                    _mm256_unpacklo_epi8( s_opaque, zero ), _mm256_unpacklo_epi8( d, zero ),
+                    broadcast_alpha( _mm256_unpacklo_epi8( s, zero ) )
+                    );
+                const __m256i hi = blended(
+                    _mm256_unpackhi_epi8( s_opaque, zero ), _mm256_unpackhi_epi8( d, zero ),
+                    broadcast_alpha( _mm256_unpackhi_epi8( s, zero ) )
+                    );
+                _mm256_storeu_si256( p_d, _mm256_packus_epi16( lo, hi ) );
+            }
+            sse2::blend_over( p_source + i, p_destination + i, n - i );
+        }
+    }  // namespace impl::avx2
+    #endif
+
+    inline auto blit_row_kernels_for( const Simd_level::Enum level )
+        -> const Blit_row_kernels&
+    {
+        static const Blit_row_kernels scalar_kernels = { impl::scalar::copy_color_keyed, impl::scalar::blend_over };
+        #if SM_IS_X86
+            static const Blit_row_kernels sse2_kernels = { impl::sse2::copy_color_keyed, impl::sse2::blend_over };
+            static const Blit_row_kernels avx2_kernels = { impl::avx2::copy_color_keyed, impl::avx2::blend_over };
+            switch( level ) {
+                case Simd_level::avx2:      return avx2_kernels;
+                case Simd_level::sse2:      return sse2_kernels;
+                case Simd_level::scalar:    break;
+            }
+        #else
+            (void) level;
+        #endif
+        return scalar_kernels;
+    }
+
+    inline auto blit_row_kernels()
+        -> const Blit_row_kernels&
+    {
+        static const Blit_row_kernels& the_kernels = blit_row_kernels_for( sm::simd_level() );
+        return the_kernels;
+    }
+
+    struct Blit_mode
+    {
+        enum Kind: int { opaque, color_keyed, alpha_blended };
+
+        Kind            kind;
+        Bgra_pixel      color_key;
+
+        static constexpr auto opaque_copy()                             -> Blit_mode { return {opaque, {}}; }
+        static constexpr auto with_color_key( in_<Bgra_pixel> key )     -> Blit_mode { return {color_keyed, key}; }
+        static constexpr auto alpha_blending()                          -> Blit_mode { return {alpha_blended, {}}; }
+    };
+
+    namespace impl {
+        inline void blit_row(
+            in_<Blit_row_kernels>       kernels,
+            in_<Blit_mode>              mode,
+            const Bgra_pixel*           p_source,
+            Bgra_pixel*                 p_destination,
+            const int                   n
+            )
+        {
+            switch( mode.kind ) {
+                case Blit_mode::opaque:         { memcpy( p_destination, p_source, n*sizeof( Bgra_pixel ) );  break; }
+                case Blit_mode::color_keyed:    { kernels.copy_color_keyed( p_source, p_destination, n, mode.color_key );  break; }
+                case Blit_mode::alpha_blended:  { kernels.blend_over( p_source, p_destination, n );  break; }
+            }
+        }
+    }  // namespace impl
+
+    // Draws `source` scaled by `scale` with its upper left corner at `position` in `destination`,
+    // clipped to the destination. Returns the destination rectangle that was drawn to.
+    inline auto blit(
+        in_<Const_bgra_view>        source,
+        in_<Bgra_view>              destination,
+        in_<Point>                  position,
+        in_<Blit_mode>              mode,
+        const int                   scale       = 1,
+        in_<Blit_row_kernels>       kernels     = blit_row_kernels()
+        ) -> Rect
+    {
+        assert( scale >= 1 );
+        const Rect full_area = {
+            position.x, position.y, position.x + scale*source.width(), position.y + scale*source.height()
+            };
+        const Rect area = intersection_of( full_area, destination.bounds() );
+        if( is_empty( area ) ) {
+            return Rect{ 0, 0, 0, 0 };
+        }
+
+        // Offsets into the scaled source image of the clipped area's upper left pixel.
+        const int dx = area.left - full_area.left;
+        const int dy = area.top - full_area.top;
+        const int width = width_of( area );
+
+        if( scale == 1 ) {
+            for( const int y: zero_to( height_of( area ) ) ) {
+                impl::blit_row( kernels, mode,
+                    source.row( dy + y ) + dx, destination.row( area.top + y ) + area.left, width
+                    );
+            }
+            return area;
+        }
+
+        // With scaling each stretch of a source row is expanded once into a buffer, that's then
+        // used for all the `scale` destination rows that the source row maps to.
+        constexpr int buffer_size = 256;
+        Bgra_pixel expanded[buffer_size];
+        for( const sm::Interval chunk: zero_to( width ).chunked( buffer_size ) ) {
+            const int x_chunk = chunk.first;
+            const int n = chunk.length();
+            int i_expanded_row = -1;
+            for( const int y: zero_to( height_of( area ) ) ) {
+                const int i_source_row = (dy + y)/scale;
+                if( i_source_row != i_expanded_row ) {
+                    const_<const Bgra_pixel*> p_source_row = source.row( i_source_row );
+                    for( const int i: zero_to( n ) ) {
+                        expanded[i] = p_source_row[(dx + x_chunk + i)/scale];
+                    }
+                    i_expanded_row = i_source_row;
+                }
+                impl::blit_row( kernels, mode, expanded, destination.row( area.top + y ) + area.left + x_chunk, n );
+            }
+        }
+        return area;
+    }
+}  // namespace graphics
@@ -0,0 +1,189 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Decoding of uncompressed 24 and 32 bpp BMP images directly from bytes in memory, e.g. a
+// memory mapped file or a Windows `RT_BITMAP` resource. The latter has no `BITMAPFILEHEADER`.
+// Supported DIB headers: `BITMAPINFOHEADER` (also with bit field masks), V4 and V5.
+// The pixels are not copied: the result refers to the given bytes, which must outlive it.
+
+#include <microlib/support-machinery.hpp>           // Byte_span, SM_FAIL, hopefully
+#include <microlib/graphics/pixels.hpp>             // Const_bgr_view, Const_bgra_view, Bgra_image
+
+#include <assert.h>         // assert
+#include <stdint.h>         // uint32_t, int32_t
+
+#include <string>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::Byte, sm::Byte_span, sm::Index, sm::in_, sm::hopefully;
+    using   std::to_string;             // <string>
+
+    struct Bmp_format{ enum Enum: int { bgr_24, bgra_32 }; };
+
+    class Bmp_view
+    {
+        Bmp_format::Enum    m_format;
+        bool                m_has_alpha;
+        int                 m_width;
+        int                 m_height;
+        const Byte*         m_p_top_row;
+        Index               m_row_stride;       // In bytes, negative for bottom-up storage.
+
+    public:
+        Bmp_view():
+            m_format( Bmp_format::bgra_32 ), m_has_alpha( false ),
+            m_width( 0 ), m_height( 0 ), m_p_top_row( nullptr ), m_row_stride( 0 )
+        {}
+
+        Bmp_view(
+            const Bmp_format::Enum      format,
+            const bool                  has_alpha,
+            const int                   width,
+            const int                   height,
+            const Byte* const           p_top_row,
+            const Index                 row_stride
+            ):
+            m_format( format ), m_has_alpha( has_alpha ),
+            m_width( width ), m_height( height ), m_p_top_row( p_top_row ), m_row_stride( row_stride )
+        {}
+
+        auto format() const     -> Bmp_format::Enum     { return m_format; }
+        auto has_alpha() const  -> bool                 { return m_has_alpha; }
+        auto width() const      -> int                  { return m_width; }
+        auto height() const     -> int                  { return m_height; }
+
+        auto bgr_pixels() const
+            -> Const_bgr_view
+        {
+            assert( m_format == Bmp_format::bgr_24 );
+            return Const_bgr_view(
+                reinterpret_cast<const Bgr_pixel*>( m_p_top_row ), m_width, m_height, m_row_stride
+                );
+        }
+
+        auto bgra_pixels() const
+            -> Const_bgra_view
+        {
+            assert( m_format == Bmp_format::bgra_32 );
+            return Const_bgra_view(
+                reinterpret_cast<const Bgra_pixel*>( m_p_top_row ), m_width, m_height, m_row_stride
+                );
+        }
+    };
+
+    namespace impl {
+        // BMP fields are little-endian and generally not aligned, so they're assembled bytewise.
+        inline auto u16_at( in_<Byte_span> bytes, const Index i )
+            -> uint32_t
+        { return bytes[i] | (uint32_t( bytes[i + 1] ) << 8); }
+
+        inline auto u32_at( in_<Byte_span> bytes, const Index i )
+            -> uint32_t
+        { return u16_at( bytes, i ) | (u16_at( bytes, i + 2 ) << 16); }
+
+        inline auto i32_at( in_<Byte_span> bytes, const Index i )
+            -> int32_t
+        { return static_cast<int32_t>( u32_at( bytes, i ) ); }
+
+        constexpr uint32_t  bi_rgb              = 0;        // Values of the `biCompression` field.
+        constexpr uint32_t  bi_bitfields        = 3;
+        constexpr uint32_t  bi_alphabitfields   = 6;
+
+        constexpr Index     file_header_size    = 14;       // sizeof( BITMAPFILEHEADER )
+        constexpr Index     info_header_size    = 40;       // sizeof( BITMAPINFOHEADER )
+    }  // namespace impl
+
+    inline auto parse_bmp( in_<Byte_span> bytes )
+        -> Bmp_view
+    {
+        using namespace impl;
+
+        const bool has_file_header = (bytes.size() >= file_header_size and bytes[0] == 'B' and bytes[1] == 'M');
+        const Byte_span dib = (has_file_header? bytes.from( file_header_size ) : bytes);
+
+        hopefully( dib.size() >= info_header_size )
+            or SM_FAIL( "Too few bytes for a BMP image header." );
+        const auto  header_size     = Index( u32_at( dib, 0 ) );
+        const int   width           = i32_at( dib, 4 );
+        const int   signed_height   = i32_at( dib, 8 );
+        const auto  bits_per_pixel  = u16_at( dib, 14 );
+        const auto  compression     = u32_at( dib, 16 );
+        const auto  n_colors_used   = u32_at( dib, 32 );
+
+        hopefully( header_size >= info_header_size and header_size <= dib.size() )
+            or SM_FAIL( "Unsupported BMP header size " + to_string( header_size ) + "." );
+        hopefully( u16_at( dib, 12 ) == 1 )
+            or SM_FAIL( "Invalid number of BMP color planes." );
+        hopefully( bits_per_pixel == 24 or bits_per_pixel == 32 )
+            or SM_FAIL( "Unsupported BMP pixel size " + to_string( bits_per_pixel ) + " bits." );
+        hopefully( compression == bi_rgb or (bits_per_pixel == 32 and
+                (compression == bi_bitfields or compression == bi_alphabitfields))
+            ) or SM_FAIL( "Unsupported BMP compression " + to_string( compression ) + "." );
+        hopefully( width > 0 and signed_height != 0 and signed_height != INT32_MIN )
+            or SM_FAIL( "Invalid BMP image size." );
+
+        // With a `BITMAPINFOHEADER` the channel masks, if any, follow the header; V4 and V5 have them inside.
+        const Index n_trailing_mask_bytes = (header_size > info_header_size? 0
+            : compression == bi_bitfields?      12
+            : compression == bi_alphabitfields? 16
+            : 0
+            );
+        bool has_alpha = false;
+        if( compression != bi_rgb ) {
+            const Index i_masks = info_header_size;
+            hopefully( i_masks + 12 <= dib.size() )
+                or SM_FAIL( "Too few bytes for the BMP channel masks." );
+            hopefully( u32_at( dib, i_masks ) == 0x00FF0000
+                and u32_at( dib, i_masks + 4 ) == 0x0000FF00
+                and u32_at( dib, i_masks + 8 ) == 0x000000FF
+                ) or SM_FAIL( "Unsupported BMP channel masks (only BGRA byte order is supported)." );
+            const bool has_alpha_mask = (header_size >= 56 or compression == bi_alphabitfields);
+            if( has_alpha_mask ) {
+                hopefully( i_masks + 16 <= dib.size() )
+                    or SM_FAIL( "Too few bytes for the BMP alpha channel mask." );
+                const uint32_t alpha_mask = u32_at( dib, i_masks + 12 );
+                hopefully( alpha_mask == 0 or alpha_mask == 0xFF000000 )
+                    or SM_FAIL( "Unsupported BMP alpha channel mask." );
+                has_alpha = (alpha_mask != 0);
+            }
+        }
+
+        const Index i_pixels = (has_file_header
+            ? Index( u32_at( bytes, 10 ) ) - file_header_size
+            : header_size + n_trailing_mask_bytes + 4*Index( n_colors_used )
+            );
+        const bool  is_bottom_up    = (signed_height > 0);
+        const int   height          = (is_bottom_up? signed_height : -signed_height);
+        const Index row_size        = 4*((Index( width )*bits_per_pixel + 31)/32);     // Rows are 4-byte aligned.
+        // Checked by division, since `row_size*height` can overflow for a hostile header.
+        hopefully( i_pixels >= header_size and i_pixels <= dib.size()
+            and height <= (dib.size() - i_pixels)/row_size
+            ) or SM_FAIL( "Too few bytes for the BMP pixel data." );
+
+        const Byte* const p_first_stored_row = dib.data() + i_pixels;
+        return Bmp_view(
+            (bits_per_pixel == 24? Bmp_format::bgr_24 : Bmp_format::bgra_32),
+            has_alpha,
+            width, height,
+            (is_bottom_up? p_first_stored_row + (height - 1)*row_size : p_first_stored_row),
+            (is_bottom_up? -row_size : row_size)
+            );
+    }
+
+    // Copies the pixels to a top-down 32bpp image. Pixels without alpha get alpha 0xFF.
+    inline auto to_bgra_image( in_<Bmp_view> bmp )
+        -> Bgra_image
+    {
+        if( bmp.format() == Bmp_format::bgr_24 ) {
+            return to_bgra_image( bmp.bgr_pixels() );
+        }
+        Bgra_image result = to_bgra_image( bmp.bgra_pixels() );
+        if( not bmp.has_alpha() ) {
+            const Bgra_view pixels = result.view();
+            for( const int y: sm::zero_to( pixels.height() ) ) {
+                for( const int x: sm::zero_to( pixels.width() ) ) { pixels( x, y ).a = 0xFF; }
+            }
+        }
+        return result;
+    }
+}  // namespace graphics
@@ -0,0 +1,110 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Child controls of a form described as data, placed by a simple flow layout, and created in
+// one batch by a backend, e.g. the Windows API one in `winapi++/gui.hpp` or a mock for testing.
+//
+// A control without an explicit position is placed to the right of the previous flowed one, or
+// at the start of a new row when it doesn't fit in the layout area or asks for a new row.
+
+#include <microlib/graphics/geometry.hpp>       // Point, Size, Rect, rect_at, bounding_rect_of
+#include <microlib/support-machinery.hpp>       // in_, C_string_ptr, Non_copyable
+
+#include <stdint.h>         // uint32_t
+
+#include <optional>
+#include <vector>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::C_string_ptr, sm::Non_copyable;
+    using   std::optional,
+            std::vector;
+
+    struct Control_spec
+    {
+        C_string_ptr        class_name;
+        C_string_ptr        text            = "";
+        int                 id              = 0;
+        uint32_t            styles          = 0;            // Backend specific, e.g. `BS_PUSHBUTTON`.
+        Size                size            = {64, 23};
+        optional<Point>     position        = {};           // Not flowed if specified.
+        bool                starts_new_row  = false;
+    };
+
+    struct Flow_layout
+    {
+        Rect    area;               // Only `left`, `top` and `right` are used.
+        Size    gap     = {10, 10};
+    };
+
+    inline auto placements_of( in_<vector<Control_spec>> controls, in_<Flow_layout> layout )
+        -> vector<Rect>
+    {
+        vector<Rect> result;
+        result.reserve( controls.size() );
+        Point   pos         = {layout.area.left, layout.area.top};
+        int     row_height  = 0;
+        bool    is_row_empty = true;
+        for( const Control_spec& control: controls ) {
+            if( control.position ) {
+                result.push_back( rect_at( *control.position, control.size ) );
+                continue;
+            }
+            const bool is_too_wide = (pos.x + control.size.w > layout.area.right);
+            if( not is_row_empty and (control.starts_new_row or is_too_wide) ) {
+                pos = {layout.area.left, pos.y + row_height + layout.gap.h};
+                row_height = 0;
+            }
+            result.push_back( rect_at( pos, control.size ) );
+            pos.x += control.size.w + layout.gap.w;
+            row_height = max( row_height, control.size.h );
+            is_row_empty = false;
+        }
+        return result;
+    }
+
+    // An empty rectangle if there are no non-empty ones.
+    inline auto bounds_of( in_<vector<Rect>> rects )
+        -> Rect
+    {
+        Rect result = {};
+        for( const Rect& r: rects ) { result = bounding_rect_of( result, r ); }
+        return result;
+    }
+
+    // A `Backend` provides `begin_batch()`, `create( in_<Control_spec>, in_<Rect> ) -> Handle`,
+    // `destroy( Handle )` and `end_batch( in_<Rect> bounds )`, which is called also if a `create`
+    // throws. Then the controls already created are destroyed first, so none are left behind.
+    template< class Backend >
+    auto create_controls( Backend& backend, in_<vector<Control_spec>> controls, in_<Flow_layout> layout )
+        -> vector<typename Backend::Handle>
+    {
+        const vector<Rect> placements = placements_of( controls, layout );
+
+        struct Batch:
+            Non_copyable
+        {
+            Backend&    backend;
+            Rect        bounds;
+
+            ~Batch() { backend.end_batch( bounds ); }
+            Batch( Backend& a_backend, in_<Rect> a_bounds ): backend( a_backend ), bounds( a_bounds )
+            {
+                backend.begin_batch();
+            }
+        };
+
+        vector<typename Backend::Handle> result;
+        result.reserve( controls.size() );
+        const Batch batch( backend, bounds_of( placements ) );
+        try {
+            for( const int i: sm::zero_to( sm::int_size_of( controls ) ) ) {
+                result.push_back( backend.create( controls[i], placements[i] ) );
+            }
+        } catch( ... ) {
+            for( const auto handle: result ) { backend.destroy( handle ); }
+            throw;
+        }
+        return result;
+    }
+}  // namespace graphics
@@ -0,0 +1,74 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Integer pixel geometry. A `Rect` has the same meaning as a Windows `RECT`: `right` and
+// `bottom` are beyond the rectangle, so that e.g. its width is `right - left`.
+
+#include <microlib/support-machinery.hpp>       // in_
+
+#include <algorithm>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::in_;
+    using   std::min, std::max;         // <algorithm>
+
+    struct Point    { int x; int y; };
+    struct Size     { int w; int h; };
+    struct Rect     { int left; int top; int right; int bottom; };
+
+    constexpr auto width_of( in_<Rect> r )  -> int          { return r.right - r.left; }
+    constexpr auto height_of( in_<Rect> r ) -> int          { return r.bottom - r.top; }
+    constexpr auto size_of( in_<Rect> r )   -> Size         { return {width_of( r ), height_of( r )}; }
+    constexpr auto area_of( in_<Rect> r )   -> long long    { return 1LL*width_of( r )*height_of( r ); }
+    constexpr auto is_empty( in_<Rect> r )  -> bool         { return r.right <= r.left or r.bottom <= r.top; }
+
+    constexpr auto rect_at( in_<Point> pos, in_<Size> size )
+        -> Rect
+    { return {pos.x, pos.y, pos.x + size.w, pos.y + size.h}; }
+
+    constexpr auto operator==( in_<Rect> a, in_<Rect> b )
+        -> bool
+    { return a.left == b.left and a.top == b.top and a.right == b.right and a.bottom == b.bottom; }
+
+    constexpr auto operator!=( in_<Rect> a, in_<Rect> b )
+        -> bool
+    { return not( a == b ); }
+
+    constexpr auto offset_by( in_<Rect> r, const int dx, const int dy )
+        -> Rect
+    { return {r.left + dx, r.top + dy, r.right + dx, r.bottom + dy}; }
+
+    // Possibly empty.
+    inline auto intersection_of( in_<Rect> a, in_<Rect> b )
+        -> Rect
+    {
+        return {
+            max( a.left, b.left ), max( a.top, b.top ), min( a.right, b.right ), min( a.bottom, b.bottom )
+            };
+    }
+
+    // The smallest rectangle that contains both. Empty rectangles are ignored.
+    inline auto bounding_rect_of( in_<Rect> a, in_<Rect> b )
+        -> Rect
+    {
+        if( is_empty( a ) ) { return b; }
+        if( is_empty( b ) ) { return a; }
+        return {
+            min( a.left, b.left ), min( a.top, b.top ), max( a.right, b.right ), max( a.bottom, b.bottom )
+            };
+    }
+
+    inline auto intersects( in_<Rect> a, in_<Rect> b )
+        -> bool
+    { return not is_empty( intersection_of( a, b ) ); }
+
+    // An empty `inner` is contained in any rectangle.
+    constexpr auto contains( in_<Rect> outer, in_<Rect> inner )
+        -> bool
+    {
+        return is_empty( inner ) or (
+            outer.left <= inner.left and outer.top <= inner.top and
+            inner.right <= outer.right and inner.bottom <= outer.bottom
+            );
+    }
+}  // namespace graphics
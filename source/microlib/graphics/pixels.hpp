@@ -0,0 +1,182 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Pixel types in Windows DIB byte order, and non-owning 2D views of pixel rows.
+// A view's row stride is in bytes and is negative for a bottom-up stored image, so that
+// row 0 is always the top row and a bottom-up DIB can be viewed in place without copying.
+
+#include <microlib/support-machinery.hpp>       // Byte, Index, in_, zero_to
+#include <microlib/graphics/geometry.hpp>       // Rect
+
+#include <assert.h>         // assert
+
+#include <type_traits>
+#include <vector>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::Byte, sm::Index, sm::const_, sm::in_, sm::zero_to;
+    using   std::conditional_t, std::enable_if_t, std::is_const_v, std::is_same_v,   // <type_traits>
+            std::vector;
+
+    struct Bgr_pixel    { Byte b, g, r; };
+    struct Bgra_pixel   { Byte b, g, r, a; };
+
+    // Byte-aligned so that views can refer directly to the pixels of e.g. a BMP file in memory.
+    static_assert( sizeof( Bgr_pixel ) == 3 and alignof( Bgr_pixel ) == 1 );
+    static_assert( sizeof( Bgra_pixel ) == 4 and alignof( Bgra_pixel ) == 1 );
+
+    constexpr auto operator==( in_<Bgra_pixel> a, in_<Bgra_pixel> b )
+        -> bool
+    { return a.b == b.b and a.g == b.g and a.r == b.r and a.a == b.a; }
+
+    constexpr auto operator!=( in_<Bgra_pixel> a, in_<Bgra_pixel> b )
+        -> bool
+    { return not( a == b ); }
+
+    constexpr auto has_same_rgb( in_<Bgra_pixel> a, in_<Bgra_pixel> b )
+        -> bool
+    { return a.b == b.b and a.g == b.g and a.r == b.r; }
+
+    constexpr auto opaque( in_<Bgr_pixel> pixel )
+        -> Bgra_pixel
+    { return {pixel.b, pixel.g, pixel.r, 0xFF}; }
+
+    template< class Pixel >     // Pixel is e.g. `Bgra_pixel` or `const Bgra_pixel`.
+    class Pixel_view_
+    {
+        using Byte_ = conditional_t<is_const_v<Pixel>, const Byte, Byte>;
+
+        Pixel*      m_p_top_row;
+        int         m_width;
+        int         m_height;
+        Index       m_row_stride;       // In bytes, negative for bottom-up storage.
+
+    public:
+        using Item = Pixel;
+
+        constexpr Pixel_view_():
+            m_p_top_row( nullptr ), m_width( 0 ), m_height( 0 ), m_row_stride( 0 )
+        {}
+
+        constexpr Pixel_view_( Pixel* const p_top_row, const int width, const int height, const Index row_stride ):
+            m_p_top_row( p_top_row ), m_width( width ), m_height( height ), m_row_stride( row_stride )
+        {}
+
+        // Contiguous top-down rows.
+        constexpr Pixel_view_( Pixel* const p_top_row, const int width, const int height ):
+            Pixel_view_( p_top_row, width, height, width*Index( sizeof( Pixel ) ) )
+        {}
+
+        // Conversion from a view of mutable pixels to a view of const pixels.
+        template< class Other_pixel, class = enable_if_t<is_same_v<const Other_pixel, Pixel>> >
+        constexpr Pixel_view_( in_<Pixel_view_<Other_pixel>> other ):
+            Pixel_view_( other.row( 0 ), other.width(), other.height(), other.row_stride() )
+        {}
+
+        constexpr auto width() const        -> int      { return m_width; }
+        constexpr auto height() const       -> int      { return m_height; }
+        constexpr auto row_stride() const   -> Index    { return m_row_stride; }
+        constexpr auto is_empty() const     -> bool     { return m_width <= 0 or m_height <= 0; }
+
+        constexpr auto has_contiguous_rows() const
+            -> bool
+        { return m_row_stride == m_width*Index( sizeof( Pixel ) ); }
+
+        auto row( const int y ) const
+            -> Pixel*
+        {
+            assert( y == 0 or (0 <= y and y < m_height) );
+            return reinterpret_cast<Pixel*>( reinterpret_cast<Byte_*>( m_p_top_row ) + y*m_row_stride );
+        }
+
+        auto operator()( const int x, const int y ) const
+            -> Pixel&
+        {
+            assert( 0 <= x and x < m_width );
+            return row( y )[x];
+        }
+
+        // The part of this view with upper left corner at (x, y). Must be in range.
+        auto part( const int x, const int y, const int width, const int height ) const
+            -> Pixel_view_
+        {
+            assert( 0 <= x and x + width <= m_width );
+            assert( 0 <= y and y + height <= m_height );
+            return Pixel_view_( row( y ) + x, width, height, m_row_stride );
+        }
+
+        auto part( in_<Rect> r ) const
+            -> Pixel_view_
+        { return part( r.left, r.top, width_of( r ), height_of( r ) ); }
+
+        auto bounds() const -> Rect { return {0, 0, m_width, m_height}; }
+    };
+
+    using Bgr_view          = Pixel_view_<Bgr_pixel>;
+    using Const_bgr_view    = Pixel_view_<const Bgr_pixel>;
+    using Bgra_view         = Pixel_view_<Bgra_pixel>;
+    using Const_bgra_view   = Pixel_view_<const Bgra_pixel>;
+
+    template< class Pixel >
+    void fill( in_<Pixel_view_<Pixel>> pixels, in_<Pixel> color )
+    {
+        for( const int y: zero_to( pixels.height() ) ) {
+            const_<Pixel*> p_row = pixels.row( y );
+            for( const int x: zero_to( pixels.width() ) ) { p_row[x] = color; }
+        }
+    }
+
+    // An owned image with contiguous top-down rows of 32bpp pixels.
+    class Bgra_image
+    {
+        int                     m_width;
+        int                     m_height;
+        vector<Bgra_pixel>      m_pixels;
+
+    public:
+        Bgra_image(): m_width( 0 ), m_height( 0 ) {}
+
+        Bgra_image( const int width, const int height, in_<Bgra_pixel> fill = {} ):
+            m_width( width ), m_height( height ),
+            m_pixels( Index( width )*height, fill )
+        {
+            assert( width >= 0 and height >= 0 );
+        }
+
+        auto width() const  -> int  { return m_width; }
+        auto height() const -> int  { return m_height; }
+
+        auto view()         -> Bgra_view        { return Bgra_view( m_pixels.data(), m_width, m_height ); }
+        auto view() const   -> Const_bgra_view  { return Const_bgra_view( m_pixels.data(), m_width, m_height ); }
+    };
+
+    inline auto to_bgra_image( in_<Const_bgr_view> source )
+        -> Bgra_image
+    {
+        auto result = Bgra_image( source.width(), source.height() );
+        const Bgra_view destination = result.view();
+        for( const int y: zero_to( source.height() ) ) {
+            const_<const Bgr_pixel*> p_source = source.row( y );
+            const_<Bgra_pixel*> p_destination = destination.row( y );
+            for( const int x: zero_to( source.width() ) ) {
+                p_destination[x] = opaque( p_source[x] );
+            }
+        }
+        return result;
+    }
+
+    inline auto to_bgra_image( in_<Const_bgra_view> source )
+        -> Bgra_image
+    {
+        auto result = Bgra_image( source.width(), source.height() );
+        const Bgra_view destination = result.view();
+        for( const int y: zero_to( source.height() ) ) {
+            const_<const Bgra_pixel*> p_source = source.row( y );
+            const_<Bgra_pixel*> p_destination = destination.row( y );
+            for( const int x: zero_to( source.width() ) ) {
+                p_destination[x] = p_source[x];
+            }
+        }
+        return result;
+    }
+}  // namespace graphics
@@ -0,0 +1,208 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Solid, pattern and gradient background fills of a pixel buffer, rendered in parallel as
+// cache sized tiles on a `Work_stealing_pool`, e.g. for erasing a large window's back buffer.
+//
+// A fill is defined for the whole buffer, so that a pattern or gradient lines up across
+// separately rendered parts. `render_fill` returns when the whole area has been rendered. An area
+// of only a few tiles, e.g. a small dirty rectangle, is rendered directly by the calling thread.
+
+#include <microlib/graphics/geometry.hpp>       // Point, Size, Rect
+#include <microlib/graphics/pixels.hpp>         // Bgra_pixel, Bgra_view, Const_bgra_view, fill
+#include <microlib/graphics/tiling.hpp>         // tiles_of, rows_of
+#include <microlib/support-machinery.hpp>       // in_, const_, zero_to, Interval, Work_stealing_pool
+
+#include <stdint.h>         // int64_t
+#include <string.h>         // memcpy
+
+#include <algorithm>
+#include <vector>
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::const_, sm::zero_to, sm::Interval, sm::Work_stealing_pool;
+    using   std::clamp, std::min, std::max,     // <algorithm>
+            std::vector;
+
+    struct Fill
+    {
+        enum Kind: int { solid, pattern, vertical_gradient, horizontal_gradient };
+
+        Kind                kind;
+        Bgra_pixel          color;          // For `solid`, and the start color of a gradient.
+        Bgra_pixel          end_color;      // For gradients.
+        Interval            span;           // For gradients, the coordinates where they go from `color` to `end_color`.
+        Const_bgra_view     image;          // For `pattern`. Must outlive the rendering.
+        Point               origin;         // For `pattern`, the position of `image( 0, 0 )`.
+
+        static auto solid_color( in_<Bgra_pixel> c )
+            -> Fill
+        { return {solid, c, {}, {0, 0}, {}, {}}; }
+
+        static auto pattern_of( in_<Const_bgra_view> image, in_<Point> origin = {0, 0} )
+            -> Fill
+        { return {pattern, {}, {}, {0, 0}, image, origin}; }
+
+        // E.g. `Fill::gradient( Fill::vertical_gradient, top_color, bottom_color, rows_of( bounds ) )`.
+        static auto gradient( const Kind direction, in_<Bgra_pixel> from, in_<Bgra_pixel> to, in_<Interval> span )
+            -> Fill
+        { return {direction, from, to, span, {}, {}}; }
+    };
+
+    namespace impl {
+        // The colors of a gradient, clamped to the end colors outside the span. The color at a
+        // coordinate is computed with a multiplication instead of a division.
+        class Gradient_ramp
+        {
+            Bgra_pixel      m_from;
+            Bgra_pixel      m_to;
+            Interval        m_span;
+            int64_t         m_t_step;       // 256/span length, as fixed point with 32 fraction bits.
+
+        public:
+            Gradient_ramp( in_<Fill> fill ):
+                m_from( fill.color ), m_to( fill.end_color ), m_span( fill.span.first, max( fill.span.first, fill.span.last ) ),
+                m_t_step( m_span.last > m_span.first? ((int64_t( 256 ) << 32) + m_span.last - m_span.first - 1)/(m_span.last - m_span.first) : 0 )
+            {}
+
+            auto color_at( const int v ) const
+                -> Bgra_pixel
+            {
+                const int t = int( (clamp( v, m_span.first, m_span.last ) - m_span.first)*m_t_step >> 32 );
+                const auto mixed = [t]( const int a, const int b ) -> Byte { return Byte( (a*(256 - t) + b*t + 128) >> 8 ); };
+                return {mixed( m_from.b, m_to.b ), mixed( m_from.g, m_to.g ), mixed( m_from.r, m_to.r ), mixed( m_from.a, m_to.a )};
+            }
+        };
+
+        inline auto wrapped( const int v, const int n )
+            -> int
+        {
+            const int r = v % n;
+            return (r < 0? r + n : r);
+        }
+
+        // Renders one tile. The tiles of a buffer can be rendered concurrently.
+        inline void render_fill_tile( in_<Bgra_view> pixels, in_<Rect> tile, in_<Fill> fill )
+        {
+            const int width = width_of( tile );
+            switch( fill.kind ) {
+                case Fill::solid: {
+                    graphics::fill( pixels.part( tile ), fill.color );
+                    break;
+                }
+                case Fill::vertical_gradient: {
+                    const Gradient_ramp ramp( fill );
+                    for( const int y: rows_of( tile ) ) {
+                        graphics::fill( pixels.part( tile.left, y, width, 1 ), ramp.color_at( y ) );
+                    }
+                    break;
+                }
+                case Fill::horizontal_gradient: {
+                    const Gradient_ramp ramp( fill );
+                    const_<Bgra_pixel*> p_first_row = pixels.row( tile.top ) + tile.left;
+                    for( const int i: zero_to( width ) ) { p_first_row[i] = ramp.color_at( tile.left + i ); }
+                    for( const int y: rows_of( tile ) ) {
+                        if( y != tile.top ) { memcpy( pixels.row( y ) + tile.left, p_first_row, width*sizeof( Bgra_pixel ) ); }
+                    }
+                    break;
+                }
+                case Fill::pattern: {
+                    const Const_bgra_view& image = fill.image;
+                    if( image.is_empty() ) {
+                        break;
+                    }
+                    for( const int y: rows_of( tile ) ) {
+                        const_<const Bgra_pixel*> p_source_row = image.row( wrapped( y - fill.origin.y, image.height() ) );
+                        const_<Bgra_pixel*> p_row = pixels.row( y );
+                        int x = tile.left;
+                        int x_source = wrapped( x - fill.origin.x, image.width() );
+                        while( x < tile.right ) {       // Copies runs of up to an image row.
+                            const int n = min( image.width() - x_source, tile.right - x );
+                            memcpy( p_row + x, p_source_row + x_source, n*sizeof( Bgra_pixel ) );
+                            x += n;
+                            x_source = 0;
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }  // namespace impl
+
+    constexpr int default_tile_n_bytes = 256*1024;      // Roughly a per-core L2 cache.
+
+    // Bands of the area's full width, with the number of rows that gives about `n_bytes` per tile.
+    // For fills, which are limited by memory bandwidth, this beats square tiles, because each
+    // tile is contiguous rows.
+    inline auto cache_sized_tile_size_for( in_<Rect> area, const int n_bytes = default_tile_n_bytes )
+        -> Size
+    {
+        const int width = max( 1, width_of( area ) );
+        return {width, max( 1, n_bytes/int( width*sizeof( Bgra_pixel ) ) )};
+    }
+
+    namespace impl {
+        constexpr int min_tiles_for_parallel = 4;
+
+        inline auto fill_tiles_of( in_<Rect> clipped_area, in_<Size> tile_size )
+            -> Tiles
+        {
+            const bool is_default_size = not (tile_size.w > 0 and tile_size.h > 0);
+            return tiles_of( clipped_area, (is_default_size? cache_sized_tile_size_for( clipped_area ) : tile_size) );
+        }
+    }  // namespace impl
+
+    // Whether `render_fill` with a pool would use the pool for `area`, i.e. whether it's several tiles.
+    // E.g. for creating a pool only when one is needed.
+    inline auto is_rendered_in_parallel( in_<Bgra_view> pixels, in_<Rect> area, in_<Size> tile_size = {0, 0} )
+        -> bool
+    {
+        const Rect clipped = intersection_of( area, pixels.bounds() );
+        return not is_empty( clipped )
+            and impl::fill_tiles_of( clipped, tile_size ).size() >= impl::min_tiles_for_parallel;
+    }
+
+    // Renders `fill` into the `area` part of `pixels`, directly by the calling thread.
+    inline void render_fill( in_<Bgra_view> pixels, in_<Rect> area, in_<Fill> fill )
+    {
+        const Rect clipped = intersection_of( area, pixels.bounds() );
+        if( not is_empty( clipped ) ) {
+            impl::render_fill_tile( pixels, clipped, fill );
+        }
+    }
+
+    // Renders `fill` into the `area` part of `pixels`, divided into tiles that are rendered in
+    // parallel by `pool`. An empty `tile_size` means `cache_sized_tile_size_for( area )`.
+    inline void render_fill(
+        in_<Bgra_view>              pixels,
+        in_<Rect>                   area,
+        in_<Fill>                   fill,
+        Work_stealing_pool&         pool,
+        in_<Size>                   tile_size   = {0, 0}
+        )
+    {
+        const Rect clipped = intersection_of( area, pixels.bounds() );
+        if( is_empty( clipped ) ) {
+            return;
+        }
+        const Tiles tiles = impl::fill_tiles_of( clipped, tile_size );
+        if( tiles.size() < impl::min_tiles_for_parallel ) {
+            impl::render_fill_tile( pixels, clipped, fill );
+            return;
+        }
+
+        // A horizontal gradient is rendered as a pattern of one row, so its colors are computed once.
+        vector<Bgra_pixel> gradient_row;
+        Fill tile_fill = fill;
+        if( fill.kind == Fill::horizontal_gradient ) {
+            const impl::Gradient_ramp ramp( fill );
+            gradient_row.resize( width_of( clipped ) );
+            for( const int i: zero_to( width_of( clipped ) ) ) { gradient_row[i] = ramp.color_at( clipped.left + i ); }
+            tile_fill = Fill::pattern_of( Const_bgra_view( gradient_row.data(), width_of( clipped ), 1 ), {clipped.left, 0} );
+        }
+        pool.for_each_index( tiles.size(), [&]( const int i )
+        {
+            impl::render_fill_tile( pixels, tiles[i], tile_fill );
+        } );
+    }
+}  // namespace graphics
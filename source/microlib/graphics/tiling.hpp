@@ -0,0 +1,61 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A rectangle as rows of tiles, e.g. `for( const Rect tile: tiles_of( area, {64, 64} ) )`, for
+// pixel loops that should work on cache sized parts of an image at a time.
+//
+// The tiles are in row-major order, and those at the right and bottom edges are clipped to the
+// area. The view is random access, so the tiles can also be divided between threads by index.
+
+#include <microlib/graphics/geometry.hpp>       // Rect, Size, width_of, height_of
+#include <microlib/support-machinery.hpp>       // in_, Index_iterator_, Interval
+
+#include <assert.h>         // assert
+
+namespace graphics {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::Interval;
+
+    struct Tiles
+    {
+        using Integer = int;
+        using Iterator = sm::Index_iterator_<Tiles>;
+
+        Rect        area;
+        Size        tile_size;
+
+        constexpr auto n_across() const -> int { return (width_of( area ) + tile_size.w - 1)/tile_size.w; }
+        constexpr auto n_down() const   -> int { return (height_of( area ) + tile_size.h - 1)/tile_size.h; }
+
+        constexpr auto size() const
+            -> int
+        { return (is_empty( area )? 0 : n_across()*n_down()); }
+
+        constexpr auto item( const int i ) const
+            -> Rect
+        {
+            const int x = area.left + (i % n_across())*tile_size.w;
+            const int y = area.top + (i / n_across())*tile_size.h;
+            return {
+                x, y,
+                (area.right - x < tile_size.w? area.right : x + tile_size.w),
+                (area.bottom - y < tile_size.h? area.bottom : y + tile_size.h)
+                };
+        }
+
+        constexpr auto operator[]( const int i ) const -> Rect { return item( i ); }
+
+        constexpr auto begin() const    -> Iterator     { return Iterator( *this, 0 ); }
+        constexpr auto end() const      -> Iterator     { return Iterator( *this, size() ); }
+    };
+
+    constexpr auto tiles_of( in_<Rect> area, in_<Size> tile_size )
+        -> Tiles
+    {
+        assert( tile_size.w > 0 and tile_size.h > 0 );
+        return {area, tile_size};
+    }
+
+    // The pixel row and column coordinates of a rectangle, for the inner loops over a tile.
+    constexpr auto rows_of( in_<Rect> r )       -> Interval     { return Interval( r.top, r.bottom - 1 ); }
+    constexpr auto columns_of( in_<Rect> r )    -> Interval     { return Interval( r.left, r.right - 1 ); }
+}  // namespace graphics
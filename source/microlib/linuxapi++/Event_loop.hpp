@@ -0,0 +1,226 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A Linux counterpart of `winapi::Event_loop`, built on `epoll`, with an `eventfd` for
+// functions posted from other threads (in the role of window messages) and a `timerfd` armed
+// for the next timer deadline. It waits for all of these and for added file descriptors in a
+// single `epoll_wait` call, and lets the scheduling logic and idle-wakeup counts be exercised
+// on Linux build machines.
+//
+// `std::chrono::steady_clock` is assumed to be `CLOCK_MONOTONIC`, as it is with g++ and clang.
+
+#include <microlib/support-machinery.hpp>                   // rethrow_popped_exception, SM_FAIL, Non_copyable
+#include <microlib/support-machinery/Timer_queue.hpp>       // Timer_queue, Event_loop_stats
+
+#include <errno.h>
+#include <stdint.h>         // uint64_t
+#include <string.h>         // strerror
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>         // read, write, close
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace linuxapi {
+    namespace sm = support_machinery;
+    using   sm::hopefully, sm::zero_to, sm::rethrow_popped_exception,
+            sm::Non_copyable, sm::Timer_queue, sm::Event_loop_stats;
+    using   std::deque,
+            std::function,                      // <functional>
+            std::mutex, std::lock_guard,        // <mutex>
+            std::string,
+            std::unordered_map,
+            std::move;                          // <utility>
+    namespace chrono = std::chrono;
+
+    inline auto errno_text()
+        -> string
+    { return string( strerror( errno ) ); }
+
+    class Unique_fd:
+        public Non_copyable
+    {
+        int     m_fd;
+
+    public:
+        ~Unique_fd() { if( m_fd >= 0 ) { ::close( m_fd ); } }
+        explicit Unique_fd( const int fd ): m_fd( fd ) {}
+
+        auto value() const -> int { return m_fd; }
+    };
+
+    class Event_loop:
+        public Non_copyable
+    {
+        Unique_fd                               m_epoll;
+        Unique_fd                               m_wakeup;       // eventfd
+        Unique_fd                               m_timer;        // timerfd
+        unordered_map<int, function<void()>>    m_handlers;     // By file descriptor.
+        Timer_queue                             m_timers;
+        Event_loop_stats                        m_stats;
+        bool                                    m_is_quitting;
+
+        mutex                                   m_posted_mutex;
+        deque<function<void()>>                 m_posted;
+
+        void watch( const int fd )
+        {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            ::epoll_ctl( m_epoll.value(), EPOLL_CTL_ADD, fd, &event ) == 0
+                or SM_FAIL( "epoll_ctl failed: " + errno_text() );
+        }
+
+        void arm_timer_for( const Timer_queue::Time_point deadline )
+        {
+            const auto ns = chrono::duration_cast<chrono::nanoseconds>( deadline.time_since_epoch() ).count();
+            itimerspec spec = {};
+            spec.it_value.tv_sec    = static_cast<time_t>( ns/1'000'000'000 );
+            spec.it_value.tv_nsec   = static_cast<long>( ns%1'000'000'000 );
+            if( spec.it_value.tv_sec == 0 and spec.it_value.tv_nsec == 0 ) {
+                spec.it_value.tv_nsec = 1;      // Zero would disarm the timer.
+            }
+            ::timerfd_settime( m_timer.value(), TFD_TIMER_ABSTIME, &spec, nullptr ) == 0
+                or SM_FAIL( "timerfd_settime failed: " + errno_text() );
+        }
+
+        void disarm_timer()
+        {
+            const itimerspec spec = {};
+            ::timerfd_settime( m_timer.value(), 0, &spec, nullptr );
+        }
+
+        static void drain( const int fd )
+        {
+            uint64_t count;
+            while( ::read( fd, &count, sizeof( count ) ) == sizeof( count ) ) {}
+        }
+
+        void wake()
+        {
+            const uint64_t one = 1;
+            (void) ::write( m_wakeup.value(), &one, sizeof( one ) );
+        }
+
+        // Those posted before the call, one at a time, so that if one throws the rest stay
+        // queued, and the loop is woken again for them.
+        void run_posted_functions()
+        {
+            size_t n_remaining;
+            {
+                const lock_guard<mutex> lock( m_posted_mutex );
+                n_remaining = m_posted.size();
+            }
+            try {
+                for( ; n_remaining > 0; --n_remaining ) {
+                    function<void()> f;
+                    {
+                        const lock_guard<mutex> lock( m_posted_mutex );
+                        f = move( m_posted.front() );
+                        m_posted.pop_front();
+                    }
+                    ++m_stats.n_messages;
+                    f();
+                    rethrow_popped_exception();
+                }
+            } catch( ... ) {
+                if( n_remaining > 1 ) { wake(); }
+                throw;
+            }
+        }
+
+    public:
+        Event_loop():
+            m_epoll( ::epoll_create1( EPOLL_CLOEXEC ) ),
+            m_wakeup( ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ),
+            m_timer( ::timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC ) ),
+            m_is_quitting( false )
+        {
+            hopefully( m_epoll.value() >= 0 and m_wakeup.value() >= 0 and m_timer.value() >= 0 )
+                or SM_FAIL( "Failed to create the event loop's file descriptors: " + errno_text() );
+            watch( m_wakeup.value() );
+            watch( m_timer.value() );
+        }
+
+        auto timers()       -> Timer_queue&                 { return m_timers; }
+        auto stats() const  -> const Event_loop_stats&      { return m_stats; }
+
+        // Thread safe. The function is called on the event loop's thread.
+        void post( function<void()> f )
+        {
+            {
+                const lock_guard<mutex> lock( m_posted_mutex );
+                m_posted.push_back( move( f ) );
+            }
+            wake();
+        }
+
+        // Thread safe. Makes `run` return after the functions posted before this.
+        void post_quit() { post( [this]{ m_is_quitting = true; } ); }
+
+        // The `handler` is called on the event loop's thread whenever `fd` is readable.
+        void add_waitable( const int fd, function<void()> handler )
+        {
+            watch( fd );
+            m_handlers[fd] = move( handler );
+        }
+
+        void remove_waitable( const int fd )
+        {
+            ::epoll_ctl( m_epoll.value(), EPOLL_CTL_DEL, fd, nullptr );
+            m_handlers.erase( fd );
+        }
+
+        void run()
+        {
+            m_is_quitting = false;
+            constexpr int max_events = 16;
+            epoll_event events[max_events];
+            while( not m_is_quitting ) {
+                if( const auto deadline = m_timers.next_deadline() ) {
+                    arm_timer_for( *deadline );
+                } else {
+                    disarm_timer();
+                }
+
+                const int n_events = ::epoll_wait( m_epoll.value(), events, max_events, -1 );
+                if( n_events < 0 ) {
+                    hopefully( errno == EINTR ) or SM_FAIL( "epoll_wait failed: " + errno_text() );
+                    continue;
+                }
+                ++m_stats.n_wakeups;
+
+                const auto n_dispatched_before = m_stats.n_messages + m_stats.n_signals;
+                for( const int i: zero_to( n_events ) ) {
+                    const int fd = events[i].data.fd;
+                    if( fd == m_wakeup.value() ) {
+                        drain( fd );
+                        run_posted_functions();
+                    } else if( fd == m_timer.value() ) {
+                        drain( fd );
+                    } else if( const auto it = m_handlers.find( fd ); it != m_handlers.end() ) {
+                        ++m_stats.n_signals;
+                        const function<void()> handler = it->second;    // May remove itself.
+                        handler();
+                        rethrow_popped_exception();
+                    }
+                }
+
+                const int n_timer_callbacks = m_timers.dispatch_due( Timer_queue::Clock::now() );
+                m_stats.n_timer_callbacks += n_timer_callbacks;
+                rethrow_popped_exception();
+                if( n_timer_callbacks == 0 and m_stats.n_messages + m_stats.n_signals == n_dispatched_before ) {
+                    ++m_stats.n_idle_wakeups;
+                }
+            }
+        }
+    };
+}  // namespace linuxapi
@@ -1,8 +1,25 @@
 ﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
 
 #include <microlib/support-machinery/basic-types.hpp>           // C_string_ptr, Mutable_cstr_ptr
-#include <microlib/support-machinery/exception-handling.hpp>    // SM_FAIL, hopefully, fail_, fail, rethrow_any_nested_x_of, with_messages_of, messages_of
-#include <microlib/support-machinery/Interval_.hpp>             // Interval_, is_in, zero_to, one_through
+#include <microlib/support-machinery/Bounded_mpsc_queue_.hpp>   // Bounded_mpsc_queue_
+#include <microlib/support-machinery/Cancellation.hpp>          // Cancellation_source, Cancellation_token
+#include <microlib/support-machinery/cpu-features.hpp>          // Simd_level, simd_level, SM_IS_X86
+#include <microlib/support-machinery/Dispatch_map_.hpp>         // Dispatch_map_, On_
+#include <microlib/support-machinery/exception-handling.hpp>    // SM_FAIL, hopefully, fail_, fail, rethrow_any_nested_x_of, with_messages_of, messages_of, Exception_queue
+#include <microlib/support-machinery/Frame_pacer.hpp>          // Frame_pacer, Jitter_histogram
+#include <microlib/support-machinery/Index_iterator_.hpp>       // Index_iterator_
+#include <microlib/support-machinery/Interval_.hpp>             // Interval_, Strided_interval_, Chunked_interval_, is_in, zero_to, one_through
+#include <microlib/support-machinery/Latency_histogram.hpp>     // Latency_histogram, Latency_table
+#include <microlib/support-machinery/Lru_cache_.hpp>             // Lru_cache_, Cache_stats
 #include <microlib/support-machinery/misc.hpp>
+#include <microlib/support-machinery/Shared_lru_cache_.hpp>      // Shared_lru_cache_
+#include <microlib/support-machinery/Span_.hpp>                 // Span_, Byte_span
+#include <microlib/support-machinery/String_interner.hpp>        // String_interner
 #include <microlib/support-machinery/string-building.hpp>       // ~, sb, operator<<, inline namespace string_building
+#include <microlib/support-machinery/string-diff.hpp>           // i_first_difference, i_first_difference_from_end
+#include <microlib/support-machinery/Timer_queue.hpp>           // Timer_queue, Event_loop_stats
+#include <microlib/support-machinery/Triple_buffer_.hpp>        // Triple_buffer_
 #include <microlib/support-machinery/type-builders.hpp>         // const_, ref_, in_
+#include <microlib/support-machinery/Unique_handle_.hpp>        // Unique_handle_, Unique_handle_with_, Handle_pool_
+#include <microlib/support-machinery/Wait_operation.hpp>        // Wait_operation
+#include <microlib/support-machinery/Work_stealing_pool.hpp>    // Work_stealing_pool
@@ -0,0 +1,108 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A bounded lock-free queue for any number of producer threads and one consumer thread.
+//
+// It's a ring of slots with per-slot sequence numbers (Dmitry Vyukov's design): a producer
+// claims a slot with one compare-and-swap on the shared tail, writes the item, and publishes
+// it by storing the slot's sequence number. `push` fails instead of waiting when the queue is full.
+
+#include <microlib/support-machinery/misc.hpp>              // Non_copyable
+#include <microlib/support-machinery/type-builders.hpp>     // in_
+
+#include <stddef.h>         // size_t, ptrdiff_t
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace support_machinery {
+    using   std::atomic,                                // <atomic>
+            std::unique_ptr,                            // <memory>
+            std::optional,
+            std::move;                                  // <utility>
+
+    template< class Item >
+    class Bounded_mpsc_queue_:
+        public Non_copyable
+    {
+        struct alignas( 64 ) Slot
+        {
+            atomic<size_t>      sequence;
+            Item                item;
+        };
+
+        size_t                      m_mask;
+        unique_ptr<Slot[]>          m_slots;
+        alignas( 64 ) atomic<size_t> m_tail;       // Next position to push to, shared by producers.
+        alignas( 64 ) size_t        m_head;        // Next position to pop from, used only by the consumer.
+
+        static auto power_of_2_at_least( const int n )
+            -> size_t
+        {
+            size_t result = 2;
+            while( result < size_t( n ) ) { result *= 2; }
+            return result;
+        }
+
+    public:
+        explicit Bounded_mpsc_queue_( const int min_capacity ):
+            m_mask( power_of_2_at_least( min_capacity ) - 1 ),
+            m_slots( new Slot[m_mask + 1] ),
+            m_tail( 0 ),
+            m_head( 0 )
+        {
+            for( size_t i = 0; i <= m_mask; ++i ) { m_slots[i].sequence.store( i, std::memory_order_relaxed ); }
+        }
+
+        auto capacity() const -> int { return static_cast<int>( m_mask + 1 ); }
+
+        // Approximate when other threads are pushing.
+        auto size() const
+            -> int
+        { return static_cast<int>( m_tail.load( std::memory_order_acquire ) - m_head ); }
+
+        //-------------------------------- For any thread:
+
+        // Returns `false` if the queue is full.
+        auto push( Item item )
+            -> bool
+        {
+            size_t position = m_tail.load( std::memory_order_relaxed );
+            for( ;; ) {
+                Slot& slot = m_slots[position & m_mask];
+                const size_t sequence = slot.sequence.load( std::memory_order_acquire );
+                const auto difference = static_cast<ptrdiff_t>( sequence - position );
+                if( difference == 0 ) {
+                    if( m_tail.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) ) {
+                        slot.item = move( item );
+                        slot.sequence.store( position + 1, std::memory_order_release );
+                        return true;
+                    }
+                } else if( difference < 0 ) {
+                    return false;       // The slot hasn't been popped yet, a full lap behind.
+                } else {
+                    position = m_tail.load( std::memory_order_relaxed );
+                }
+            }
+        }
+
+        //-------------------------------- For the consumer thread:
+
+        // An empty optional if there's no completely pushed item at the head.
+        auto popped()
+            -> optional<Item>
+        {
+            Slot& slot = m_slots[m_head & m_mask];
+            if( slot.sequence.load( std::memory_order_acquire ) != m_head + 1 ) {
+                return {};
+            }
+            optional<Item> result = move( slot.item );
+            slot.item = Item();
+            slot.sequence.store( m_head + m_mask + 1, std::memory_order_release );
+            ++m_head;
+            return result;
+        }
+    };
+
+}  // namespace support_machinery
@@ -0,0 +1,195 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Cooperative cancellation: a `Cancellation_source` requests cancellation, and the work polls
+// a `Cancellation_token` from the source, e.g. once per iteration of an inner loop.
+//
+// `is_cancelled` is a single atomic load plus, for a token with a deadline, a clock read.
+// Callbacks registered with a token are called on the cancelling thread when cancellation is
+// requested, or at once if it already has been, e.g. to wake up a waiting worker thread.
+
+#include <microlib/support-machinery/misc.hpp>              // Non_copyable
+#include <microlib/support-machinery/type-builders.hpp>     // in_
+
+#include <stdint.h>         // int64_t
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace support_machinery {
+    using   std::atomic,                                // <atomic>
+            std::condition_variable,                    // <condition_variable>
+            std::function,                              // <functional>
+            std::shared_ptr, std::make_shared,          // <memory>
+            std::mutex, std::lock_guard, std::unique_lock,  // <mutex>
+            std::thread,                                // <thread>
+            std::move, std::pair,                       // <utility>
+            std::vector;
+    namespace chrono = std::chrono;
+
+    namespace cancellation_impl {
+        class Shared_state:
+            public Non_copyable
+        {
+            atomic<bool>                                m_is_cancelled;
+            mutex                                       m_mutex;
+            condition_variable                          m_callback_done;
+            vector<pair<int64_t, function<void()>>>     m_callbacks;
+            int64_t                                     m_last_callback_id;
+            int64_t                                     m_running_callback_id;      // 0 for none.
+            thread::id                                  m_cancelling_thread;
+
+        public:
+            Shared_state():
+                m_is_cancelled( false ), m_last_callback_id( 0 ), m_running_callback_id( 0 )
+            {}
+
+            auto is_cancelled() const
+                -> bool
+            { return m_is_cancelled.load( std::memory_order_acquire ); }
+
+            // The callbacks are called one at a time without holding the lock, so that a
+            // callback can register or remove callbacks.
+            void cancel()
+            {
+                unique_lock<mutex> lock( m_mutex );
+                if( m_is_cancelled.exchange( true, std::memory_order_acq_rel ) ) {
+                    return;
+                }
+                m_cancelling_thread = std::this_thread::get_id();
+                while( not m_callbacks.empty() ) {
+                    auto [id, callback] = move( m_callbacks.front() );
+                    m_callbacks.erase( m_callbacks.begin() );
+                    m_running_callback_id = id;
+                    lock.unlock();
+                    callback();
+                    lock.lock();
+                    m_running_callback_id = 0;
+                    m_callback_done.notify_all();
+                }
+            }
+
+            // Returns 0 if the callback was called at once.
+            auto add_callback( function<void()> callback )
+                -> int64_t
+            {
+                {
+                    const lock_guard<mutex> lock( m_mutex );
+                    if( not is_cancelled() ) {
+                        m_callbacks.emplace_back( ++m_last_callback_id, move( callback ) );
+                        return m_last_callback_id;
+                    }
+                }
+                callback();
+                return 0;
+            }
+
+            // If the callback is running on another thread this waits until it has returned.
+            void remove_callback( const int64_t id )
+            {
+                unique_lock<mutex> lock( m_mutex );
+                for( auto it = m_callbacks.begin(); it != m_callbacks.end(); ++it ) {
+                    if( it->first == id ) {
+                        m_callbacks.erase( it );
+                        return;
+                    }
+                }
+                if( m_cancelling_thread != std::this_thread::get_id() ) {
+                    m_callback_done.wait( lock, [&]{ return m_running_callback_id != id; } );
+                }
+            }
+        };
+    }  // namespace cancellation_impl
+
+    // Removes the callback on destruction. As with `std::stop_callback`, if the callback is then
+    // running on another thread, the destructor waits for it to return, so that the callback's
+    // captured state can be destroyed right after. A callback may destroy its own registration.
+    class Cancellation_callback_registration:
+        public Non_copyable
+    {
+        shared_ptr<cancellation_impl::Shared_state>     m_p_state;
+        int64_t                                         m_id;
+
+    public:
+        ~Cancellation_callback_registration() { if( m_id != 0 ) { m_p_state->remove_callback( m_id ); } }
+
+        Cancellation_callback_registration(
+            shared_ptr<cancellation_impl::Shared_state> p_state,
+            const int64_t                               id
+            ):
+            m_p_state( move( p_state ) ), m_id( id )
+        {}
+    };
+
+    class Cancellation_token
+    {
+    public:
+        using Clock         = chrono::steady_clock;
+        using Time_point    = Clock::time_point;
+
+    private:
+        shared_ptr<cancellation_impl::Shared_state>     m_p_state;
+        Time_point                                      m_deadline;     // `Time_point::max()` for none.
+
+    public:
+        // A token that's never cancelled.
+        Cancellation_token(): m_p_state(), m_deadline( Time_point::max() ) {}
+
+        Cancellation_token( shared_ptr<cancellation_impl::Shared_state> p_state, const Time_point deadline ):
+            m_p_state( move( p_state ) ), m_deadline( deadline )
+        {}
+
+        auto deadline() const -> Time_point { return m_deadline; }
+
+        auto is_cancelled() const
+            -> bool
+        {
+            return (m_p_state and m_p_state->is_cancelled())
+                or (m_deadline != Time_point::max() and Clock::now() >= m_deadline);
+        }
+
+        // A token with the earlier of this token's deadline and the given one.
+        auto with_deadline( const Time_point deadline ) const
+            -> Cancellation_token
+        { return Cancellation_token( m_p_state, (deadline < m_deadline? deadline : m_deadline) ); }
+
+        auto with_timeout( const Clock::duration timeout ) const
+            -> Cancellation_token
+        { return with_deadline( Clock::now() + timeout ); }
+
+        // The callback isn't called for a deadline, only for a cancellation request.
+        auto on_cancellation( function<void()> callback ) const
+            -> Cancellation_callback_registration
+        {
+            if( not m_p_state ) {
+                return Cancellation_callback_registration( m_p_state, 0 );
+            }
+            return Cancellation_callback_registration( m_p_state, m_p_state->add_callback( move( callback ) ) );
+        }
+    };
+
+    // Copies refer to the same cancellation state.
+    class Cancellation_source
+    {
+        shared_ptr<cancellation_impl::Shared_state>     m_p_state;
+
+    public:
+        Cancellation_source(): m_p_state( make_shared<cancellation_impl::Shared_state>() ) {}
+
+        auto token() const
+            -> Cancellation_token
+        { return Cancellation_token( m_p_state, Cancellation_token::Time_point::max() ); }
+
+        auto is_cancellation_requested() const -> bool { return m_p_state->is_cancelled(); }
+
+        // Thread safe. Calls the registered callbacks on this thread, the first time.
+        void cancel() { m_p_state->cancel(); }
+    };
+
+}  // namespace support_machinery
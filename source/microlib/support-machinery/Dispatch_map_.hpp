@@ -0,0 +1,147 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A compile time map from integer keys, e.g. window message ids, to handler functions.
+//
+// The entries are types, `On_<key, handler>`, and the map is a perfect hash table computed at
+// compile time: a key is multiplied by a constant, the top bits of the product select a slot,
+// and a single compare says whether the key has a handler. So a dispatch is a multiply, a
+// shift, a compare and an indirect call, with no search, and adding a handler is adding a type.
+//
+// A handler returns `optional<Result>`, where an empty optional means "not handled", or just
+// `Result`, or `void` for a handler that always handles with a default `Result{}`.
+
+#include <microlib/support-machinery/Interval_.hpp>         // zero_to
+#include <microlib/support-machinery/type-builders.hpp>     // in_
+
+#include <stdint.h>         // uint32_t, uint64_t
+
+#include <array>
+#include <optional>
+#include <type_traits>
+
+namespace support_machinery {
+    using   std::array,
+            std::optional,
+            std::is_void_v, std::invoke_result_t;  // <type_traits>
+
+    template< auto a_key, auto a_handler >
+    struct On_
+    {
+        static constexpr auto key       = a_key;
+        static constexpr auto handler   = a_handler;
+    };
+
+    namespace dispatch_map_impl {
+        struct Hash_params{ uint32_t multiplier; int n_bits; };
+
+        constexpr auto slot_of( const uint32_t key, in_<Hash_params> params )
+            -> int
+        { return (params.n_bits == 0? 0 : static_cast<int>( (key*params.multiplier) >> (32 - params.n_bits) )); }
+
+        template< int n >
+        constexpr auto is_perfect( in_<array<uint32_t, n>> keys, in_<Hash_params> params )
+            -> bool
+        {
+            array<bool, (n == 0? 1 : 4*n)> is_used = {};       // 4*n slots is the largest table tried.
+            for( const uint32_t key: keys ) {
+                const int i = slot_of( key, params );
+                if( is_used[i] ) { return false; }
+                is_used[i] = true;
+            }
+            return true;
+        }
+
+        // The smallest table, from n up to 4n slots, with the first multiplier that works.
+        template< int n >
+        constexpr auto perfect_hash_params_for( in_<array<uint32_t, n>> keys )
+            -> Hash_params
+        {
+            if( n == 0 ) {
+                return {0, 0};      // A single unused slot.
+            }
+            int n_min_bits = 0;
+            while( (1 << n_min_bits) < n ) { ++n_min_bits; }
+            for( int n_bits = n_min_bits; (1 << n_bits) <= 4*n; ++n_bits ) {
+                for( const int i: zero_to( 4096 ) ) {
+                    const auto multiplier = uint32_t( 2654435769u + 2u*uint32_t( i ) );   // Odd.
+                    if( is_perfect<n>( keys, {multiplier, n_bits} ) ) {
+                        return {multiplier, n_bits};
+                    }
+                }
+            }
+            return {0, -1};     // Also with duplicate keys.
+        }
+    }  // namespace dispatch_map_impl
+
+    template< class Signature, class... Entries > class Dispatch_map_;
+
+    template< class Result, class Key, class... Args, class... Entries >
+    class Dispatch_map_<Result( Key, Args... ), Entries...>
+    {
+        using Handler_ptr = auto (*)( Args... ) -> optional<Result>;
+        using Hash_params = dispatch_map_impl::Hash_params;
+
+        struct Slot
+        {
+            uint32_t        key;
+            Handler_ptr     handler;        // `nullptr` for an unused slot.
+        };
+
+        static constexpr int n_entries = sizeof...( Entries );
+
+        static constexpr array<uint32_t, n_entries> keys = { uint32_t( Entries::key )... };
+        static constexpr Hash_params hash_params = dispatch_map_impl::perfect_hash_params_for<n_entries>( keys );
+        static_assert( hash_params.n_bits >= 0, "Duplicate keys, or no perfect hash found for the keys." );
+
+        static constexpr int n_slots = 1 << (hash_params.n_bits < 0? 0 : hash_params.n_bits);
+
+        template< auto handler >
+        static auto call( Args... args )
+            -> optional<Result>
+        {
+            using Handler_result = invoke_result_t<decltype( handler ), Args...>;
+            if constexpr( is_void_v<Handler_result> ) {
+                handler( args... );
+                return Result{};
+            } else {
+                return handler( args... );
+            }
+        }
+
+        static constexpr auto slots_table()
+            -> array<Slot, n_slots>
+        {
+            array<Slot, n_slots> result = {};
+            const Slot entries[] = { Slot{ uint32_t( Entries::key ), &call<Entries::handler> }..., Slot{} };
+            for( const int i: zero_to( n_entries ) ) {
+                result[dispatch_map_impl::slot_of( entries[i].key, hash_params )] = entries[i];
+            }
+            return result;
+        }
+
+        static constexpr array<Slot, n_slots> slots = slots_table();
+
+    public:
+        static constexpr auto size()        -> int { return n_entries; }
+        static constexpr auto table_size()  -> int { return n_slots; }
+
+        static constexpr auto has( const Key key )
+            -> bool
+        {
+            const Slot& slot = slots[dispatch_map_impl::slot_of( uint32_t( key ), hash_params )];
+            return slot.handler != nullptr and slot.key == uint32_t( key );
+        }
+
+        // An empty result if there's no handler for the key or the handler didn't handle it.
+        static auto dispatch( const Key key, Args... args )
+            -> optional<Result>
+        {
+            const Slot& slot = slots[dispatch_map_impl::slot_of( uint32_t( key ), hash_params )];
+            if( slot.handler == nullptr or slot.key != uint32_t( key ) ) {
+                return {};
+            }
+            return slot.handler( args... );
+        }
+    };
+
+}  // namespace support_machinery
@@ -0,0 +1,150 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Frame pacing against a monotonic clock, for animations.
+//
+// Frame number `k` is due at `start + k/fps` seconds, computed from the start each time so
+// that rounding doesn't accumulate as drift. A tick that comes after several deadlines
+// advances to the latest due frame, and the frames in between are counted as dropped instead
+// of being shown late. The lateness of each tick relative to its frame's deadline is recorded
+// in a jitter histogram.
+
+#include <microlib/support-machinery/exception-handling.hpp>    // hopefully, SM_FAIL
+#include <microlib/support-machinery/Interval_.hpp>             // zero_to
+
+#include <stdint.h>         // int64_t
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+namespace support_machinery {
+    using   std::optional,
+            std::vector;
+    namespace chrono = std::chrono;
+
+    // Counts of durations in equal width buckets. The last bucket also counts all longer ones.
+    class Jitter_histogram
+    {
+    public:
+        using Duration = chrono::steady_clock::duration;
+
+    private:
+        Duration            m_bucket_width;
+        vector<int64_t>     m_counts;
+        int64_t             m_n_samples;
+        Duration            m_max;
+
+    public:
+        Jitter_histogram( const Duration bucket_width = chrono::microseconds( 250 ), const int n_buckets = 32 ):
+            m_bucket_width( bucket_width ), m_counts( n_buckets ), m_n_samples( 0 ), m_max( 0 )
+        {
+            hopefully( bucket_width > Duration::zero() and n_buckets > 0 )
+                or SM_FAIL( "A jitter histogram needs a positive bucket width and bucket count." );
+        }
+
+        auto bucket_width() const   -> Duration { return m_bucket_width; }
+        auto n_buckets() const      -> int      { return static_cast<int>( m_counts.size() ); }
+        auto count( const int i ) const -> int64_t  { return m_counts.at( i ); }
+        auto n_samples() const      -> int64_t  { return m_n_samples; }
+        auto max() const            -> Duration { return m_max; }
+
+        void add( const Duration d )
+        {
+            const int64_t i = (d <= Duration::zero()? 0 : d/m_bucket_width);
+            ++m_counts[i < n_buckets()? static_cast<int>( i ) : n_buckets() - 1];
+            ++m_n_samples;
+            if( d > m_max ) { m_max = d; }
+        }
+
+        // The upper bound of the bucket where the `fraction` of samples is reached, e.g. 0.99.
+        auto percentile( const double fraction ) const
+            -> Duration
+        {
+            const auto n_wanted = static_cast<int64_t>( fraction*m_n_samples );
+            int64_t n_so_far = 0;
+            for( const int i: zero_to( n_buckets() ) ) {
+                n_so_far += m_counts[i];
+                if( n_so_far >= n_wanted and n_so_far > 0 ) {
+                    return (i == n_buckets() - 1? m_max : (i + 1)*m_bucket_width);
+                }
+            }
+            return Duration::zero();
+        }
+
+        void clear()
+        {
+            m_counts.assign( m_counts.size(), 0 );
+            m_n_samples = 0;
+            m_max = Duration::zero();
+        }
+    };
+
+    class Frame_pacer
+    {
+    public:
+        using Clock         = chrono::steady_clock;
+        using Time_point    = Clock::time_point;
+        using Duration      = Clock::duration;
+
+        struct Tick
+        {
+            int64_t     frame_number;       // Frames since the start, including dropped ones.
+            int64_t     n_dropped;          // Frames skipped since the previous tick.
+            Duration    lateness;           // Time since this frame's deadline.
+        };
+
+    private:
+        int                 m_fps;
+        Time_point          m_start;
+        int64_t             m_next_frame_number;
+        int64_t             m_n_dropped;
+        Jitter_histogram    m_jitter;
+
+    public:
+        explicit Frame_pacer( const int fps, const Time_point start = Clock::now() ):
+            m_fps( fps ), m_start( start ), m_next_frame_number( 1 ), m_n_dropped( 0 )
+        {
+            hopefully( fps > 0 ) or SM_FAIL( "A frame pacer needs a positive frame rate." );
+        }
+
+        auto fps() const                -> int                      { return m_fps; }
+        auto start_time() const         -> Time_point               { return m_start; }
+        auto n_dropped() const          -> int64_t                  { return m_n_dropped; }
+        auto jitter() const             -> const Jitter_histogram&  { return m_jitter; }
+
+        auto deadline_of( const int64_t frame_number ) const
+            -> Time_point
+        {
+            const auto ns = chrono::nanoseconds( frame_number*1'000'000'000/m_fps );
+            return m_start + chrono::duration_cast<Duration>( ns );
+        }
+
+        auto next_deadline() const -> Time_point { return deadline_of( m_next_frame_number ); }
+
+        // The latest frame due at `now`, or none for an early wakeup.
+        auto tick( const Time_point now )
+            -> optional<Tick>
+        {
+            if( now < next_deadline() ) {
+                return {};
+            }
+            const int64_t ns_since_start = chrono::duration_cast<chrono::nanoseconds>( now - m_start ).count();
+            int64_t frame_number = ns_since_start*m_fps/1'000'000'000;
+            while( deadline_of( frame_number + 1 ) <= now ) { ++frame_number; }    // Rounding.
+
+            const Tick result = { frame_number, frame_number - m_next_frame_number, now - deadline_of( frame_number ) };
+            m_n_dropped += result.n_dropped;
+            m_jitter.add( result.lateness );
+            m_next_frame_number = frame_number + 1;
+            return result;
+        }
+
+        // Starts over with frame 0 at `start`, keeping the statistics.
+        void restart( const Time_point start = Clock::now() )
+        {
+            m_start = start;
+            m_next_frame_number = 1;
+        }
+    };
+
+}  // namespace support_machinery
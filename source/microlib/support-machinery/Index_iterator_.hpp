@@ -0,0 +1,71 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A random access iterator over a small value type view that computes its items from an index,
+// e.g. the values of a strided integer interval.
+//
+// The `View` provides `size()` and `item( i )`, and a type `Integer` for the index. The iterator
+// holds a copy of the view, so that after inlining the compiler sees the loop as a plain counted
+// loop over `item( i )`, which it can vectorize as it does a raw index loop.
+
+#include <microlib/support-machinery/type-builders.hpp>     // in_
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace support_machinery {
+    using   std::random_access_iterator_tag,        // <iterator>
+            std::make_signed_t,                     // <type_traits>
+            std::declval;                           // <utility>
+
+    template< class View >
+    class Index_iterator_
+    {
+        using Integer = typename View::Integer;
+
+        View        m_view;
+        Integer     m_index;
+
+    public:
+        // Since items are values `operator*` returns a value, not a reference.
+        using iterator_category     = random_access_iterator_tag;
+        using value_type            = decltype( declval<const View&>().item( Integer() ) );
+        using difference_type       = make_signed_t<Integer>;
+        using pointer               = void;
+        using reference             = value_type;
+
+        constexpr Index_iterator_( in_<View> view, const Integer index ):
+            m_view( view ), m_index( index )
+        {}
+
+        constexpr auto index() const -> Integer { return m_index; }
+
+        constexpr auto operator*() const                        -> value_type { return m_view.item( m_index ); }
+        constexpr auto operator[]( const difference_type n ) const  -> value_type { return m_view.item( m_index + n ); }
+
+        constexpr auto operator++() -> Index_iterator_&     { ++m_index;  return *this; }
+        constexpr auto operator--() -> Index_iterator_&     { --m_index;  return *this; }
+        constexpr auto operator++( int ) -> Index_iterator_ { Index_iterator_ result = *this;  ++m_index;  return result; }
+        constexpr auto operator--( int ) -> Index_iterator_ { Index_iterator_ result = *this;  --m_index;  return result; }
+
+        constexpr auto operator+=( const difference_type n ) -> Index_iterator_&    { m_index += n;  return *this; }
+        constexpr auto operator-=( const difference_type n ) -> Index_iterator_&    { m_index -= n;  return *this; }
+
+        friend constexpr auto operator+( Index_iterator_ it, const difference_type n )  -> Index_iterator_ { return it += n; }
+        friend constexpr auto operator+( const difference_type n, Index_iterator_ it )  -> Index_iterator_ { return it += n; }
+        friend constexpr auto operator-( Index_iterator_ it, const difference_type n )  -> Index_iterator_ { return it -= n; }
+
+        // Iterators are compared by index only, so they should be of the same view.
+        friend constexpr auto operator-( in_<Index_iterator_> a, in_<Index_iterator_> b )
+            -> difference_type
+        { return difference_type( a.m_index ) - difference_type( b.m_index ); }
+
+        friend constexpr auto operator==( in_<Index_iterator_> a, in_<Index_iterator_> b ) -> bool { return a.m_index == b.m_index; }
+        friend constexpr auto operator!=( in_<Index_iterator_> a, in_<Index_iterator_> b ) -> bool { return a.m_index != b.m_index; }
+        friend constexpr auto operator<( in_<Index_iterator_> a, in_<Index_iterator_> b )  -> bool { return a.m_index < b.m_index; }
+        friend constexpr auto operator<=( in_<Index_iterator_> a, in_<Index_iterator_> b ) -> bool { return a.m_index <= b.m_index; }
+        friend constexpr auto operator>( in_<Index_iterator_> a, in_<Index_iterator_> b )  -> bool { return a.m_index > b.m_index; }
+        friend constexpr auto operator>=( in_<Index_iterator_> a, in_<Index_iterator_> b ) -> bool { return a.m_index >= b.m_index; }
+    };
+
+}  // namespace support_machinery
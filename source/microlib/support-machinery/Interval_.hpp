@@ -1,16 +1,85 @@
 ﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
 
-// An integer interval with inclusive limits.
+// An integer interval with inclusive limits, iterable as is, or as views that step by a stride,
+// go in reverse or give successive sub-intervals, e.g. `for( const int i: zero_to( n ).reversed() )`.
 // Note 1: a /time/ interval is called a “duration”, e.g. `std::chrono::duration`.
 // Note 2: the `zero_to` function can alternatively be expressed via `std::views::iota`.
+//
+// All iterators are `Index_iterator_`s, which the compiler sees through, so loops over the views
+// are optimized like the corresponding raw index loops, including vectorization.
 
+#include <microlib/support-machinery/Index_iterator_.hpp>   // Index_iterator_
 #include <microlib/support-machinery/type-builders.hpp>
 
+#include <assert.h>         // assert
+
+#include <type_traits>
+
 namespace support_machinery{
+    using   std::make_signed_t;         // <type_traits>
 
-    template< class Integer >
+    template< class Integer > struct Interval_;
+
+    // The `n_values` values `first`, `first + stride`, `first + 2*stride` and so on. The stride
+    // is signed also for an unsigned `Integer`, where the arithmetic is modular, so that e.g.
+    // `zero_to( size_t( n ) ).reversed()` works.
+    template< class tp_Integer >
+    struct Strided_interval_
+    {
+        using Integer = tp_Integer;
+        using Stride = make_signed_t<Integer>;
+        using Iterator = Index_iterator_<Strided_interval_>;
+
+        Integer         first;
+        Stride          stride;             // May be negative.
+        Integer         n_values;
+
+        constexpr auto size() const                 -> Integer      { return n_values; }
+        constexpr auto item( const Integer i ) const -> Integer     { return static_cast<Integer>( first + i*stride ); }
+        constexpr auto operator[]( const Integer i ) const -> Integer { return item( i ); }
+
+        constexpr auto reversed() const
+            -> Strided_interval_
+        { return {item( n_values - 1 ), -stride, n_values}; }
+
+        constexpr auto begin() const    -> Iterator     { return Iterator( *this, 0 ); }
+        constexpr auto end() const      -> Iterator     { return Iterator( *this, n_values ); }
+    };
+
+    // The `n_chunks` successive sub-intervals of length `chunk_length` of `first` through `last`,
+    // except that the last may be shorter.
+    template< class tp_Integer >
+    struct Chunked_interval_
+    {
+        using Integer = tp_Integer;
+        using Iterator = Index_iterator_<Chunked_interval_>;
+
+        Integer         first;
+        Integer         last;
+        Integer         chunk_length;
+        Integer         n_chunks;
+
+        constexpr auto size() const                 -> Integer      { return n_chunks; }
+
+        constexpr auto item( const Integer i ) const
+            -> Interval_<Integer>
+        {
+            const Integer chunk_first = first + i*chunk_length;
+            return Interval_<Integer>( chunk_first, (last - chunk_first < chunk_length? last : chunk_first + chunk_length - 1) );
+        }
+
+        constexpr auto operator[]( const Integer i ) const -> Interval_<Integer> { return item( i ); }
+
+        constexpr auto begin() const    -> Iterator     { return Iterator( *this, 0 ); }
+        constexpr auto end() const      -> Iterator     { return Iterator( *this, n_chunks ); }
+    };
+
+    template< class tp_Integer >
     struct Interval_
     {
+        using Integer = tp_Integer;
+        using Iterator = Index_iterator_<Interval_>;
+
         Integer         first;
         Integer         last;
 
@@ -21,47 +90,42 @@ namespace support_machinery{
         constexpr auto contains( const Integer v ) const
             -> bool
         { return (first <= v and v <= last); }
-            
+
         constexpr auto length() const -> Integer { return (last - first) + 1; }
-        
-        class Iterator
+
+        // As `length()`, but 0 also for an interval with `last < first - 1`.
+        constexpr auto size() const                     -> Integer  { return (last < first? 0 : length()); }
+        constexpr auto item( const Integer i ) const    -> Integer  { return first + i; }
+
+        // The values `first`, `first + stride` and so on up to at most `last`.
+        constexpr auto by_stride( const Integer stride ) const
+            -> Strided_interval_<Integer>
+        {
+            assert( stride > 0 );
+            return {first, static_cast<make_signed_t<Integer>>( stride ), (size() == 0? 0 : (last - first)/stride + 1)};
+        }
+
+        constexpr auto reversed() const
+            -> Strided_interval_<Integer>
+        { return {last, -1, size()}; }
+
+        constexpr auto chunked( const Integer chunk_length ) const
+            -> Chunked_interval_<Integer>
         {
-            Integer     m_current;
-            
-        public:
-            constexpr Iterator( const Integer first ):
-                m_current( first )
-            {}
-            
-            constexpr auto operator*() const -> Integer { return m_current; }
-            
-            constexpr auto operator++()
-                -> Iterator&
-            {
-                ++m_current;
-                return *this;
-            }
-            
-            friend
-            constexpr auto operator==( in_<Iterator> a, in_<Iterator> b )
-                -> bool
-            { return (a.m_current == b.m_current); }
-
-            friend
-            constexpr auto operator!=( in_<Iterator> a, in_<Iterator> b )
-                -> bool
-            { return not( a == b ); }
-        };
-        
-        constexpr auto begin() const    -> Iterator     { return Iterator( first ); }
-        constexpr auto end() const      -> Iterator     { return Iterator( last + 1 ); }
+            assert( chunk_length > 0 );
+            const Integer n = size();
+            return {first, last, chunk_length, (n == 0? 0 : (n - 1)/chunk_length + 1)};
+        }
+
+        constexpr auto begin() const    -> Iterator     { return Iterator( *this, 0 ); }
+        constexpr auto end() const      -> Iterator     { return Iterator( *this, size() ); }
     };
 
     using   Interval    = Interval_<int>;
 
 
     //------------------------------- Convenience functions:
-    
+
     template< class Integer >
     constexpr auto is_in( in_<Interval_<Integer>> interval, const Integer value )
         -> bool
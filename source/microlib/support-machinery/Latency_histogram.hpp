@@ -0,0 +1,211 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Latency histograms with HDR-style log-linear buckets: each power of 2 range of nanoseconds
+// is split into 16 buckets, so a reported value is within about 6% of the real one, from
+// 1 ns up to 2⁴⁰ ns, about 18 minutes. Recording is a few integer operations, no allocation.
+//
+// A `Latency_table` has one histogram per integer id, e.g. per window message id, in a fixed
+// size open addressing table that's allocated up front. Ids beyond its capacity are lumped
+// together as id `Latency_table::other_id`.
+
+#include <microlib/support-machinery/Interval_.hpp>         // zero_to
+#include <microlib/support-machinery/type-builders.hpp>     // in_
+
+#include <stdint.h>         // int64_t, uint32_t, uint64_t
+#include <stdio.h>          // FILE, fprintf
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace support_machinery {
+    using   std::min, std::max, std::sort,      // <algorithm>
+            std::array,
+            std::function,                      // <functional>
+            std::string,
+            std::vector;
+
+    class Latency_histogram
+    {
+    public:
+        static constexpr int        sub_bucket_bits     = 4;
+        static constexpr int        n_sub_buckets       = 1 << sub_bucket_bits;
+        static constexpr int        max_value_bits      = 40;
+        static constexpr int64_t    max_trackable       = (int64_t( 1 ) << max_value_bits) - 1;
+        static constexpr int        n_buckets           = 2*n_sub_buckets + (max_value_bits - sub_bucket_bits - 1)*n_sub_buckets;
+
+    private:
+        array<uint32_t, n_buckets>  m_counts;
+        int64_t                     m_n_samples;
+        int64_t                     m_sum;
+        int64_t                     m_min;
+        int64_t                     m_max;
+
+        static auto bit_width_of( const uint64_t v )
+            -> int
+        {
+            #if defined( __GNUC__ )
+                return (v == 0? 0 : 64 - __builtin_clzll( v ));
+            #else
+                int result = 0;
+                for( uint64_t bits = v; bits != 0; bits >>= 1 ) { ++result; }
+                return result;
+            #endif
+        }
+
+    public:
+        Latency_histogram(): m_counts(), m_n_samples( 0 ), m_sum( 0 ), m_min( 0 ), m_max( 0 ) {}
+
+        static auto bucket_index_of( const int64_t ns )
+            -> int
+        {
+            const auto v = static_cast<uint64_t>( ns < 0? 0 : ns > max_trackable? max_trackable : ns );
+            if( v < 2*n_sub_buckets ) {
+                return static_cast<int>( v );       // Exact.
+            }
+            const int magnitude = bit_width_of( v ) - (sub_bucket_bits + 1);   // At least 1.
+            const int top_bits = static_cast<int>( v >> magnitude );           // 16 through 31.
+            return 2*n_sub_buckets + (magnitude - 1)*n_sub_buckets + (top_bits - n_sub_buckets);
+        }
+
+        // The smallest value in the bucket.
+        static auto lowest_value_in( const int i_bucket )
+            -> int64_t
+        {
+            if( i_bucket < 2*n_sub_buckets ) {
+                return i_bucket;
+            }
+            const int magnitude = (i_bucket - 2*n_sub_buckets)/n_sub_buckets + 1;
+            const int top_bits = (i_bucket - 2*n_sub_buckets)%n_sub_buckets + n_sub_buckets;
+            return int64_t( top_bits ) << magnitude;
+        }
+
+        static auto highest_value_in( const int i_bucket )
+            -> int64_t
+        { return (i_bucket + 1 == n_buckets? max_trackable : lowest_value_in( i_bucket + 1 ) - 1); }
+
+        void record( const int64_t ns )
+        {
+            ++m_counts[bucket_index_of( ns )];
+            m_min = (m_n_samples == 0? ns : min( m_min, ns ));
+            m_max = (m_n_samples == 0? ns : max( m_max, ns ));
+            ++m_n_samples;
+            m_sum += ns;
+        }
+
+        auto n_samples() const  -> int64_t  { return m_n_samples; }
+        auto sum() const        -> int64_t  { return m_sum; }
+        auto min_value() const  -> int64_t  { return m_min; }
+        auto max_value() const  -> int64_t  { return m_max; }
+
+        auto count( const int i_bucket ) const -> int64_t { return m_counts[i_bucket]; }
+
+        auto mean() const
+            -> double
+        { return (m_n_samples == 0? 0.0 : double( m_sum )/m_n_samples); }
+
+        // An upper bound, within the bucket resolution, of the `fraction` of values, e.g. 0.99.
+        auto value_at( const double fraction ) const
+            -> int64_t
+        {
+            if( m_n_samples == 0 ) {
+                return 0;
+            }
+            const auto n_wanted = max<int64_t>( 1, static_cast<int64_t>( fraction*m_n_samples + 0.5 ) );
+            int64_t n_so_far = 0;
+            for( const int i: zero_to( n_buckets ) ) {
+                n_so_far += m_counts[i];
+                if( n_so_far >= n_wanted ) {
+                    return min( highest_value_in( i ), m_max );
+                }
+            }
+            return m_max;
+        }
+    };
+
+    class Latency_table
+    {
+    public:
+        static constexpr uint32_t   other_id    = uint32_t( -1 );
+
+    private:
+        struct Entry
+        {
+            uint32_t            id;
+            bool                is_used;
+            Latency_histogram   histogram;
+        };
+
+        vector<Entry>       m_entries;      // Fixed size, the last one for `other_id`.
+
+        auto n_slots() const -> int { return static_cast<int>( m_entries.size() ) - 1; }
+
+    public:
+        explicit Latency_table( const int n_ids = 64 ):
+            m_entries( n_ids + 1 )
+        {
+            m_entries.back().id = other_id;
+        }
+
+        void record( const uint32_t id, const int64_t ns )
+        {
+            const int n = n_slots();
+            const int i_start = static_cast<int>( id*2654435761u % unsigned( n ) );    // Fibonacci hashing.
+            for( const int n_probes: zero_to( n ) ) {
+                Entry& entry = m_entries[(i_start + n_probes) % n];
+                if( not entry.is_used ) {
+                    entry.id = id;
+                    entry.is_used = true;
+                }
+                if( entry.id == id ) {
+                    entry.histogram.record( ns );
+                    return;
+                }
+            }
+            m_entries.back().histogram.record( ns );
+        }
+
+        auto histogram_for( const uint32_t id ) const
+            -> const Latency_histogram*
+        {
+            for( const Entry& entry: m_entries ) {
+                if( (entry.is_used or entry.id == other_id) and entry.id == id ) { return &entry.histogram; }
+            }
+            return nullptr;
+        }
+
+        // Calls `f( id, histogram )` for each id with samples, most total time first.
+        template< class Func >
+        void for_each( const Func& f ) const
+        {
+            vector<const Entry*> entries;
+            for( const Entry& entry: m_entries ) {
+                if( entry.histogram.n_samples() > 0 ) { entries.push_back( &entry ); }
+            }
+            sort( entries.begin(), entries.end(), []( const Entry* a, const Entry* b ) {
+                return a->histogram.sum() > b->histogram.sum();
+            } );
+            for( const Entry* p: entries ) { f( p->id, p->histogram ); }
+        }
+
+        // Times in µs, except the total in ms.
+        void write_summary_to( FILE* const f, const function<string( uint32_t )>& name_of ) const
+        {
+            fprintf( f, "%-24s %10s %10s %10s %10s %10s %12s\n",
+                "Id", "Count", "Mean", "p50", "p99", "Max", "Total"
+                );
+            for_each( [&]( const uint32_t id, in_<Latency_histogram> h )
+            {
+                const string name = (id == other_id? string( "(other)" ) : name_of( id ));
+                fprintf( f, "%-24s %10lld %10.1f %10.1f %10.1f %10.1f %12.2f\n",
+                    name.c_str(), static_cast<long long>( h.n_samples() ),
+                    h.mean()/1e3, h.value_at( 0.5 )/1e3, h.value_at( 0.99 )/1e3, h.max_value()/1e3,
+                    h.sum()/1e6
+                    );
+            } );
+        }
+    };
+
+}  // namespace support_machinery
@@ -0,0 +1,105 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A bounded key → value cache that discards the least recently used entry when full.
+//
+// Values are constructed in place and never moved or copied, so they can be non-movable
+// resource owners such as `winapi::Unique_handle_`. A discarded value is destroyed at once.
+
+#include <microlib/support-machinery/exception-handling.hpp>    // hopefully, SM_FAIL
+#include <microlib/support-machinery/type-builders.hpp>         // in_, ref_
+
+#include <stdint.h>         // int64_t
+
+#include <functional>       // std::hash
+#include <list>
+#include <unordered_map>
+
+namespace support_machinery {
+    using   std::hash,              // <functional>
+            std::list,
+            std::unordered_map;
+
+    struct Cache_stats
+    {
+        int64_t     n_hits          = 0;
+        int64_t     n_misses        = 0;
+        int64_t     n_evictions     = 0;
+    };
+
+    template< class Key, class Value, class Key_hash = hash<Key> >
+    class Lru_cache_
+    {
+        struct Entry
+        {
+            Key         key;
+            Value       value;
+
+            template< class Factory >
+            Entry( in_<Key> a_key, Factory& make_value ):
+                key( a_key ), value( make_value() )     // Guaranteed copy elision for a prvalue.
+            {}
+        };
+
+        using Entries = list<Entry>;        // Most recently used first.
+
+        int                                                             m_capacity;
+        Entries                                                         m_entries;
+        unordered_map<Key, typename Entries::iterator, Key_hash>        m_index;
+        Cache_stats                                                     m_stats;
+
+    public:
+        explicit Lru_cache_( const int capacity ):
+            m_capacity( capacity )
+        {
+            hopefully( capacity > 0 ) or SM_FAIL( "An LRU cache capacity must be positive." );
+            m_index.reserve( capacity + 1 );
+        }
+
+        auto capacity() const   -> int                  { return m_capacity; }
+        auto size() const       -> int                  { return static_cast<int>( m_index.size() ); }
+        auto stats() const      -> const Cache_stats&   { return m_stats; }
+
+        auto contains( in_<Key> key ) const
+            -> bool
+        { return m_index.count( key ) > 0; }
+
+        // Returns the cached value for `key`, or else the value from `make_value()`, which is cached.
+        // The reference is valid until the entry is evicted or the cache is cleared.
+        template< class Factory >
+        auto get_or_make( in_<Key> key, Factory&& make_value )
+            -> ref_<Value>
+        {
+            const auto it_index = m_index.find( key );
+            if( it_index != m_index.end() ) {
+                ++m_stats.n_hits;
+                const auto it_entry = it_index->second;
+                if( it_entry != m_entries.begin() ) {
+                    m_entries.splice( m_entries.begin(), m_entries, it_entry );
+                }
+                return it_entry->value;
+            }
+
+            ++m_stats.n_misses;
+            m_entries.emplace_front( key, make_value );     // If this throws nothing's changed.
+            try {
+                m_index.emplace( key, m_entries.begin() );
+            } catch( ... ) {
+                m_entries.pop_front();
+                throw;
+            }
+            if( size() > m_capacity ) {
+                m_index.erase( m_entries.back().key );
+                m_entries.pop_back();
+                ++m_stats.n_evictions;
+            }
+            return m_entries.front().value;
+        }
+
+        void clear()
+        {
+            m_index.clear();
+            m_entries.clear();
+        }
+    };
+
+}  // namespace support_machinery
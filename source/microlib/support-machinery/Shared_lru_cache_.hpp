@@ -0,0 +1,179 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A bounded, thread safe key → shared value cache for resources such as fonts, that can still
+// be in use, e.g. by windows, after they're evicted or invalidated.
+//
+// A lookup that hits takes only a shared lock, and marks the entry as recently used with an
+// atomic store. A miss takes an exclusive lock, makes the value, and evicts the least recently
+// used entry if the cache is full. An evicted value is not released at once but retired, and the
+// retired values are released by `release_retired()`, or the oldest one when there are `max_retired`
+// of them, by default `capacity`. `invalidate()` and `take_retired()` give the caller the values, to
+// release when they're unused.
+
+#include <microlib/support-machinery/exception-handling.hpp>    // hopefully, SM_FAIL
+#include <microlib/support-machinery/Lru_cache_.hpp>            // Cache_stats
+#include <microlib/support-machinery/misc.hpp>                  // Non_copyable
+#include <microlib/support-machinery/type-builders.hpp>         // in_
+
+#include <stdint.h>         // int64_t
+
+#include <atomic>
+#include <functional>       // std::hash
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace support_machinery {
+    using   std::atomic,                                // <atomic>
+            std::hash,                                  // <functional>
+            std::shared_ptr, std::make_shared,          // <memory>
+            std::unique_lock,                           // <mutex>
+            std::shared_mutex, std::shared_lock,        // <shared_mutex>
+            std::unordered_map,
+            std::move,                                  // <utility>
+            std::vector;
+
+    template< class Key, class Value, class Key_hash = hash<Key> >
+    class Shared_lru_cache_:
+        public Non_copyable
+    {
+        struct Entry
+        {
+            shared_ptr<const Value>     p_value;
+            atomic<int64_t>             last_use;
+
+            Entry( shared_ptr<const Value> a_p_value, const int64_t a_use ):
+                p_value( move( a_p_value ) ), last_use( a_use )
+            {}
+        };
+
+        int                                                 m_capacity;
+        int                                                 m_max_retired;
+        mutable shared_mutex                                m_mutex;
+        unordered_map<Key, Entry, Key_hash>                 m_entries;
+        vector<shared_ptr<const Value>>                     m_retired;          // At most `m_max_retired`.
+        mutable atomic<int64_t>                             m_clock;
+        mutable atomic<int64_t>                             m_n_hits;
+        int64_t                                             m_n_misses;         // Guarded by the exclusive lock.
+        int64_t                                             m_n_evictions;      // Guarded by the exclusive lock.
+
+        void retire_lru_entry()
+        {
+            auto it_lru = m_entries.begin();
+            for( auto it = m_entries.begin(); it != m_entries.end(); ++it ) {
+                if( it->second.last_use.load( std::memory_order_relaxed )
+                        < it_lru->second.last_use.load( std::memory_order_relaxed ) ) {
+                    it_lru = it;
+                }
+            }
+            if( static_cast<int>( m_retired.size() ) >= m_max_retired ) {
+                m_retired.erase( m_retired.begin() );
+            }
+            m_retired.push_back( move( it_lru->second.p_value ) );
+            m_entries.erase( it_lru );
+            ++m_n_evictions;
+        }
+
+    public:
+        Shared_lru_cache_( const int capacity, const int max_retired ):
+            m_capacity( capacity ), m_max_retired( max_retired ),
+            m_clock( 0 ), m_n_hits( 0 ), m_n_misses( 0 ), m_n_evictions( 0 )
+        {
+            hopefully( capacity > 0 ) or SM_FAIL( "A cache capacity must be positive." );
+            hopefully( max_retired > 0 ) or SM_FAIL( "A cache must be able to retire a value." );
+            m_entries.reserve( capacity + 1 );
+        }
+
+        explicit Shared_lru_cache_( const int capacity ):
+            Shared_lru_cache_( capacity, capacity )
+        {}
+
+        auto capacity() const -> int { return m_capacity; }
+
+        auto size() const
+            -> int
+        {
+            const shared_lock<shared_mutex> lock( m_mutex );
+            return static_cast<int>( m_entries.size() );
+        }
+
+        auto n_retired() const
+            -> int
+        {
+            const shared_lock<shared_mutex> lock( m_mutex );
+            return static_cast<int>( m_retired.size() );
+        }
+
+        auto stats() const
+            -> Cache_stats
+        {
+            const shared_lock<shared_mutex> lock( m_mutex );
+            return {m_n_hits.load(), m_n_misses, m_n_evictions};
+        }
+
+        // The cached value for `key`, or else `make_value()`, which is then cached. A value that is
+        // made concurrently by two threads is made only once.
+        template< class Factory >
+        auto get_or_make( in_<Key> key, Factory&& make_value )
+            -> shared_ptr<const Value>
+        {
+            const int64_t now = ++m_clock;
+            {
+                const shared_lock<shared_mutex> lock( m_mutex );
+                const auto it = m_entries.find( key );
+                if( it != m_entries.end() ) {
+                    it->second.last_use.store( now, std::memory_order_relaxed );
+                    ++m_n_hits;
+                    return it->second.p_value;
+                }
+            }
+
+            const unique_lock<shared_mutex> lock( m_mutex );
+            const auto it = m_entries.find( key );      // Possibly made by another thread meanwhile.
+            if( it != m_entries.end() ) {
+                it->second.last_use.store( now, std::memory_order_relaxed );
+                ++m_n_hits;
+                return it->second.p_value;
+            }
+            ++m_n_misses;
+            shared_ptr<const Value> p_value = make_shared<const Value>( make_value() );
+            if( static_cast<int>( m_entries.size() ) >= m_capacity ) {
+                retire_lru_entry();
+            }
+            m_entries.try_emplace( key, p_value, now );
+            return p_value;
+        }
+
+        // Removes all entries, e.g. on a system settings change, and returns their values.
+        auto invalidate()
+            -> vector<shared_ptr<const Value>>
+        {
+            vector<shared_ptr<const Value>> result;
+            const unique_lock<shared_mutex> lock( m_mutex );
+            result.reserve( m_entries.size() );
+            for( auto& [key, entry]: m_entries ) {
+                (void) key;
+                result.push_back( move( entry.p_value ) );
+            }
+            m_entries.clear();
+            return result;
+        }
+
+        // Removes the evicted values, and returns them.
+        auto take_retired()
+            -> vector<shared_ptr<const Value>>
+        {
+            vector<shared_ptr<const Value>> result;
+            const unique_lock<shared_mutex> lock( m_mutex );
+            result.swap( m_retired );
+            return result;
+        }
+
+        // Releases the evicted values. A value is destroyed when the last `shared_ptr` to it is destroyed.
+        void release_retired() { (void) take_retired(); }
+    };
+
+}  // namespace support_machinery
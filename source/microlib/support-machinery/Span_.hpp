@@ -0,0 +1,48 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A non-owning view of a contiguous sequence of items, e.g. the bytes of a memory mapped file.
+// Note: with C++20 and later this can alternatively be expressed via `std::span`.
+
+#include <microlib/support-machinery/basic-types.hpp>       // Size, Index
+#include <microlib/support-machinery/type-builders.hpp>
+
+#include <assert.h>         // assert
+
+namespace support_machinery {
+
+    template< class Item >
+    class Span_
+    {
+        Item*       m_p_first;
+        Size        m_size;
+
+    public:
+        constexpr Span_(): m_p_first( nullptr ), m_size( 0 ) {}
+
+        constexpr Span_( Item* const p_first, const Size size ):
+            m_p_first( p_first ), m_size( size )
+        {}
+
+        constexpr auto data() const     -> Item*    { return m_p_first; }
+        constexpr auto size() const     -> Size     { return m_size; }
+        constexpr auto is_empty() const -> bool     { return (m_size == 0); }
+
+        constexpr auto begin() const    -> Item*    { return m_p_first; }
+        constexpr auto end() const      -> Item*    { return m_p_first + m_size; }
+
+        constexpr auto operator[]( const Index i ) const
+            -> ref_<Item>
+        { return m_p_first[i]; }
+
+        // The part of the span starting at index `i_first`, which must be in range.
+        constexpr auto from( const Index i_first ) const
+            -> Span_
+        {
+            assert( 0 <= i_first and i_first <= m_size );
+            return Span_( m_p_first + i_first, m_size - i_first );
+        }
+    };
+
+    using Byte_span = Span_<const Byte>;
+
+} // namespace support_machinery
@@ -0,0 +1,126 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Interned strings: each distinct string is stored once, null-terminated, in chunks that never
+// move, so the `string_view` that `intern` returns stays valid as long as the interner.
+//
+// Interning a string that's already there is a hash and a table lookup, with no allocation.
+// Nothing is freed before the interner is destroyed, so it's for strings with few distinct
+// values, e.g. window titles, not for unbounded streams of different strings.
+
+#include <microlib/support-machinery/basic-types.hpp>       // Size
+#include <microlib/support-machinery/misc.hpp>              // Non_copyable
+
+#include <stdint.h>         // uint64_t
+#include <string.h>         // memcpy
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace support_machinery {
+    using   std::unique_ptr,                    // <memory>
+            std::string_view,
+            std::vector;
+
+    class String_interner:
+        public Non_copyable
+    {
+        static constexpr Size chunk_size = 4096;
+
+        struct Entry
+        {
+            uint64_t        hash;
+            string_view     s;          // `s.data() == nullptr` for an unused entry.
+        };
+
+        vector<Entry>               m_table;            // Open addressing, power of 2 size.
+        Size                        m_n_strings;
+        vector<unique_ptr<char[]>>  m_chunks;
+        char*                       m_p_free;
+        Size                        m_n_free;
+        Size                        m_n_bytes;
+
+        static auto hash_of( const string_view s )
+            -> uint64_t
+        {
+            uint64_t result = 14695981039346656037u;    // FNV-1a.
+            for( const char ch: s ) {
+                result = (result ^ static_cast<unsigned char>( ch ))*1099511628211u;
+            }
+            return result;
+        }
+
+        auto i_slot_for( const string_view s, const uint64_t hash ) const
+            -> Size
+        {
+            const Size mask = Size( m_table.size() ) - 1;
+            for( Size i = Size( hash ) & mask; ; i = (i + 1) & mask ) {
+                const Entry& entry = m_table[i];
+                if( entry.s.data() == nullptr or (entry.hash == hash and entry.s == s) ) {
+                    return i;
+                }
+            }
+        }
+
+        void grow_table()
+        {
+            vector<Entry> old_table( 2*m_table.size() );
+            old_table.swap( m_table );
+            for( const Entry& entry: old_table ) {
+                if( entry.s.data() ) { m_table[i_slot_for( entry.s, entry.hash )] = entry; }
+            }
+        }
+
+        auto stored( const string_view s )
+            -> string_view
+        {
+            const Size n = Size( s.size() ) + 1;
+            if( n > m_n_free ) {
+                const Size size = (n > chunk_size/4? n : chunk_size);   // A long string gets its own chunk.
+                m_chunks.emplace_back( new char[size] );
+                m_n_bytes += size;
+                if( size == n ) {
+                    char* const p = m_chunks.back().get();
+                    memcpy( p, s.data(), s.size() );
+                    p[s.size()] = '\0';
+                    return string_view( p, s.size() );
+                }
+                m_p_free = m_chunks.back().get();
+                m_n_free = size;
+            }
+            char* const p = m_p_free;
+            memcpy( p, s.data(), s.size() );
+            p[s.size()] = '\0';
+            m_p_free += n;
+            m_n_free -= n;
+            return string_view( p, s.size() );
+        }
+
+    public:
+        String_interner():
+            m_table( 64 ), m_n_strings( 0 ), m_chunks(), m_p_free( nullptr ), m_n_free( 0 ), m_n_bytes( 0 )
+        {}
+
+        auto n_strings() const      -> Size { return m_n_strings; }
+        auto n_bytes() const        -> Size { return m_n_bytes; }       // Allocated for characters.
+
+        // The result's `data()` is null-terminated.
+        auto intern( const string_view s )
+            -> string_view
+        {
+            const uint64_t hash = hash_of( s );
+            Entry& entry = m_table[i_slot_for( s, hash )];
+            if( entry.s.data() ) {
+                return entry.s;
+            }
+            entry = {hash, stored( s )};
+            ++m_n_strings;
+            const string_view result = entry.s;
+            if( 2*m_n_strings > Size( m_table.size() ) ) {
+                grow_table();           // Load factor at most 1/2.
+            }
+            return result;
+        }
+    };
+
+}  // namespace support_machinery
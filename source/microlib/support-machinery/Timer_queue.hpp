@@ -0,0 +1,194 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A heap of timers for an event loop, dispatched in deadline order, with insertion order as
+// tie breaker. Timers can be one-shot or periodic, and can be cancelled, also from a callback.
+// A periodic timer that has fallen behind skips the missed ticks instead of queueing them.
+//
+// The event loop asks for the `next_deadline` to compute its wait timeout, then calls
+// `dispatch_due` after the wait. A callback may run a nested event loop, e.g. a modal dialog's,
+// that calls `dispatch_due` again. Not thread safe: use from the event loop's thread.
+
+#include <microlib/support-machinery/type-builders.hpp>     // in_
+
+#include <stdint.h>         // int64_t
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace support_machinery {
+    using   std::function,                  // <functional>
+            std::optional,
+            std::priority_queue,            // <queue>
+            std::unordered_map,
+            std::move,                      // <utility>
+            std::vector;
+    namespace chrono = std::chrono;
+
+    // Counts for tuning and testing, e.g. that an idle loop doesn't wake up needlessly.
+    struct Event_loop_stats
+    {
+        int64_t     n_wakeups           = 0;
+        int64_t     n_idle_wakeups      = 0;    // Wakeups with nothing dispatched.
+        int64_t     n_messages          = 0;    // Window messages or posted functions.
+        int64_t     n_signals           = 0;    // Signalled waitable objects.
+        int64_t     n_timer_callbacks   = 0;
+    };
+
+    class Timer_queue
+    {
+    public:
+        using Clock         = chrono::steady_clock;
+        using Time_point    = Clock::time_point;
+        using Duration      = Clock::duration;
+        using Id            = int64_t;
+
+    private:
+        struct Timer
+        {
+            function<void()>    callback;
+            Duration            period;         // Zero for a one-shot timer.
+            int                 n_running       = 0;        // Callback calls in progress, nested.
+            bool                is_cancelled    = false;    // Erased when no longer running.
+        };
+
+        struct Deadline
+        {
+            Time_point      time;
+            int64_t         sequence_number;
+            Id              id;
+
+            // For `priority_queue`, which puts the largest at the top.
+            friend auto operator<( in_<Deadline> a, in_<Deadline> b )
+                -> bool
+            {
+                return (a.time != b.time? a.time > b.time : a.sequence_number > b.sequence_number);
+            }
+        };
+
+        // A cancelled timer's deadline stays in the heap until it reaches the top.
+        priority_queue<Deadline>        m_deadlines;
+        unordered_map<Id, Timer>        m_timers;
+        Id                              m_last_id;
+        int64_t                         m_n_scheduled;
+
+        void schedule( const Id id, const Time_point time )
+        {
+            m_deadlines.push( Deadline{ time, m_n_scheduled++, id } );
+        }
+
+        auto is_cancelled( const Id id ) const
+            -> bool
+        {
+            const auto it = m_timers.find( id );
+            return (it == m_timers.end() or it->second.is_cancelled);
+        }
+
+        void drop_cancelled_deadlines()
+        {
+            while( not m_deadlines.empty() and is_cancelled( m_deadlines.top().id ) ) {
+                m_deadlines.pop();
+            }
+        }
+
+    public:
+        Timer_queue():
+            m_last_id( 0 ), m_n_scheduled( 0 )
+        {}
+
+        // Includes cancelled timers whose callbacks are still running.
+        auto n_timers() const -> int { return static_cast<int>( m_timers.size() ); }
+
+        auto add( const Time_point deadline, function<void()> callback, const Duration period = {} )
+            -> Id
+        {
+            const Id id = ++m_last_id;
+            m_timers.emplace( id, Timer{ move( callback ), period } );
+            schedule( id, deadline );
+            return id;
+        }
+
+        auto add_after( const Duration delay, function<void()> callback, const Duration period = {} )
+            -> Id
+        { return add( Clock::now() + delay, move( callback ), period ); }
+
+        auto add_periodic( const Duration period, function<void()> callback )
+            -> Id
+        { return add( Clock::now() + period, move( callback ), period ); }
+
+        // No effect if the timer has already fired (one-shot) or been cancelled. A timer whose
+        // callback is running, e.g. the caller's, is erased when the callback returns.
+        void cancel( const Id id )
+        {
+            const auto it = m_timers.find( id );
+            if( it == m_timers.end() ) {
+                return;
+            }
+            if( it->second.n_running > 0 ) {
+                it->second.is_cancelled = true;
+            } else {
+                m_timers.erase( it );
+            }
+        }
+
+        auto next_deadline()
+            -> optional<Time_point>
+        {
+            drop_cancelled_deadlines();
+            if( m_deadlines.empty() ) {
+                return {};
+            }
+            return m_deadlines.top().time;
+        }
+
+        // Calls the callbacks of the timers with deadline at or before `now`, in deadline order.
+        // An exception from a callback propagates, with the queue left in a consistent state.
+        auto dispatch_due( const Time_point now )
+            -> int
+        {
+            int n_dispatched = 0;
+            for( ;; ) {
+                drop_cancelled_deadlines();
+                if( m_deadlines.empty() or m_deadlines.top().time > now ) {
+                    break;
+                }
+                const Deadline due = m_deadlines.top();
+                m_deadlines.pop();
+                Timer& timer = m_timers.at( due.id );   // References are stable in an `unordered_map`.
+
+                // The timer, and so the running callback, is erased only by the outermost call.
+                struct Dispatch_guard
+                {
+                    Timer_queue&    queue;
+                    const Id        id;
+                    Timer&          timer;
+
+                    ~Dispatch_guard()
+                    {
+                        --timer.n_running;
+                        if( timer.n_running == 0 and timer.is_cancelled ) {
+                            queue.m_timers.erase( id );
+                        }
+                    }
+                };
+
+                if( timer.period == Duration::zero() ) {
+                    timer.is_cancelled = true;              // Fired, so erased after the call.
+                } else {
+                    const Time_point next_time = due.time + timer.period;
+                    schedule( due.id, (next_time > now? next_time : now + timer.period) );
+                }
+                ++timer.n_running;
+                const Dispatch_guard guard{ *this, due.id, timer };
+                ++n_dispatched;
+                timer.callback();
+            }
+            return n_dispatched;
+        }
+    };
+
+}  // namespace support_machinery
@@ -0,0 +1,71 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A lock-free single producer, single consumer channel for the latest value of something,
+// e.g. the progress of some work, where intermediate values can be skipped.
+//
+// There are three slots: the producer's back slot, the consumer's front slot, and a middle
+// slot that they atomically exchange their slot with. So a `publish` never waits for the
+// consumer and never drops the newest value, and `update` always gets a complete value.
+
+#include <microlib/support-machinery/misc.hpp>              // Non_copyable
+#include <microlib/support-machinery/type-builders.hpp>     // in_
+
+#include <atomic>
+
+namespace support_machinery {
+    using   std::atomic;        // <atomic>
+
+    template< class Value >
+    class Triple_buffer_:
+        public Non_copyable
+    {
+        static constexpr unsigned is_fresh = 0b100;     // Combined with a slot index 0 through 2.
+
+        struct alignas( 64 ) Slot{ Value value; };      // In separate cache lines.
+
+        Slot                            m_slots[3];
+        alignas( 64 ) atomic<unsigned>  m_middle;
+        alignas( 64 ) unsigned          m_i_back;       // Used only by the producer.
+        alignas( 64 ) unsigned          m_i_front;      // Used only by the consumer.
+
+    public:
+        Triple_buffer_( in_<Value> initial_value = Value() ):
+            m_slots{ {initial_value}, {initial_value}, {initial_value} },
+            m_middle( 1 ), m_i_back( 0 ), m_i_front( 2 )
+        {}
+
+        //-------------------------------- For the producer thread:
+
+        // The slot to write the next value in, before calling `publish()`.
+        auto back() -> Value& { return m_slots[m_i_back].value; }
+
+        void publish()
+        {
+            const unsigned old_middle = m_middle.exchange( m_i_back | is_fresh, std::memory_order_acq_rel );
+            m_i_back = old_middle & ~is_fresh;
+        }
+
+        void publish( in_<Value> value )
+        {
+            back() = value;
+            publish();
+        }
+
+        //-------------------------------- For the consumer thread:
+
+        // Returns `true` if there was a new value, which is then the `front()`.
+        auto update()
+            -> bool
+        {
+            if( (m_middle.load( std::memory_order_relaxed ) & is_fresh) == 0 ) {
+                return false;
+            }
+            const unsigned old_middle = m_middle.exchange( m_i_front, std::memory_order_acq_rel );
+            m_i_front = old_middle & ~is_fresh;
+            return true;
+        }
+
+        auto front() const -> const Value& { return m_slots[m_i_front].value; }
+    };
+
+}  // namespace support_machinery
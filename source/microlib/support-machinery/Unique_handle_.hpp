@@ -0,0 +1,183 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Move-only owners of handles, e.g. Windows API handles or plain integer file descriptors.
+//
+// The destruction is a stateless policy with static `destroy` and `null_value` functions, so a
+// `Unique_handle_with_` is exactly the size of the handle and the calls are inlined. The policy's
+// null value, by default a default constructed handle value such as 0 or `nullptr`, is the empty
+// state and is not destroyed. For e.g. a file descriptor, where 0 is valid, it's -1.
+//
+// A `Pooled_handle_` instead returns its handle to a `Handle_pool_` for reuse, for handles
+// that are expensive to create and interchangeable, e.g. memory DCs or same size bitmaps.
+
+#include <microlib/support-machinery/exception-handling.hpp>    // hopefully, SM_FAIL
+#include <microlib/support-machinery/type-builders.hpp>         // ref_
+
+#include <utility>
+#include <vector>
+
+namespace support_machinery {
+    using   std::exchange,          // <utility>
+            std::vector;
+
+    // A stateless deleter policy that calls a given function, with `null` as the empty state.
+    template< class Handle, void(*destroy_func)( Handle ), Handle null >
+    struct Destroy_function_with_null_
+    {
+        static auto null_value() -> Handle { return null; }
+        static void destroy( const Handle handle ) { destroy_func( handle ); }
+    };
+
+    // As above, with a default constructed handle value as the empty state.
+    template< class Handle, void(*destroy_func)( Handle ) >
+    struct Destroy_function_
+    {
+        static auto null_value() -> Handle { return Handle(); }
+        static void destroy( const Handle handle ) { destroy_func( handle ); }
+    };
+
+    template< class Handle, class Deleter >
+    class Unique_handle_with_
+    {
+        Handle      m_handle;
+
+    public:
+        ~Unique_handle_with_() { reset(); }
+
+        Unique_handle_with_(): m_handle( Deleter::null_value() ) {}
+        Unique_handle_with_( const Handle handle ): m_handle( handle ) {}
+
+        Unique_handle_with_( Unique_handle_with_&& other ) noexcept:
+            m_handle( other.release() )
+        {}
+
+        auto operator=( Unique_handle_with_&& other ) noexcept
+            -> ref_<Unique_handle_with_>
+        {
+            reset( other.release() );
+            return *this;
+        }
+
+        auto value() const      -> Handle   { return m_handle; }
+        operator Handle() const             { return value(); }
+        auto is_empty() const   -> bool     { return m_handle == Deleter::null_value(); }
+
+        // Relinquishes ownership without destroying the handle.
+        auto release() noexcept
+            -> Handle
+        { return exchange( m_handle, Deleter::null_value() ); }
+
+        void reset( const Handle new_handle = Deleter::null_value() ) noexcept
+        {
+            const Handle old_handle = exchange( m_handle, new_handle );
+            if( old_handle != Deleter::null_value() and old_handle != new_handle ) {
+                Deleter::destroy( old_handle );
+            }
+        }
+    };
+
+    // The original form with the destroy function as template parameter.
+    template< class Handle, void(*destroy)( Handle ) >
+    using Unique_handle_ = Unique_handle_with_<Handle, Destroy_function_<Handle, destroy>>;
+
+
+    //------------------------------------------- Pooling:
+
+    template< class Handle, class Deleter > class Pooled_handle_;
+
+    // Not thread safe. Must outlive the handles acquired from it.
+    template< class Handle, class Deleter >
+    class Handle_pool_
+    {
+        friend class Pooled_handle_<Handle, Deleter>;
+
+        int                 m_max_idle;
+        vector<Handle>      m_idle;
+
+        void recycle( const Handle handle )
+        {
+            if( static_cast<int>( m_idle.size() ) < m_max_idle ) {
+                m_idle.push_back( handle );     // Capacity was reserved, so this doesn't throw.
+            } else {
+                Deleter::destroy( handle );
+            }
+        }
+
+    public:
+        ~Handle_pool_() { clear(); }
+
+        explicit Handle_pool_( const int max_idle ):
+            m_max_idle( max_idle )
+        {
+            hopefully( max_idle >= 0 ) or SM_FAIL( "A handle pool's max idle count can't be negative." );
+            m_idle.reserve( max_idle );
+        }
+
+        Handle_pool_( const Handle_pool_& ) = delete;
+        auto operator=( const Handle_pool_& ) -> Handle_pool_& = delete;
+
+        auto n_idle() const -> int { return static_cast<int>( m_idle.size() ); }
+
+        // An idle handle if there is one, otherwise a new one from `make_handle()`.
+        template< class Factory >
+        auto acquire( Factory&& make_handle )
+            -> Pooled_handle_<Handle, Deleter>
+        {
+            if( m_idle.empty() ) {
+                return Pooled_handle_<Handle, Deleter>( *this, make_handle() );
+            }
+            const Handle handle = m_idle.back();
+            m_idle.pop_back();
+            return Pooled_handle_<Handle, Deleter>( *this, handle );
+        }
+
+        void clear()
+        {
+            for( const Handle handle: m_idle ) { Deleter::destroy( handle ); }
+            m_idle.clear();
+        }
+    };
+
+    template< class Handle, class Deleter >
+    class Pooled_handle_
+    {
+        friend class Handle_pool_<Handle, Deleter>;
+        using Pool = Handle_pool_<Handle, Deleter>;
+
+        Pool*       m_p_pool;
+        Handle      m_handle;
+
+        Pooled_handle_( Pool& pool, const Handle handle ): m_p_pool( &pool ), m_handle( handle ) {}
+
+    public:
+        ~Pooled_handle_() { reset(); }
+
+        Pooled_handle_( Pooled_handle_&& other ) noexcept:
+            m_p_pool( other.m_p_pool ), m_handle( exchange( other.m_handle, Deleter::null_value() ) )
+        {}
+
+        auto operator=( Pooled_handle_&& other ) noexcept
+            -> ref_<Pooled_handle_>
+        {
+            if( &other != this ) {
+                reset();
+                m_p_pool = other.m_p_pool;
+                m_handle = exchange( other.m_handle, Deleter::null_value() );
+            }
+            return *this;
+        }
+
+        auto value() const      -> Handle   { return m_handle; }
+        operator Handle() const             { return value(); }
+        auto is_empty() const   -> bool     { return m_handle == Deleter::null_value(); }
+
+        // Returns the handle to the pool, leaving this empty.
+        void reset() noexcept
+        {
+            if( m_handle != Deleter::null_value() ) {
+                m_p_pool->recycle( exchange( m_handle, Deleter::null_value() ) );
+            }
+        }
+    };
+
+}  // namespace support_machinery
@@ -0,0 +1,117 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Runs some work on a worker thread while e.g. a GUI thread stays responsive.
+//
+// Completion is signalled by calling a given `notify_completion` function on the worker thread,
+// e.g. one that posts a window message, so the waiting thread needn't poll. The waiting thread
+// then calls `finish`, which rethrows any exception from the work. In a window message handler
+// that exception is deferred via `push_current_exception` and rethrown by the message loop.
+//
+// Without a GUI, e.g. in a test driver, `wait` just blocks until the work has completed.
+// For a bounded shutdown, cancel the work via a `Cancellation_token` and use `wait_for`.
+
+#include <microlib/support-machinery/exception-handling.hpp>    // rethrow_exception
+#include <microlib/support-machinery/misc.hpp>                  // Non_copyable
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace support_machinery {
+    using   std::atomic,                                                    // <atomic>
+            std::exception_ptr, std::current_exception, std::rethrow_exception, // <exception>
+            std::condition_variable,                                        // <condition_variable>
+            std::function,                                                  // <functional>
+            std::mutex, std::unique_lock,                                   // <mutex>
+            std::thread,                                                    // <thread>
+            std::move;                                                      // <utility>
+    namespace chrono = std::chrono;
+
+    class Wait_operation:
+        public Non_copyable
+    {
+    public:
+        using Clock = chrono::steady_clock;
+
+    private:
+        atomic<bool>            m_is_completed;
+        exception_ptr           m_exception;
+        Clock::time_point       m_start_time;
+        Clock::time_point       m_completion_time;
+        mutex                   m_completion_mutex;
+        condition_variable      m_completion;
+        thread                  m_worker;           // Last, so it starts with the rest initialized.
+
+        void run( const function<void()>& work, const function<void()>& notify_completion ) noexcept
+        {
+            try {
+                work();
+            } catch( ... ) {
+                m_exception = current_exception();
+            }
+            m_completion_time = Clock::now();
+            {
+                const unique_lock<mutex> lock( m_completion_mutex );
+                m_is_completed.store( true, std::memory_order_release );
+            }
+            m_completion.notify_all();
+            if( notify_completion ) {
+                notify_completion();        // Must not throw.
+            }
+        }
+
+    public:
+        // Blocks until the work has completed; the work should preferably be cancelled first.
+        ~Wait_operation() { wait(); }
+
+        Wait_operation( function<void()> work, function<void()> notify_completion = {} ):
+            m_is_completed( false ),
+            m_start_time( Clock::now() ),
+            m_worker( [this, work = move( work ), notify = move( notify_completion )]() noexcept
+            {
+                run( work, notify );
+            } )
+        {}
+
+        // Can be checked at any time, from any thread.
+        auto is_completed() const
+            -> bool
+        { return m_is_completed.load( std::memory_order_acquire ); }
+
+        void wait()
+        {
+            if( m_worker.joinable() ) { m_worker.join(); }
+        }
+
+        // Returns `true` if the work completed within the timeout.
+        auto wait_for( const Clock::duration timeout )
+            -> bool
+        {
+            {
+                unique_lock<mutex> lock( m_completion_mutex );
+                if( not m_completion.wait_for( lock, timeout, [this]{ return is_completed(); } ) ) {
+                    return false;
+                }
+            }
+            wait();     // Just the thread's exit.
+            return true;
+        }
+
+        // Waits for completion, then rethrows any exception from the work.
+        void finish()
+        {
+            wait();
+            if( m_exception ) { rethrow_exception( m_exception ); }
+        }
+
+        // Valid after completion. E.g. `Clock::now() - completion_time()` is the wake-up latency.
+        auto start_time() const         -> Clock::time_point    { return m_start_time; }
+        auto completion_time() const    -> Clock::time_point    { return m_completion_time; }
+    };
+
+}  // namespace support_machinery
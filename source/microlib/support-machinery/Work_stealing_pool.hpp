@@ -0,0 +1,212 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A small pool of threads for parallel loops, e.g. over the tiles of an image, where
+// `pool.for_each_index( n, f )` calls `f( i )` for every `i` in [0, n) and returns when all
+// calls have completed. The calling thread takes part in the work.
+//
+// The indices are initially divided evenly between the threads. Each thread takes indices from
+// the front of its own range, and when that's exhausted it steals the back half of another
+// thread's range. A range is a single atomic 64-bit value, so both are a compare-and-swap.
+// An exception from `f` stops further calls, and the first one is rethrown by `for_each_index`.
+
+#include <microlib/support-machinery/Interval_.hpp>             // zero_to, one_through
+#include <microlib/support-machinery/misc.hpp>                  // Non_copyable
+
+#include <stdint.h>         // int64_t, uint32_t, uint64_t
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace support_machinery {
+    using   std::clamp, std::max,                                           // <algorithm>
+            std::atomic,                                                    // <atomic>
+            std::condition_variable,                                        // <condition_variable>
+            std::exception_ptr, std::current_exception, std::rethrow_exception, // <exception>
+            std::unique_ptr,                                                // <memory>
+            std::mutex, std::unique_lock,                                   // <mutex>
+            std::thread,                                                    // <thread>
+            std::vector;
+
+    class Work_stealing_pool:
+        public Non_copyable
+    {
+        struct alignas( 64 ) Range
+        {
+            atomic<uint64_t>    bits;       // The first index in the high half, beyond in the low.
+        };
+
+        static auto packed( const uint32_t first, const uint32_t beyond )
+            -> uint64_t
+        { return (uint64_t( first ) << 32) | beyond; }
+
+        static auto first_of( const uint64_t bits )     -> uint32_t { return uint32_t( bits >> 32 ); }
+        static auto beyond_of( const uint64_t bits )    -> uint32_t { return uint32_t( bits ); }
+
+        int                             m_n_threads;        // Including the calling thread.
+        unique_ptr<Range[]>             m_ranges;           // Index 0 is the calling thread's.
+        const void*                     m_p_func;
+        void                          (*m_call)( const void* p_func, int i );
+        atomic<bool>                    m_is_failed;
+        atomic<int64_t>                 m_n_steals;
+
+        mutex                           m_mutex;            // Guards the rest.
+        condition_variable              m_job_posted;
+        condition_variable              m_job_done;
+        int64_t                         m_job_number;
+        int                             m_n_busy_workers;
+        bool                            m_is_stopping;
+        exception_ptr                   m_exception;
+        vector<thread>                  m_workers;          // Last, so they start with the rest initialized.
+
+        auto claimed_index( const int i_thread, int& i_claimed )
+            -> bool
+        {
+            atomic<uint64_t>& range = m_ranges[i_thread].bits;
+            uint64_t bits = range.load( std::memory_order_acquire );
+            while( first_of( bits ) < beyond_of( bits ) ) {
+                if( range.compare_exchange_weak( bits, packed( first_of( bits ) + 1, beyond_of( bits ) ),
+                        std::memory_order_acq_rel, std::memory_order_acquire ) ) {
+                    i_claimed = int( first_of( bits ) );
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Moves the back half of some other thread's range to the thief's own, empty, range.
+        auto stole_work( const int i_thief )
+            -> bool
+        {
+            for( const int offset: one_through( m_n_threads - 1 ) ) {
+                atomic<uint64_t>& victim = m_ranges[(i_thief + offset) % m_n_threads].bits;
+                uint64_t bits = victim.load( std::memory_order_acquire );
+                while( first_of( bits ) < beyond_of( bits ) ) {
+                    const uint32_t n_stolen = (beyond_of( bits ) - first_of( bits ) + 1)/2;
+                    const uint32_t new_beyond = beyond_of( bits ) - n_stolen;
+                    if( victim.compare_exchange_weak( bits, packed( first_of( bits ), new_beyond ),
+                            std::memory_order_acq_rel, std::memory_order_acquire ) ) {
+                        m_ranges[i_thief].bits.store( packed( new_beyond, new_beyond + n_stolen ), std::memory_order_release );
+                        m_n_steals.fetch_add( 1, std::memory_order_relaxed );
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        void take_part( const int i_thread ) noexcept
+        {
+            int i;
+            do {
+                while( not m_is_failed.load( std::memory_order_relaxed ) and claimed_index( i_thread, i ) ) {
+                    try {
+                        m_call( m_p_func, i );
+                    } catch( ... ) {
+                        const unique_lock<mutex> lock( m_mutex );
+                        if( not m_exception ) { m_exception = current_exception(); }
+                        m_is_failed.store( true, std::memory_order_relaxed );
+                    }
+                }
+            } while( not m_is_failed.load( std::memory_order_relaxed ) and stole_work( i_thread ) );
+        }
+
+        void serve( const int i_thread ) noexcept
+        {
+            int64_t last_job_number = 0;
+            for( ;; ) {
+                {
+                    unique_lock<mutex> lock( m_mutex );
+                    m_job_posted.wait( lock, [&]{ return m_is_stopping or m_job_number != last_job_number; } );
+                    if( m_is_stopping ) {
+                        return;
+                    }
+                    last_job_number = m_job_number;
+                }
+                take_part( i_thread );
+                {
+                    const unique_lock<mutex> lock( m_mutex );
+                    --m_n_busy_workers;
+                }
+                m_job_done.notify_one();
+            }
+        }
+
+    public:
+        static auto default_n_threads()
+            -> int
+        { return clamp( int( thread::hardware_concurrency() ), 1, 8 ); }
+
+        ~Work_stealing_pool()
+        {
+            {
+                const unique_lock<mutex> lock( m_mutex );
+                m_is_stopping = true;
+            }
+            m_job_posted.notify_all();
+            for( thread& worker: m_workers ) { worker.join(); }
+        }
+
+        explicit Work_stealing_pool( const int n_threads = default_n_threads() ):
+            m_n_threads( max( n_threads, 1 ) ),
+            m_ranges( new Range[m_n_threads] ),
+            m_p_func( nullptr ),
+            m_call( nullptr ),
+            m_is_failed( false ),
+            m_n_steals( 0 ),
+            m_job_number( 0 ),
+            m_n_busy_workers( 0 ),
+            m_is_stopping( false )
+        {
+            for( const int i: zero_to( m_n_threads ) ) { m_ranges[i].bits.store( 0 ); }
+            m_workers.reserve( m_n_threads - 1 );
+            for( const int i: one_through( m_n_threads - 1 ) ) {
+                m_workers.emplace_back( [this, i]() noexcept { serve( i ); } );
+            }
+        }
+
+        auto n_threads() const  -> int      { return m_n_threads; }
+        auto n_steals() const   -> int64_t  { return m_n_steals.load( std::memory_order_relaxed ); }
+
+        // Not reentrant: `f` must not call `for_each_index` on the same pool.
+        template< class Func >
+        void for_each_index( const int n, const Func& f )
+        {
+            if( n <= 1 or m_n_threads == 1 ) {
+                for( const int i: zero_to( n ) ) { f( i ); }
+                return;
+            }
+
+            for( const int i: zero_to( m_n_threads ) ) {
+                const auto first = uint32_t( int64_t( n )*i/m_n_threads );
+                const auto beyond = uint32_t( int64_t( n )*(i + 1)/m_n_threads );
+                m_ranges[i].bits.store( packed( first, beyond ), std::memory_order_relaxed );
+            }
+            m_p_func = &f;
+            m_call = []( const void* p_func, const int i ) { (*static_cast<const Func*>( p_func ))( i ); };
+            m_is_failed.store( false, std::memory_order_relaxed );
+            {
+                const unique_lock<mutex> lock( m_mutex );
+                ++m_job_number;
+                m_n_busy_workers = m_n_threads - 1;
+            }
+            m_job_posted.notify_all();
+
+            take_part( 0 );
+            exception_ptr x;
+            {
+                unique_lock<mutex> lock( m_mutex );
+                m_job_done.wait( lock, [&]{ return m_n_busy_workers == 0; } );
+                x = m_exception;
+                m_exception = nullptr;
+            }
+            if( x ) { rethrow_exception( x ); }
+        }
+    };
+
+}  // namespace support_machinery
@@ -0,0 +1,66 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Runtime detection of x86 SIMD instruction sets, for dispatch to vectorized kernels.
+//
+// Kernels that use e.g. AVX2 intrinsics are marked `SM_TARGET_AVX2`, which lets g++ and clang
+// compile them without enabling AVX2 for the whole program. Visual C++ needs no marking.
+// `SM_IS_X86` is 0 for other architectures, where only the scalar kernels are available.
+
+#if defined( __x86_64__ ) or defined( _M_X64 ) or defined( __i386__ ) or defined( _M_IX86 )
+#   define SM_IS_X86        1
+#   include <immintrin.h>
+#   if defined( _MSC_VER ) and not defined( __clang__ )
+#       include <intrin.h>          // __cpuid, __cpuidex, _xgetbv
+#       define SM_TARGET_SSE2
+#       define SM_TARGET_AVX2
+#   else
+#       define SM_TARGET_SSE2   __attribute__(( target( "sse2" ) ))
+#       define SM_TARGET_AVX2   __attribute__(( target( "avx2" ) ))
+#   endif
+#else
+#   define SM_IS_X86        0
+#endif
+
+namespace support_machinery {
+
+    struct Simd_level{ enum Enum: int { scalar, sse2, avx2 }; };
+
+    namespace impl {
+        inline auto get_simd_level()
+            -> Simd_level::Enum
+        {
+            #if not SM_IS_X86
+                return Simd_level::scalar;
+            #elif defined( _MSC_VER ) and not defined( __clang__ )
+                int regs[4] = {};           // eax, ebx, ecx, edx
+                __cpuid( regs, 0 );
+                const int max_leaf = regs[0];
+                __cpuid( regs, 1 );
+                const bool has_sse2         = (regs[3] & (1 << 26)) != 0;
+                const bool has_osxsave      = (regs[2] & (1 << 27)) != 0;
+                const bool has_avx          = (regs[2] & (1 << 28)) != 0;
+                const bool os_saves_ymm     = has_osxsave and (_xgetbv( 0 ) & 6) == 6;
+                bool has_avx2 = false;
+                if( max_leaf >= 7 and has_avx and os_saves_ymm ) {
+                    __cpuidex( regs, 7, 0 );
+                    has_avx2 = (regs[1] & (1 << 5)) != 0;
+                }
+                return (has_avx2? Simd_level::avx2 : has_sse2? Simd_level::sse2 : Simd_level::scalar);
+            #else
+                __builtin_cpu_init();
+                return (__builtin_cpu_supports( "avx2" )? Simd_level::avx2
+                    : __builtin_cpu_supports( "sse2" )? Simd_level::sse2
+                    : Simd_level::scalar);
+            #endif
+        }
+    }  // namespace impl
+
+    // The best instruction set supported by both the CPU and the OS. Detected once.
+    inline auto simd_level()
+        -> Simd_level::Enum
+    {
+        static const Simd_level::Enum the_level = impl::get_simd_level();
+        return the_level;
+    }
+
+}  // namespace support_machinery
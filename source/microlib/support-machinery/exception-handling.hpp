@@ -3,6 +3,7 @@
 #include <exception>            // std::(exception_ptr, 
 #include <stdexcept>
 #include <functional>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -10,9 +11,9 @@
 #include <vector>
 
 #include <microlib/support-machinery/basic-types.hpp>       // C_string_ptr, Index, as_signed
+#include <microlib/support-machinery/Bounded_mpsc_queue_.hpp>   // Bounded_mpsc_queue_
 #include <microlib/support-machinery/type-builders.hpp>     // in_
 
-#include <assert.h>         // assert
 #include <stdlib.h>         // EXIT_FAILURE as a generic well known failure code.
 
 // Can't test directly for existence of the pseudo-macros, so must test compiler ids:
@@ -30,24 +31,28 @@
     
 namespace support_machinery {
     using   std::current_exception, std::exception_ptr, std::rethrow_exception, // <exception>
+            std::nested_exception,
             std::reference_wrapper, std::function,                              // <functional>
+            std::shared_ptr, std::make_shared,                                  // <memory>
             std::exception, std::runtime_error,                                 // <stdexcept>
             std::string,
             std::string_view,
             std::is_same_v,                                                     // <type_traits>
-            std::exchange, std::forward, std::move, std::enable_if_t,           // <utility>
+            std::forward, std::move, std::enable_if_t,                          // <utility>
             std::vector;
 
-    namespace impl {
-        // A max 1 item stack of exception pointers.
-        inline auto ref_deferred_exception()
-            -> ref_<exception_ptr>
-        {
-            thread_local exception_ptr the_deferred_x;
-            return the_deferred_x;
-        }
-    }  // namespace impl
-    
+    // Exceptions that can't propagate, e.g. through a window procedure or out of a worker thread,
+    // are pushed to a queue of the thread that will rethrow them, e.g. the GUI thread.
+    using Exception_queue = Bounded_mpsc_queue_<exception_ptr>;
+
+    // The current thread's queue. Other threads can push to it while the thread is running.
+    inline auto deferred_exceptions()
+        -> Exception_queue&
+    {
+        thread_local Exception_queue the_queue( 64 );
+        return the_queue;
+    }
+
     struct Bool_with_error_code
     {
         int     error_code = 0;
@@ -67,31 +72,28 @@ namespace support_machinery {
 
     inline auto n_pushed_exceptions()
         -> int
-    { return !!impl::ref_deferred_exception(); }
+    { return deferred_exceptions().size(); }
 
+    // The oldest deferred exception of this thread, if any.
     inline auto popped_exception()
         -> exception_ptr
-    { return exchange( impl::ref_deferred_exception(), nullptr ); }
+    { return deferred_exceptions().popped().value_or( nullptr ); }
 
     inline void pop_exception() { (void) popped_exception(); }
 
-    inline auto rethrow_popped_exception()
-        -> bool     // Mostly for convenience in invoking this in an expression.
+    // Thread safe. Error code 1 if the queue is full, 2 if there's no current exception.
+    inline auto push_current_exception_to( Exception_queue& queue )
+        -> Bool_with_error_code
     {
-        const exception_ptr xp = popped_exception();
-        if( !!xp ) { rethrow_exception( xp ); }
-        return false;
+        exception_ptr x = current_exception();
+        if( not x ) { return {2}; }
+        if( not queue.push( move( x ) ) ) { return {1}; }
+        return true;
     }
 
     inline auto push_current_exception()
         -> Bool_with_error_code
-    {
-        auto& dx = impl::ref_deferred_exception();
-        if( !!dx ) { return {1}; }
-        dx = current_exception();
-        if( not dx ) { return {2}; }
-        return true;
-    }
+    { return push_current_exception_to( deferred_exceptions() ); }
 
     constexpr auto func_id_from( in_<string_view> func_decl )
         -> string_view
@@ -105,16 +107,112 @@ namespace support_machinery {
         return func_decl.substr( i_first, i_parens - i_first );
     }
 
+    // A cause of an exception, with its message and its own cause. Exceptions thrown by `fail_`
+    // while handling an exception refer to this explicit chain, so it's walked without rethrowing.
+    struct Exception_cause
+    {
+        string                              message;
+        bool                                is_standard;    // Else a non-`std::exception`, no message.
+        shared_ptr<const Exception_cause>   p_next;
+    };
+
+    class Has_cause_chain
+    {
+        shared_ptr<const Exception_cause>   m_p_cause;
+
+    public:
+        virtual ~Has_cause_chain() {}
+        explicit Has_cause_chain( shared_ptr<const Exception_cause> p_cause ): m_p_cause( move( p_cause ) ) {}
+
+        auto p_cause() const -> const shared_ptr<const Exception_cause>& { return m_p_cause; }
+    };
+
+    // Also a `std::nested_exception`, for code that uses `std::rethrow_if_nested`.
+    template< class X >
+    class With_cause_:
+        public X,
+        public nested_exception,
+        public Has_cause_chain
+    {
+    public:
+        template< class... Args >
+        With_cause_( shared_ptr<const Exception_cause> p_cause, Args&&... args ):
+            X( forward<Args>( args )... ),
+            nested_exception(),
+            Has_cause_chain( move( p_cause ) )
+        {}
+    };
+
+    namespace impl {
+        // Uses inefficient nested exception throwing in order to avoid stack overflow on recursion.
+        inline auto with_messages_by_rethrowing( in_<exception> x, function<void(C_string_ptr)> process )
+            -> bool
+        {
+            exception_ptr px;
+            for( ;; ) {
+                try {
+                    if( not px ) {
+                        process( x.what() );
+                        std::rethrow_if_nested( x );
+                    } else {
+                        try{
+                            rethrow_exception( px );
+                        } catch( in_<exception> current_x ) {
+                            process( current_x.what() );
+                            std::rethrow_if_nested( current_x );
+                            return true;    // No more nested exceptions.
+                        } catch( ... ) {
+                            return false;   // Non-standard exception type.
+                        }
+                    }
+                    return true;    // No more nested exceptions.
+                } catch( ... ) {
+                    px = current_exception();
+                }
+            }
+            for( ;; ){}         // Can't get here.
+        }
+
+        // A foreign nested exception chain is walked once, here, and converted.
+        inline auto cause_chain_of( in_<exception> x )
+            -> shared_ptr<const Exception_cause>
+        {
+            if( const auto p_chained = dynamic_cast<const Has_cause_chain*>( &x ) ) {
+                return make_shared<const Exception_cause>( Exception_cause{ x.what(), true, p_chained->p_cause() } );
+            }
+            vector<string> messages;
+            const bool all_standard = with_messages_by_rethrowing( x, [&]( C_string_ptr s ){ messages.push_back( s ); } );
+            shared_ptr<const Exception_cause> p_result = (all_standard? nullptr
+                : make_shared<const Exception_cause>( Exception_cause{ "", false, nullptr } )
+                );
+            for( auto it = messages.rbegin(); it != messages.rend(); ++it ) {
+                p_result = make_shared<const Exception_cause>( Exception_cause{ move( *it ), true, move( p_result ) } );
+            }
+            return p_result;
+        }
+
+        // Must be called while handling an exception.
+        inline auto cause_chain_of_current_exception()
+            -> shared_ptr<const Exception_cause>
+        {
+            try {
+                throw;
+            } catch( in_<exception> x ) {
+                return cause_chain_of( x );
+            } catch( ... ) {
+                return make_shared<const Exception_cause>( Exception_cause{ "", false, nullptr } );
+            }
+        }
+    }  // namespace impl
+
     template< class X, class... Args >
     [[noreturn]] inline auto fail_( Args&&... args )
         -> bool
     {
-        assert( n_pushed_exceptions() == 0 );
-        auto x = X( forward<Args>( args )... );
         if( current_exception() ) {
-            throw_with_nested( move( x ) );
+            throw With_cause_<X>( impl::cause_chain_of_current_exception(), forward<Args>( args )... );
         }
-        throw move( x );
+        throw X( forward<Args>( args )... );
     }
 
     [[noreturn]] inline auto fail( in_<string> message )
@@ -128,37 +226,75 @@ namespace support_machinery {
         std::rethrow_if_nested( x );
     }
 
-    inline auto with_messages_of( in_<exception> x, function<void(C_string_ptr)> process )
+    // Returns `false` if the chain ends in a non-standard exception, which has no message.
+    template< class Func >
+    inline auto with_messages_of( in_<exception> x, const Func& process )
         -> bool
     {
-        // Uses inefficient nested exception throwing in order to avoid stack overflow on recursion.
-        exception_ptr px;
-        for( ;; ) {
-            try {
-                if( not px ) {
-                    process( x.what() );
-                    rethrow_any_nested_x_of( x );
-                } else {
-                    try{
-                        rethrow_exception( px );
-                    } catch( in_<exception> current_x ) {
-                        process( current_x.what() );
-                        rethrow_any_nested_x_of( current_x );
-                    }
-                    return false;   // Non-standard exception type.
-                }
-                return true;    // No more nested exceptions.
-            } catch( ... ) {
-                px = current_exception();
+        const auto p_chained = dynamic_cast<const Has_cause_chain*>( &x );
+        if( not p_chained ) {
+            return impl::with_messages_by_rethrowing( x, process );     // E.g. `std::throw_with_nested`.
+        }
+        process( x.what() );
+        for( const Exception_cause* p = p_chained->p_cause().get(); p; p = p->p_next.get() ) {
+            if( not p->is_standard ) {
+                return false;
             }
+            process( p->message.c_str() );
         }
-        for( ;; ){}         // Can't get here.
+        return true;
     }
 
     inline auto messages_of( in_<exception> x )
     {
         vector<string>  messages;
-        with_messages_of( x, [&]( C_string_ptr s ){ messages.push_back( s ); } );
+        with_messages_of( x, [&]( C_string_ptr s ){ messages.emplace_back( s ); } );
         return messages;
     }
+
+    // Two or more deferred exceptions rethrown as one. The messages of each, in order, are its causes.
+    class Exception_group:
+        public runtime_error
+    {
+        vector<exception_ptr>   m_exceptions;
+
+    public:
+        Exception_group( in_<string> message, vector<exception_ptr> exceptions ):
+            runtime_error( message ), m_exceptions( move( exceptions ) )
+        {}
+
+        auto exceptions() const -> const vector<exception_ptr>& { return m_exceptions; }
+    };
+
+    // Drains this thread's queue: throws the single exception, or an `Exception_group`, if any.
+    inline auto rethrow_popped_exception()
+        -> bool     // Mostly for convenience in invoking this in an expression.
+    {
+        vector<exception_ptr> exceptions;
+        for( exception_ptr x; (x = popped_exception()) != nullptr; ) {
+            exceptions.push_back( move( x ) );
+        }
+        if( exceptions.empty() ) {
+            return false;
+        } else if( exceptions.size() == 1 ) {
+            rethrow_exception( exceptions.front() );
+        }
+
+        vector<string> messages;
+        for( const exception_ptr& x: exceptions ) {
+            try {
+                rethrow_exception( x );
+            } catch( in_<exception> e ) {
+                with_messages_of( e, [&]( C_string_ptr s ){ messages.emplace_back( s ); } );
+            } catch( ... ) {
+                messages.emplace_back( "<a non-standard exception>" );
+            }
+        }
+        shared_ptr<const Exception_cause> p_causes;
+        for( auto it = messages.rbegin(); it != messages.rend(); ++it ) {
+            p_causes = make_shared<const Exception_cause>( Exception_cause{ move( *it ), true, move( p_causes ) } );
+        }
+        const string message = std::to_string( exceptions.size() ) + " deferred exceptions";
+        throw With_cause_<Exception_group>( move( p_causes ), message, move( exceptions ) );
+    }
 }  // namespace support_machinery
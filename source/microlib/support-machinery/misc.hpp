@@ -7,7 +7,8 @@
 #include <stdexcept>
 #include <string>
 #include <string_view>
-#include <type_traits>          // std::is_base_of
+#include <tuple>
+#include <type_traits>          // std::is_base_of, std::is_same
 #include <utility>
 #include <vector>
 
@@ -23,6 +24,8 @@ namespace support_machinery {
             std::exception, std::runtime_error,                 // <stdexcept>
             std::string,
             std::string_view,
+            std::tuple,                                         // <tuple>
+            std::is_same_v,                                     // <type_traits>
             std::forward, std::move,                            // <utility>
             std::vector;
 
@@ -34,42 +37,6 @@ namespace support_machinery {
         -> int
     { return static_cast<int>( size( c ) ); }
 
-    template< class... Supported_options >
-    class Option_refs_:
-        public optional<reference_wrapper<const Supported_options>>...
-    {
-    public:
-        // Compilation error if one of the values is of unsupported type.
-        template< class... Options >
-        Option_refs_( in_<Options>... options ):
-            optional<reference_wrapper<const Options>>( options )...
-        {}
-
-        // Empty optional if the Option is not present.
-        template< class Option >
-        auto get_() const
-            -> optional<reference_wrapper<const Option>>
-        { return *static_cast<const optional<reference_wrapper<const Option>>*>( this ); }
-        
-        template< class Option >
-        auto has_() const
-            -> bool
-        { return get_<Option>().has_value(); }
-
-        template< class Option >
-        auto get_with_default( in_<Option> a_default ) const
-            -> ref_<const Option>
-        {
-            const optional<reference_wrapper<const Option>> option = get_<Option>();
-            return (option.has_value()? option.value().get() : a_default);
-        }
-
-        template< class Option >
-        auto operator|( in_<Option> a_default ) const
-            -> ref_<const Option>
-        { return get_with_default( a_default ); }
-    };
-
     // Convenience base class for option types.
     template< class Value >
     struct Option_
@@ -87,6 +54,47 @@ namespace support_machinery {
         template< template< class... > class Foo_ >
         using Specialization_of_ = Foo_<Types...>;
     };
+
+    template< class Type, class... Types >
+    constexpr bool is_one_of_ = (is_same_v<Type, Types> or ...);
+
+    template< class... Types > constexpr bool are_distinct_ = true;
+
+    template< class Type, class... More_types >
+    constexpr bool are_distinct_<Type, More_types...> =
+        not is_one_of_<Type, More_types...> and are_distinct_<More_types...>;
+
+    // The options given to e.g. a window creation function, resolved at compile time: only the
+    // present options are stored, and `option_pack | With_x{ a_default }` is either the option
+    // or the default, with no run time check. An unsupported or repeated option doesn't compile.
+    template< class Supported_option_types, class... Options > class Option_pack_;
+
+    template< class... Supported_options, class... Options >
+    class Option_pack_<Type_list_<Supported_options...>, Options...>
+    {
+        static_assert( (is_one_of_<Options, Supported_options...> and ...), "Unsupported option type." );
+        static_assert( are_distinct_<Options...>, "An option type is specified more than once." );
+
+        tuple<Options...>   m_options;
+
+    public:
+        constexpr Option_pack_( in_<Options>... options ): m_options( options... ) {}
+
+        template< class Option >
+        static constexpr bool has_ = is_one_of_<Option, Options...>;
+
+        template< class Option >
+        constexpr auto operator|( in_<Option> a_default ) const
+            -> ref_<const Option>
+        {
+            static_assert( is_one_of_<Option, Supported_options...>, "Unsupported option type." );
+            if constexpr( has_<Option> ) {
+                return std::get<Option>( m_options );
+            } else {
+                return a_default;
+            }
+        }
+    };
     
     class Non_copyable      // Is not movable either.
     {
@@ -1,35 +1,203 @@
 ﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
 
-#include <microlib/support-machinery/basic-types.hpp>           // C_string_ptr
+// `sb << "Button press, id " << id << "."` builds a string in a `String_builder`, which converts
+// implicitly to `C_string_ptr`, and can be concatenated to a `std::string`, e.g. in `SM_FAIL`.
+//
+// The characters are stored inline up to `String_builder::inline_capacity`, and numbers are
+// formatted with `std::to_chars`, so a typical message is built without any dynamic allocation.
+// A longer string goes to a `Char_arena`, if one was specified, and otherwise to the heap.
+
+#include <microlib/support-machinery/basic-types.hpp>           // C_string_ptr, Size, Index
+#include <microlib/support-machinery/misc.hpp>                  // Non_copyable
+#include <microlib/support-machinery/Span_.hpp>                 // Span_
 #include <microlib/support-machinery/type-builders.hpp>         // in_, ref_
 
+#include <assert.h>         // assert
+#include <string.h>         // memcpy
+
+#include <charconv>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <type_traits>
 #include <utility>
 
 namespace support_machinery {
-    using   std::string, std::to_string,    // <string>
+    using   std::to_chars,                      // <charconv>
+            std::unique_ptr,                    // <memory>
+            std::string,
             std::string_view,
-            std::is_arithmetic_v,           // <type_traits>
-            std::enable_if_t;               // <utility>
+            std::is_arithmetic_v, std::is_same_v,   // <type_traits>
+            std::enable_if_t, std::move;        // <utility>
 
     inline namespace string_building {
-        
+
         inline auto operator~( in_<string> s )
             -> C_string_ptr
         { return s.c_str(); }
 
-        struct String_builder: string
+        // Monotonic storage for string builders in a caller supplied buffer, e.g. a local array.
+        // Space is reclaimed only by `clear`, which must not be called while it's still in use.
+        class Char_arena:
+            public Non_copyable
+        {
+            Span_<char>     m_buffer;
+            Size            m_n_used;
+
+        public:
+            explicit Char_arena( const Span_<char> buffer ): m_buffer( buffer ), m_n_used( 0 ) {}
+
+            auto n_used() const         -> Size { return m_n_used; }
+            auto n_available() const    -> Size { return m_buffer.size() - m_n_used; }
+
+            // `nullptr` if there isn't room.
+            auto allocate( const Size n )
+                -> char*
+            {
+                if( n > n_available() ) {
+                    return nullptr;
+                }
+                char* const result = m_buffer.data() + m_n_used;
+                m_n_used += n;
+                return result;
+            }
+
+            void clear() { m_n_used = 0; }
+        };
+
+        class String_builder
         {
+        public:
+            static constexpr Size inline_capacity = 255;    // Plus a terminating null.
+
             struct Start{};
 
-            String_builder() {}
-            String_builder( Start ) {}
+        private:
+            char*               m_p_chars;          // Null-terminated.
+            Size                m_size;
+            Size                m_capacity;         // Not counting the terminating null.
+            Char_arena*         m_p_arena;
+            unique_ptr<char[]>  m_p_heap_chars;
+            char                m_inline_chars[inline_capacity + 1];
+
+            void init()
+            {
+                m_p_chars = m_inline_chars;
+                m_size = 0;
+                m_capacity = inline_capacity;
+                m_inline_chars[0] = '\0';
+            }
+
+        public:
+            String_builder(): m_p_arena( nullptr ) { init(); }
+            String_builder( Start ): m_p_arena( nullptr ) { init(); }
+            explicit String_builder( Char_arena& arena ): m_p_arena( &arena ) { init(); }
+
+            String_builder( in_<String_builder> other ):
+                m_p_arena( other.m_p_arena )
+            {
+                init();
+                append( other.view() );
+            }
+
+            String_builder( String_builder&& other ):
+                m_p_arena( other.m_p_arena )
+            {
+                init();
+                if( other.m_p_heap_chars ) {
+                    m_p_heap_chars = move( other.m_p_heap_chars );
+                    m_p_chars = m_p_heap_chars.get();
+                    m_size = other.m_size;
+                    m_capacity = other.m_capacity;
+                    other.init();
+                } else {
+                    append( other.view() );
+                }
+            }
+
+            auto operator=( in_<String_builder> other )
+                -> String_builder&
+            {
+                if( &other != this ) {
+                    clear();
+                    append( other.view() );
+                }
+                return *this;
+            }
+
+            auto operator=( String_builder&& other )
+                -> String_builder&
+            {
+                if( other.m_p_heap_chars ) {
+                    m_p_heap_chars = move( other.m_p_heap_chars );
+                    m_p_chars = m_p_heap_chars.get();
+                    m_size = other.m_size;
+                    m_capacity = other.m_capacity;
+                    other.init();
+                } else {
+                    *this = static_cast<const String_builder&>( other );
+                }
+                return *this;
+            }
+
+            auto size() const       -> Size             { return m_size; }
+            auto capacity() const   -> Size             { return m_capacity; }
+            auto is_empty() const   -> bool             { return (m_size == 0); }
+            auto data() const       -> C_string_ptr     { return m_p_chars; }
+            auto c_str() const      -> C_string_ptr     { return m_p_chars; }
+            auto view() const       -> string_view      { return string_view( m_p_chars, m_size ); }
+            auto str() const        -> string           { return string( m_p_chars, m_size ); }
+            auto is_inline() const  -> bool             { return (m_p_chars == m_inline_chars); }
 
             operator C_string_ptr() const { return c_str(); }
+            operator string_view() const { return view(); }
+
+            void clear()
+            {
+                m_size = 0;
+                m_p_chars[0] = '\0';
+            }
+
+            void reserve( const Size n )
+            {
+                if( n <= m_capacity ) {
+                    return;
+                }
+                const Size new_capacity = (n < 2*m_capacity? 2*m_capacity : n);
+                char* p_new_chars = (m_p_arena? m_p_arena->allocate( new_capacity + 1 ) : nullptr);
+                unique_ptr<char[]> p_new_heap_chars;
+                if( not p_new_chars ) {
+                    p_new_heap_chars.reset( new char[new_capacity + 1] );
+                    p_new_chars = p_new_heap_chars.get();
+                }
+                memcpy( p_new_chars, m_p_chars, m_size + 1 );
+                m_p_heap_chars = move( p_new_heap_chars );      // Possibly releasing the old chars.
+                m_p_chars = p_new_chars;
+                m_capacity = new_capacity;
+            }
+
+            void append( const string_view s )
+            {
+                const auto n = static_cast<Size>( s.size() );
+                reserve( m_size + n );
+                memcpy( m_p_chars + m_size, s.data(), n );
+                m_size += n;
+                m_p_chars[m_size] = '\0';
+            }
+
+            // Formats the number directly in the buffer, via `std::to_chars`.
+            template< class Number >
+            void append_number( const Number value )
+            {
+                constexpr Size max_number_length = 64;      // Enough for the shortest `double` form.
+                reserve( m_size + max_number_length );
+                const auto result = to_chars( m_p_chars + m_size, m_p_chars + m_capacity, value );
+                assert( result.ec == std::errc() );
+                m_size = result.ptr - m_p_chars;
+                m_p_chars[m_size] = '\0';
+            }
         };
-        
+
         constexpr String_builder::Start sb = {};
 
         inline auto operator<<( String_builder& destination, in_<string_view> source )
@@ -43,7 +211,11 @@ namespace support_machinery {
         inline auto operator<<( String_builder& destination, in_<T> value )
             -> String_builder&
         {
-            destination.append( to_string( value ) );               // TODO: use from_chars
+            if constexpr( is_same_v<T, bool> ) {
+                destination.append( value? "1" : "0" );     // As `std::to_string` did.
+            } else {
+                destination.append_number( value );
+            }
             return destination;
         }
 
@@ -51,5 +223,17 @@ namespace support_machinery {
         inline auto operator<<( String_builder&& destination, in_<T> source )
             -> String_builder&&
         { return move( destination << source ); }
+
+        // E.g. `SM_FAIL( sb << "Bad value " << x )`, where the function id is a `std::string`.
+        inline auto operator+( string&& s, in_<String_builder> builder )
+            -> string
+        {
+            s.append( builder.view() );
+            return move( s );
+        }
+
+        inline auto operator+( in_<string> s, in_<String_builder> builder )
+            -> string
+        { return string( s ) + builder; }
     }  // namespace string_building
 }  // namespace support_machinery
@@ -0,0 +1,221 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Where two strings first differ, searching from the start or from the end, e.g. to find the
+// changed part of a status text before repainting it.
+//
+// Both functions return -1 if the strings are equal, and otherwise the number of equal bytes
+// before the first difference, which is the length of the shorter string if it's a prefix
+// (respectively suffix) of the other. The byte comparisons are done by kernels with SSE2 and
+// AVX2 versions and an 8 bytes at a time fallback; the best version for the CPU is selected at
+// first use.
+
+#include <microlib/support-machinery/basic-types.hpp>       // Size, Index
+#include <microlib/support-machinery/cpu-features.hpp>      // Simd_level, simd_level, SM_TARGET_AVX2
+#include <microlib/support-machinery/type-builders.hpp>     // in_
+
+#include <stdint.h>         // uint64_t
+#include <string.h>         // memcpy
+
+#include <algorithm>
+#include <string_view>
+
+namespace support_machinery {
+    using   std::min,                           // <algorithm>
+            std::string_view;
+
+    struct Mismatch_kernels
+    {
+        // Each returns the number of equal bytes, from the start respectively the end, of the
+        // `n` bytes at `a` and at `b`.
+        auto (*n_equal_at_start)( const char* a, const char* b, Size n ) -> Size;
+        auto (*n_equal_at_end)( const char* a, const char* b, Size n ) -> Size;
+    };
+
+    namespace impl::scalar {
+        inline auto word_at( const char* p )
+            -> uint64_t
+        {
+            uint64_t result;
+            memcpy( &result, p, sizeof( result ) );
+            return result;
+        }
+
+        // Compares 8 bytes at a time, and then byte by byte within the first differing word, which
+        // doesn't depend on the byte order.
+        inline auto n_equal_at_start( const char* a, const char* b, const Size n )
+            -> Size
+        {
+            constexpr Size w = sizeof( uint64_t );
+            Size i = 0;
+            while( i + w <= n and word_at( a + i ) == word_at( b + i ) ) { i += w; }
+            while( i < n and a[i] == b[i] ) { ++i; }
+            return i;
+        }
+
+        inline auto n_equal_at_end( const char* a, const char* b, const Size n )
+            -> Size
+        {
+            constexpr Size w = sizeof( uint64_t );
+            Size i = n;         // Bytes at and after `i` are equal.
+            while( i >= w and word_at( a + i - w ) == word_at( b + i - w ) ) { i -= w; }
+            while( i > 0 and a[i - 1] == b[i - 1] ) { --i; }
+            return n - i;
+        }
+    }  // namespace impl::scalar
+
+    #if SM_IS_X86
+    namespace impl {
+        // `bits` must be non-zero.
+        inline auto i_lowest_bit_in( const unsigned bits )
+            -> int
+        {
+            #if defined( _MSC_VER ) and not defined( __clang__ )
+                unsigned long result;
+                _BitScanForward( &result, bits );
+                return int( result );
+            #else
+                return __builtin_ctz( bits );
+            #endif
+        }
+
+        // `bits` must be non-zero.
+        inline auto i_highest_bit_in( const unsigned bits )
+            -> int
+        {
+            #if defined( _MSC_VER ) and not defined( __clang__ )
+                unsigned long result;
+                _BitScanReverse( &result, bits );
+                return int( result );
+            #else
+                return 31 - __builtin_clz( bits );
+            #endif
+        }
+    }  // namespace impl
+
+    // A `movemask` of a byte comparison has bit i set when byte i is equal, so the differences
+    // are the zero bits.
+    namespace impl::sse2 {
+        SM_TARGET_SSE2 inline auto difference_bits( const char* a, const char* b )
+            -> unsigned
+        {
+            const __m128i equal_bytes = _mm_cmpeq_epi8(
+                _mm_loadu_si128( reinterpret_cast<const __m128i*>( a ) ),
+                _mm_loadu_si128( reinterpret_cast<const __m128i*>( b ) )
+                );
+            return ~unsigned( _mm_movemask_epi8( equal_bytes ) ) & 0xFFFFu;
+        }
+
+        SM_TARGET_SSE2 inline auto n_equal_at_start( const char* a, const char* b, const Size n )
+            -> Size
+        {
+            Size i = 0;
+            for( ; i + 16 <= n; i += 16 ) {
+                if( const unsigned bits = difference_bits( a + i, b + i ) ) {
+                    return i + i_lowest_bit_in( bits );
+                }
+            }
+            return i + scalar::n_equal_at_start( a + i, b + i, n - i );
+        }
+
+        SM_TARGET_SSE2 inline auto n_equal_at_end( const char* a, const char* b, const Size n )
+            -> Size
+        {
+            Size i = n;
+            for( ; i >= 16; i -= 16 ) {
+                if( const unsigned bits = difference_bits( a + i - 16, b + i - 16 ) ) {
+                    return n - i + (15 - i_highest_bit_in( bits ));
+                }
+            }
+            return n - i + scalar::n_equal_at_end( a, b, i );
+        }
+    }  // namespace impl::sse2
+
+    namespace impl::avx2 {
+        SM_TARGET_AVX2 inline auto difference_bits( const char* a, const char* b )
+            -> unsigned
+        {
+            const __m256i equal_bytes = _mm256_cmpeq_epi8(
+                _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a ) ),
+                _mm256_loadu_si256( reinterpret_cast<const __m256i*>( b ) )
+                );
+            return ~unsigned( _mm256_movemask_epi8( equal_bytes ) );
+        }
+
+        SM_TARGET_AVX2 inline auto n_equal_at_start( const char* a, const char* b, const Size n )
+            -> Size
+        {
+            Size i = 0;
+            for( ; i + 32 <= n; i += 32 ) {
+                if( const unsigned bits = difference_bits( a + i, b + i ) ) {
+                    return i + i_lowest_bit_in( bits );
+                }
+            }
+            return i + sse2::n_equal_at_start( a + i, b + i, n - i );
+        }
+
+        SM_TARGET_AVX2 inline auto n_equal_at_end( const char* a, const char* b, const Size n )
+            -> Size
+        {
+            Size i = n;
+            for( ; i >= 32; i -= 32 ) {
+                if( const unsigned bits = difference_bits( a + i - 32, b + i - 32 ) ) {
+                    return n - i + (31 - i_highest_bit_in( bits ));
+                }
+            }
+            return n - i + sse2::n_equal_at_end( a, b, i );
+        }
+    }  // namespace impl::avx2
+    #endif
+
+    inline auto mismatch_kernels_for( const Simd_level::Enum level )
+        -> const Mismatch_kernels&
+    {
+        static const Mismatch_kernels scalar_kernels = { impl::scalar::n_equal_at_start, impl::scalar::n_equal_at_end };
+        #if SM_IS_X86
+            static const Mismatch_kernels sse2_kernels = { impl::sse2::n_equal_at_start, impl::sse2::n_equal_at_end };
+            static const Mismatch_kernels avx2_kernels = { impl::avx2::n_equal_at_start, impl::avx2::n_equal_at_end };
+            switch( level ) {
+                case Simd_level::avx2:      return avx2_kernels;
+                case Simd_level::sse2:      return sse2_kernels;
+                case Simd_level::scalar:    break;
+            }
+        #else
+            (void) level;
+        #endif
+        return scalar_kernels;
+    }
+
+    inline auto mismatch_kernels()
+        -> const Mismatch_kernels&
+    {
+        static const Mismatch_kernels& the_kernels = mismatch_kernels_for( simd_level() );
+        return the_kernels;
+    }
+
+    inline auto i_first_difference(
+        in_<string_view>            a,
+        in_<string_view>            b,
+        in_<Mismatch_kernels>       kernels     = mismatch_kernels()
+        ) -> Index
+    {
+        const auto n_bytes = static_cast<Size>( min( a.length(), b.length() ) );
+        const Size n_equal = kernels.n_equal_at_start( a.data(), b.data(), n_bytes );
+        return (n_equal == n_bytes and a.length() == b.length()? -1 : n_equal);
+    }
+
+    // The result is a count from the end, so the differing bytes are `a[a.length() - 1 - result]`
+    // and `b[b.length() - 1 - result]`.
+    inline auto i_first_difference_from_end(
+        in_<string_view>            a,
+        in_<string_view>            b,
+        in_<Mismatch_kernels>       kernels     = mismatch_kernels()
+        ) -> Index
+    {
+        const auto n_bytes = static_cast<Size>( min( a.length(), b.length() ) );
+        const Size n_equal = kernels.n_equal_at_end(
+            a.data() + (a.length() - n_bytes), b.data() + (b.length() - n_bytes), n_bytes
+            );
+        return (n_equal == n_bytes and a.length() == b.length()? -1 : n_equal);
+    }
+
+}  // namespace support_machinery
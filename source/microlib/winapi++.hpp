@@ -1,6 +1,14 @@
 ﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
 
 #include <microlib/winapi++/lib-comctl32.hpp>
+#include <microlib/winapi++/control-batch.hpp>
+#include <microlib/winapi++/Event_loop.hpp>
+#include <microlib/winapi++/font-cache.hpp>
+#include <microlib/winapi++/Frame_ticker.hpp>
+#include <microlib/winapi++/gdi-object-cache.hpp>
 #include <microlib/winapi++/gui.hpp>
+#include <microlib/winapi++/message-latency.hpp>
+#include <microlib/winapi++/pixel-output.hpp>
 #include <microlib/winapi++/resource-handling.hpp>
 #include <microlib/winapi++/Unique_handle_.hpp>
+#include <microlib/winapi++/window-text-cache.hpp>
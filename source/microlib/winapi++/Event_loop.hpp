@@ -0,0 +1,223 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// An event loop that in a single wait call waits for window messages, for up to 63 waitable
+// objects such as events or thread handles, and for the next timer deadline.
+//
+// After each dispatch any deferred exception is rethrown, as with the basic `GetMessage` loop.
+// An abandoned mutex counts as signalled. After a waitable's handler the queued messages are
+// dispatched, so that a handle that stays signalled can't starve the messages.
+//
+// A modal loop, e.g. of `MessageBox` or of a window being moved, only dispatches messages. While
+// messages are dispatched a thread timer is therefore armed, that in a modal loop polls the
+// waitables and calls due timer callbacks, with `WM_TIMER` granularity, about 16 ms. Exceptions
+// from them are then deferred via `push_current_exception`.
+
+#include <microlib/support-machinery.hpp>                   // rethrow_popped_exception, SM_FAIL, Non_copyable
+#include <microlib/support-machinery/Timer_queue.hpp>       // Timer_queue, Event_loop_stats
+#include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace winapi {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::hopefully, sm::rethrow_popped_exception, sm::push_current_exception,
+            sm::Non_copyable, sm::Timer_queue, sm::Event_loop_stats;
+    using   std::find,                          // <algorithm>
+            std::function,                      // <functional>
+            std::to_string,                     // <string>
+            std::move,                          // <utility>
+            std::vector;
+    namespace chrono = std::chrono;
+
+    class Event_loop:
+        public Non_copyable
+    {
+        vector<HANDLE>                  m_handles;      // Parallel arrays, as `MsgWaitForMultipleObjectsEx` wants.
+        vector<function<void()>>        m_handlers;
+        Timer_queue                     m_timers;
+        Event_loop_stats                m_stats;
+        bool                            m_is_pumping    = false;
+
+        static constexpr UINT   modal_pump_interval_ms  = USER_TIMER_MINIMUM;
+
+        static auto p_dispatching_loop()
+            -> Event_loop*&
+        {
+            thread_local Event_loop* the_pointer = nullptr;
+            return the_pointer;
+        }
+
+        // Rounded up, so that the wait doesn't end just before the deadline.
+        static auto timeout_ms_for( const Timer_queue::Time_point deadline )
+            -> DWORD
+        {
+            const auto remaining = deadline - Timer_queue::Clock::now();
+            if( remaining <= Timer_queue::Duration::zero() ) {
+                return 0;
+            }
+            const auto ms = chrono::ceil<chrono::milliseconds>( remaining ).count();
+            return (ms >= INFINITE? INFINITE - 1 : static_cast<DWORD>( ms ));
+        }
+
+        void call_handler_of( const int i )
+        {
+            ++m_stats.n_signals;
+            const function<void()> handler = m_handlers[i];      // May remove itself.
+            handler();
+        }
+
+        auto dispatch_due_timers()
+            -> int
+        {
+            const int n_timer_callbacks = m_timers.dispatch_due( Timer_queue::Clock::now() );
+            m_stats.n_timer_callbacks += n_timer_callbacks;
+            return n_timer_callbacks;
+        }
+
+        // Called via `WM_TIMER` messages, which in practice means from a modal loop.
+        void pump_waitables_and_timers()
+        {
+            if( m_is_pumping ) {
+                return;     // A handler's own modal loop.
+            }
+            m_is_pumping = true;
+            try {
+                const vector<HANDLE> handles = m_handles;
+                for( const HANDLE handle: handles ) {
+                    const auto it = find( m_handles.begin(), m_handles.end(), handle );
+                    if( it == m_handles.end() ) {
+                        continue;       // Removed by a handler.
+                    }
+                    const DWORD state = ::WaitForSingleObject( handle, 0 );
+                    if( state == WAIT_OBJECT_0 or state == WAIT_ABANDONED ) {
+                        call_handler_of( static_cast<int>( it - m_handles.begin() ) );
+                    }
+                }
+                dispatch_due_timers();
+            } catch( ... ) {
+                push_current_exception();
+            }
+            m_is_pumping = false;
+        }
+
+        static void CALLBACK on_modal_pump_timer( HWND, UINT, UINT_PTR, DWORD )
+        {
+            if( Event_loop* const p_loop = p_dispatching_loop() ) {
+                p_loop->pump_waitables_and_timers();
+            }
+        }
+
+        // Returns `false` on `WM_QUIT`. The modal loop pump timer is armed at the first message.
+        auto dispatch_queued_messages()
+            -> bool
+        {
+            struct Dispatch_scope
+            {
+                Event_loop*     p_outer_loop;
+                UINT_PTR        pump_timer_id;
+
+                ~Dispatch_scope()
+                {
+                    if( pump_timer_id != 0 ) { ::KillTimer( 0, pump_timer_id ); }
+                    p_dispatching_loop() = p_outer_loop;
+                }
+            } scope{ p_dispatching_loop(), 0 };
+            p_dispatching_loop() = this;
+
+            MSG msg = {};
+            while( ::PeekMessage( &msg, 0, 0, 0, PM_REMOVE ) ) {
+                if( msg.message == WM_QUIT ) {
+                    hopefully( msg.wParam == 0 )
+                        or SM_FAIL( "Something failed, error code " + to_string( msg.wParam ) + "." );
+                    return false;
+                }
+                if( scope.pump_timer_id == 0 and (not m_handles.empty() or m_timers.n_timers() > 0) ) {
+                    scope.pump_timer_id = ::SetTimer( 0, 0, modal_pump_interval_ms, &on_modal_pump_timer );
+                }
+                ++m_stats.n_messages;
+                ::TranslateMessage( &msg );
+                ::DispatchMessage( &msg );
+                rethrow_popped_exception();     // If any.
+            }
+            return true;
+        }
+
+    public:
+        static constexpr int max_waitables = MAXIMUM_WAIT_OBJECTS - 1;
+
+        auto timers()       -> Timer_queue&                 { return m_timers; }
+        auto stats() const  -> const Event_loop_stats&      { return m_stats; }
+
+        // The `handler` is called on the event loop's thread whenever `handle` is signalled.
+        void add_waitable( const HANDLE handle, function<void()> handler )
+        {
+            hopefully( static_cast<int>( m_handles.size() ) < max_waitables )
+                or SM_FAIL( "Too many waitable objects for the event loop." );
+            m_handles.push_back( handle );
+            m_handlers.push_back( move( handler ) );
+        }
+
+        void remove_waitable( const HANDLE handle )
+        {
+            const auto it = find( m_handles.begin(), m_handles.end(), handle );
+            if( it != m_handles.end() ) {
+                m_handlers.erase( m_handlers.begin() + (it - m_handles.begin()) );
+                m_handles.erase( it );
+            }
+        }
+
+        // Runs until a `WM_QUIT` message, e.g. from `PostQuitMessage`.
+        void run()
+        {
+            for( ;; ) {
+                const auto n_handles = static_cast<DWORD>( m_handles.size() );
+                const auto deadline = m_timers.next_deadline();
+                const DWORD result = ::MsgWaitForMultipleObjectsEx(
+                    n_handles, m_handles.data(),
+                    (deadline? timeout_ms_for( *deadline ) : INFINITE),
+                    QS_ALLINPUT,
+                    MWMO_INPUTAVAILABLE         // Also wake for messages already seen by a peek.
+                    );
+                hopefully( result != WAIT_FAILED )
+                    or SM_FAIL( "::MsgWaitForMultipleObjectsEx failed, error code " + to_string( ::GetLastError() ) + "." );
+                ++m_stats.n_wakeups;
+
+                const auto n_messages_before = m_stats.n_messages;
+                const auto n_signals_before = m_stats.n_signals;
+                const bool is_signalled = (result < WAIT_OBJECT_0 + n_handles);
+                const bool is_abandoned = (WAIT_ABANDONED_0 <= result and result < WAIT_ABANDONED_0 + n_handles);
+                if( is_signalled or is_abandoned ) {
+                    call_handler_of( static_cast<int>( result - (is_signalled? WAIT_OBJECT_0 : WAIT_ABANDONED_0) ) );
+                    rethrow_popped_exception();
+                    if( not dispatch_queued_messages() ) {
+                        return;
+                    }
+                } else if( result == WAIT_OBJECT_0 + n_handles ) {
+                    if( not dispatch_queued_messages() ) {
+                        return;
+                    }
+                }
+
+                const int n_timer_callbacks = dispatch_due_timers();
+                rethrow_popped_exception();
+                if( n_timer_callbacks == 0 and m_stats.n_messages == n_messages_before
+                        and m_stats.n_signals == n_signals_before ) {
+                    ++m_stats.n_idle_wakeups;
+                }
+            }
+        }
+    };
+
+    // The event loop of the current thread, e.g. for adding timers from a message handler.
+    inline auto event_loop()
+        -> Event_loop&
+    {
+        thread_local Event_loop the_loop;
+        return the_loop;
+    }
+}  // namespace winapi
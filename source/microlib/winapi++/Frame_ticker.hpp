@@ -0,0 +1,99 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Calls a function for each frame of a `Frame_pacer`, from the thread's event loop.
+//
+// A `WM_TIMER` has about 15.6 ms granularity and its ticks are coalesced, and so does a
+// message wait timeout. A high resolution waitable timer, available from Windows 10 1803,
+// fires within about a millisecond of the deadline. On older systems it's a plain
+// waitable timer, still with the pacer's absolute deadlines.
+
+#include <microlib/support-machinery.hpp>                   // Frame_pacer, SM_FAIL, in_, Non_copyable
+#include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
+#include <microlib/winapi++/Event_loop.hpp>                 // event_loop
+#include <microlib/winapi++/Unique_handle_.hpp>             // Unique_kernel_handle
+
+#include <stdint.h>         // int64_t
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#   define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION    0x00000002
+#endif
+
+namespace winapi {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::hopefully, sm::Non_copyable, sm::Frame_pacer;
+    using   std::max,                       // <algorithm>
+            std::function,                  // <functional>
+            std::to_string,                 // <string>
+            std::move;                      // <utility>
+    namespace chrono = std::chrono;
+
+    class Frame_ticker:
+        public Non_copyable
+    {
+    public:
+        using Tick = Frame_pacer::Tick;
+
+    private:
+        Frame_pacer                 m_pacer;
+        function<void( in_<Tick> )> m_on_frame;
+        Unique_kernel_handle        m_timer;
+
+        static auto new_timer()
+            -> HANDLE
+        {
+            const HANDLE result = ::CreateWaitableTimerExW(
+                nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS
+                );
+            if( result != 0 ) {
+                return result;
+            }
+            return ::CreateWaitableTimerW( nullptr, false, nullptr );
+        }
+
+        void arm()
+        {
+            using Units = chrono::duration<int64_t, std::ratio<1, 10'000'000>>;    // 100 ns.
+            const auto remaining = m_pacer.next_deadline() - Frame_pacer::Clock::now();
+            LARGE_INTEGER due_time;
+            due_time.QuadPart = -max<int64_t>( 1, chrono::ceil<Units>( remaining ).count() );  // Negative: relative.
+            ::SetWaitableTimer( m_timer, &due_time, 0, nullptr, nullptr, false )
+                or SM_FAIL( "::SetWaitableTimer failed, error code " + to_string( ::GetLastError() ) + "." );
+        }
+
+        // Re-arms before the callback, so that an exception from it doesn't stop the ticking.
+        void on_timer()
+        {
+            const auto tick = m_pacer.tick( Frame_pacer::Clock::now() );
+            arm();
+            if( tick ) {
+                m_on_frame( *tick );
+            }
+        }
+
+    public:
+        ~Frame_ticker()
+        {
+            ::CancelWaitableTimer( m_timer );
+            event_loop().remove_waitable( m_timer );
+        }
+
+        Frame_ticker( const int fps, function<void( in_<Tick> )> on_frame ):
+            m_pacer( fps ),
+            m_on_frame( move( on_frame ) ),
+            m_timer( new_timer() )
+        {
+            hopefully( not m_timer.is_empty() )
+                or SM_FAIL( "Failed to create a waitable timer, error code " + to_string( ::GetLastError() ) + "." );
+            event_loop().add_waitable( m_timer, [this]{ on_timer(); } );
+            arm();
+        }
+
+        auto pacer() const -> const Frame_pacer& { return m_pacer; }
+    };
+}  // namespace winapi
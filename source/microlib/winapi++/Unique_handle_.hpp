@@ -1,24 +1,30 @@
 ﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
 
+#include <microlib/support-machinery/Unique_handle_.hpp>    // Unique_handle_, Unique_handle_with_, Handle_pool_
 #include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
 
 namespace winapi {
-    template< class Handle, void(*destroy)(Handle) >
-    class Unique_handle_
-    {
-        Handle      m_handle;
-        
-    public:
-        ~Unique_handle_() { destroy( m_handle ); }
-        Unique_handle_( const Handle handle ): m_handle( handle ) {}
-        
-        auto value() const -> Handle { return m_handle; }
-        operator Handle() const { return value(); }
-    };
-    
+    namespace sm = support_machinery;
+    using   sm::Unique_handle_, sm::Unique_handle_with_, sm::Destroy_function_,
+            sm::Handle_pool_, sm::Pooled_handle_;
+
     inline void destroy_bitmap( const HBITMAP bmp ) { ::DeleteObject( bmp ); }
     inline void destroy_brush( const HBRUSH br ) { ::DeleteObject( br ); }
+    inline void destroy_font( const HFONT font ) { ::DeleteObject( font ); }
+    inline void destroy_memory_dc( const HDC dc ) { ::DeleteDC( dc ); }
+    inline void destroy_region( const HRGN region ) { ::DeleteObject( region ); }
+    inline void destroy_kernel_object( const HANDLE h ) { ::CloseHandle( h ); }
 
     using Unique_bmp_handle     = Unique_handle_<HBITMAP, destroy_bitmap>;
     using Unique_brush_handle   = Unique_handle_<HBRUSH, destroy_brush>;
+    using Unique_font_handle    = Unique_handle_<HFONT, destroy_font>;
+    using Unique_memory_dc      = Unique_handle_<HDC, destroy_memory_dc>;
+    using Unique_region_handle  = Unique_handle_<HRGN, destroy_region>;
+    using Unique_kernel_handle  = Unique_handle_<HANDLE, destroy_kernel_object>;   // Not for `INVALID_HANDLE_VALUE`.
+
+    static_assert( sizeof( Unique_bmp_handle ) == sizeof( HBITMAP ) );
+
+    // E.g. `Bmp_pool pool( 4 );`, then `pool.acquire( [&]{ return ::CreateCompatibleBitmap( dc, w, h ); } )`.
+    using Bmp_pool              = Handle_pool_<HBITMAP, Destroy_function_<HBITMAP, destroy_bitmap>>;
+    using Memory_dc_pool        = Handle_pool_<HDC, Destroy_function_<HDC, destroy_memory_dc>>;
 }  // namespace winapi
@@ -0,0 +1,88 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Creation of a form's child controls in one batch, from `graphics::Control_spec` data.
+//
+// Redrawing of a visible parent is turned off while the controls are created, their font is set
+// without a repaint, and at the end the area of the new controls is invalidated once. For a hidden
+// parent, e.g. in `WM_CREATE`, redrawing is left alone, because `WM_SETREDRAW` with `true` would
+// make the parent visible.
+
+#include <microlib/graphics/form-layout.hpp>                        // Control_spec, Flow_layout, create_controls
+#include <microlib/support-machinery.hpp>                           // SM_FAIL, hopefully, Non_copyable
+#include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
+#include <microlib/winapi++/gui.hpp>                                // set_font_of, ui_font
+#include <microlib/winapi++/pixel-output.hpp>                       // to_winapi_rect
+#include <microlib/winapi++/resource-handling.hpp>                  // h_instance
+
+#include <vector>
+
+namespace winapi {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::hopefully, sm::Non_copyable;
+    using   std::vector;
+
+    class Child_window_batch:
+        public Non_copyable
+    {
+        HWND    m_parent;
+        HFONT   m_font;
+        bool    m_redraw_is_off;
+
+    public:
+        using Handle = HWND;
+
+        Child_window_batch( const HWND parent, const HFONT font ):
+            m_parent( parent ), m_font( font ), m_redraw_is_off( false )
+        {}
+
+        void begin_batch()
+        {
+            if( ::IsWindowVisible( m_parent ) ) {
+                ::SendMessage( m_parent, WM_SETREDRAW, false, 0 );
+                m_redraw_is_off = true;
+            }
+        }
+
+        auto create( in_<graphics::Control_spec> spec, in_<graphics::Rect> placement )
+            -> HWND
+        {
+            const HWND window = ::CreateWindow(
+                spec.class_name,                                                    // lpClassName,
+                spec.text,                                                          // lpWindowName
+                spec.styles | WS_CHILD,                                             // dwStyle
+                placement.left, placement.top,                                      // x, y
+                graphics::width_of( placement ), graphics::height_of( placement ),  // w, h
+                m_parent,                                                           // hWndParent
+                reinterpret_cast<HMENU>( static_cast<INT_PTR>( spec.id ) ),         // Id
+                h_instance,                                                         // hInstance
+                nullptr                                                             // lpParam
+                );
+            hopefully( window != 0 ) or SM_FAIL( "::CreateWindow failed." );
+            set_font_of( window, m_font, false );
+            return window;
+        }
+
+        void destroy( const HWND window ) { ::DestroyWindow( window ); }
+
+        void end_batch( in_<graphics::Rect> bounds )
+        {
+            if( m_redraw_is_off ) {
+                ::SendMessage( m_parent, WM_SETREDRAW, true, 0 );
+                m_redraw_is_off = false;
+            }
+            const RECT r = to_winapi_rect( bounds );
+            ::RedrawWindow( m_parent, &r, 0, RDW_INVALIDATE | RDW_ERASE | RDW_ALLCHILDREN );
+        }
+    };
+
+    // The windows are in the order of the specs.
+    inline auto new_child_windows_of(
+        const HWND                              parent,
+        in_<vector<graphics::Control_spec>>     controls,
+        in_<graphics::Flow_layout>              layout
+        ) -> vector<HWND>
+    {
+        Child_window_batch batch( parent, ui_font() );
+        return graphics::create_controls( batch, controls, layout );
+    }
+}  // namespace winapi
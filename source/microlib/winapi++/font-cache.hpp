@@ -0,0 +1,151 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A process wide, thread safe cache of fonts keyed by face, height, weight, slant and DPI,
+// shared by the window creation functions, e.g. via `ui_font()`.
+//
+// A font that's evicted may still be used by windows, so no font that has been handed out is
+// destroyed before the next `invalidate()`, on a settings change. It returns the old fonts, for the
+// caller to keep until the windows that use them have new fonts.
+
+#include <microlib/graphics/Font_cache_.hpp>                        // Font_cache_
+#include <microlib/graphics/Font_key.hpp>                           // Font_key, scaled_for_dpi
+#include <microlib/support-machinery.hpp>                           // SM_FAIL, Non_copyable
+#include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
+#include <microlib/winapi++/Unique_handle_.hpp>                     // Unique_font_handle
+
+#include <functional>       // std::invoke
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+
+namespace winapi {
+    namespace sm = support_machinery;
+    using   sm::hopefully, sm::in_, sm::Non_copyable, sm::Cache_stats;
+    using   std::invoke,                                // <functional>
+            std::unique_lock,                           // <mutex>
+            std::optional,
+            std::shared_mutex, std::shared_lock,        // <shared_mutex>
+            std::to_string;                             // <string>
+
+    inline auto get_ui_font_spec()   // Costly
+        -> LOGFONT
+    {
+        NONCLIENTMETRICS info = {sizeof( NONCLIENTMETRICS )};
+
+        ::SystemParametersInfo( SPI_GETNONCLIENTMETRICS, info.cbSize, &info, {} )
+            or SM_FAIL( "::SystemParametersInfo failed" );
+        return info.lfMessageFont;
+    }
+
+    // The DPI that e.g. `get_ui_font_spec` sizes are for. Fixed for a logon session.
+    inline auto system_dpi()
+        -> int
+    {
+        static const int the_dpi = invoke( []() -> int
+        {
+            const HDC dc = ::GetDC( 0 );
+            const int result = ::GetDeviceCaps( dc, LOGPIXELSY );
+            ::ReleaseDC( 0, dc );
+            return result;
+        } );
+        return the_dpi;
+    }
+
+    // Only the face, height, weight and slant of `spec` are used.
+    class Font_cache:
+        public Non_copyable
+    {
+        graphics::Font_cache_<Unique_font_handle>   m_fonts;
+
+        mutable shared_mutex    m_ui_spec_mutex;
+        optional<LOGFONT>       m_ui_spec;
+
+    public:
+        using Removed_fonts = graphics::Font_cache_<Unique_font_handle>::Removed_fonts;
+
+        explicit Font_cache( const int capacity = 16 ): m_fonts( capacity ) {}
+
+        auto stats() const      -> Cache_stats  { return m_fonts.stats(); }
+        auto n_retired() const  -> int          { return m_fonts.n_retired(); }
+
+        // The `spec` height is for `system_dpi()`, and is scaled to `dpi`. The font is valid until
+        // the result of the next `invalidate()` is destroyed.
+        auto font( in_<LOGFONT> spec, const int dpi = system_dpi() )
+            -> HFONT
+        {
+            const int height = graphics::scaled_for_dpi( spec.lfHeight, dpi, system_dpi() );
+            const auto key = graphics::Font_key::of(
+                spec.lfFaceName, height, spec.lfWeight, spec.lfItalic != 0, dpi
+                );
+            return m_fonts.font( key, [&]() -> HFONT
+            {
+                LOGFONT scaled_spec = spec;
+                scaled_spec.lfHeight = height;
+                const HFONT result = ::CreateFontIndirect( &scaled_spec );
+                hopefully( result != 0 )
+                    or SM_FAIL( "::CreateFontIndirect failed, error code " + to_string( ::GetLastError() ) + "." );
+                return result;
+            } ).value();
+        }
+
+        auto ui_font_spec()
+            -> LOGFONT
+        {
+            {
+                const shared_lock<shared_mutex> lock( m_ui_spec_mutex );
+                if( m_ui_spec ) { return *m_ui_spec; }
+            }
+            const LOGFONT spec = get_ui_font_spec();
+            const unique_lock<shared_mutex> lock( m_ui_spec_mutex );
+            m_ui_spec = spec;
+            return spec;
+        }
+
+        auto ui_font( const int dpi = system_dpi() )
+            -> HFONT
+        { return font( ui_font_spec(), dpi ); }
+
+        // E.g. on `WM_SETTINGCHANGE`: later requests get new fonts, from the current settings. The
+        // old fonts, also those evicted, are destroyed when the result is.
+        auto invalidate()
+            -> Removed_fonts
+        {
+            {
+                const unique_lock<shared_mutex> lock( m_ui_spec_mutex );
+                m_ui_spec.reset();
+            }
+            return m_fonts.invalidate();
+        }
+    };
+
+    inline auto fonts()
+        -> Font_cache&
+    {
+        static Font_cache the_cache;
+        return the_cache;
+    }
+
+    inline auto ui_font( const int dpi = system_dpi() )
+        -> HFONT
+    { return fonts().ui_font( dpi ); }
+
+    // After a settings change: gives the window and its descendants the current UI font, and then
+    // destroys the fonts that were cached before. Assumes that these windows are their only users.
+    inline void refresh_ui_fonts_of( const HWND window )
+    {
+        struct Callback
+        {
+            static auto CALLBACK set_font( const HWND child, const LPARAM font ) -> BOOL
+            {
+                ::SendMessage( child, WM_SETFONT, static_cast<WPARAM>( font ), true );
+                return true;
+            }
+        };
+
+        const Font_cache::Removed_fonts old_fonts = fonts().invalidate();
+        const HFONT font = ui_font();
+        Callback::set_font( window, reinterpret_cast<LPARAM>( font ) );
+        ::EnumChildWindows( window, &Callback::set_font, reinterpret_cast<LPARAM>( font ) );
+    }
+}  // namespace winapi
@@ -0,0 +1,94 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// A bounded cache of GDI brushes keyed by their specification, so that e.g. background
+// erasure doesn't create and destroy a brush for every `WM_ERASEBKGND` and custom draw.
+//
+// Not thread safe: use from the GUI thread. A brush from the cache must not be destroyed by the
+// caller, and should be used only until the next cache access, which may evict it.
+
+#include <microlib/support-machinery.hpp>                           // hopefully, SM_FAIL
+#include <microlib/support-machinery/Lru_cache_.hpp>                // Lru_cache_, Cache_stats
+#include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
+#include <microlib/winapi++/Unique_handle_.hpp>                     // Unique_brush_handle
+
+#include <stddef.h>         // size_t
+#include <stdint.h>         // uintptr_t
+
+#include <functional>       // std::hash
+#include <string>
+
+namespace winapi {
+    namespace sm = support_machinery;
+    using   sm::in_, sm::hopefully, sm::Lru_cache_, sm::Cache_stats;
+    using   std::hash,                          // <functional>
+            std::to_string;                     // <string>
+
+    struct Brush_spec
+    {
+        enum Kind: int { solid, hatched, patterned };
+
+        Kind        kind;
+        COLORREF    color;          // For `solid` and `hatched`.
+        int         hatch_style;    // For `hatched`, e.g. `HS_DIAGCROSS`.
+        HBITMAP     pattern;        // For `patterned`. Must outlive the cached brush.
+
+        static auto solid_color( const COLORREF c )     -> Brush_spec { return {solid, c, 0, 0}; }
+        static auto pattern_of( const HBITMAP bmp )     -> Brush_spec { return {patterned, 0, 0, bmp}; }
+
+        static auto hatch( const int style, const COLORREF c )
+            -> Brush_spec
+        { return {hatched, c, style, 0}; }
+
+        friend auto operator==( in_<Brush_spec> a, in_<Brush_spec> b )
+            -> bool
+        {
+            return a.kind == b.kind and a.color == b.color
+                and a.hatch_style == b.hatch_style and a.pattern == b.pattern;
+        }
+
+        struct Hash
+        {
+            auto operator()( in_<Brush_spec> spec ) const
+                -> size_t
+            {
+                size_t h = hash<uintptr_t>()( reinterpret_cast<uintptr_t>( spec.pattern ) );
+                h = 31*h + size_t( spec.kind );
+                h = 31*h + size_t( spec.color );
+                h = 31*h + size_t( spec.hatch_style );
+                return h;
+            }
+        };
+    };
+
+    inline auto new_brush( in_<Brush_spec> spec )
+        -> HBRUSH
+    {
+        HBRUSH result = 0;
+        switch( spec.kind ) {
+            case Brush_spec::solid:     { result = ::CreateSolidBrush( spec.color );  break; }
+            case Brush_spec::hatched:   { result = ::CreateHatchBrush( spec.hatch_style, spec.color );  break; }
+            case Brush_spec::patterned: { result = ::CreatePatternBrush( spec.pattern );  break; }
+        }
+        hopefully( result != 0 )
+            or SM_FAIL( "Failed to create a brush, error code " + to_string( ::GetLastError() ) + "." );
+        return result;
+    }
+
+    class Brush_cache
+    {
+        Lru_cache_<Brush_spec, Unique_brush_handle, Brush_spec::Hash>   m_brushes;
+
+    public:
+        explicit Brush_cache( const int capacity = 32 ): m_brushes( capacity ) {}
+
+        auto stats() const -> const Cache_stats& { return m_brushes.stats(); }
+
+        auto brush( in_<Brush_spec> spec )
+            -> HBRUSH
+        { return m_brushes.get_or_make( spec, [&]() -> HBRUSH { return new_brush( spec ); } ); }
+
+        auto solid_brush( const COLORREF color )
+            -> HBRUSH
+        { return brush( Brush_spec::solid_color( color ) ); }
+    };
+}  // namespace winapi
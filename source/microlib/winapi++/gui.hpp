@@ -2,19 +2,24 @@
 
 #include <microlib/support-machinery.hpp>                           // SM_FAIL
 #include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
+#include <microlib/winapi++/Event_loop.hpp>                         // event_loop
+#include <microlib/winapi++/font-cache.hpp>                         // ui_font
 #include <microlib/winapi++/resource-handling.hpp>                  // h_instance
+#include <microlib/winapi++/window-text-cache.hpp>                   // cached_title_of
 
 #include <assert.h>         // assert
 #include <stddef.h>         // offsetof
 #include <stdint.h>         // uintptr_t
 
+#include <functional>
 #include <stdexcept>
 #include <string>
 #include <variant>
 
 namespace winapi {
     namespace sm = support_machinery;
-    using   std::exception,                     // <stdexcept>
+    using   std::function,                      // <functional>
+            std::exception,                     // <stdexcept>
             std::string, std::to_string,        // <string>
             std::variant, std::get;             // <variant>
     using   sm::const_, sm::ref_, sm::in_,
@@ -22,7 +27,7 @@ namespace winapi {
             sm::hopefully,
             sm::C_string_ptr,
             sm::Option_,
-            sm::Option_refs_,
+            sm::Option_pack_,
             sm::Type_list_;
 
     using   Point       = POINT;
@@ -86,35 +91,9 @@ namespace winapi {
             );
     }
             
-    inline void set_font_of( const HWND window, const HFONT font )
+    inline void set_font_of( const HWND window, const HFONT font, const bool redraw = true )
     {
-        ::SendMessage( window, WM_SETFONT, reinterpret_cast<WPARAM>( font ), true );
-    }
-
-    inline auto get_ui_font_spec()   // Costly
-        -> LOGFONT
-    {
-        NONCLIENTMETRICS info = {sizeof( NONCLIENTMETRICS )};
-        
-        ::SystemParametersInfo( SPI_GETNONCLIENTMETRICS, info.cbSize, &info, {} )
-            or SM_FAIL( "::SystemParametersInfo failed" );
-        return info.lfMessageFont;
-    }
-    
-    inline auto ui_font_spec()
-        -> const LOGFONT&
-    {
-        static const LOGFONT the_spec = get_ui_font_spec();
-        return the_spec;
-    }
-
-    inline auto ui_font()
-        -> HFONT
-    {
-        static const HFONT the_font = ::CreateFontIndirect( &ui_font_spec() );
-        hopefully( the_font != 0 )
-            or SM_FAIL( "::CreateFontIndirect failed" );
-        return the_font;
+        ::SendMessage( window, WM_SETFONT, reinterpret_cast<WPARAM>( font ), redraw );
     }
 
     class Name
@@ -189,51 +168,53 @@ namespace winapi {
     using Toplevel_window_option_types  = Common_window_option_types::Plus_<
         With_title, With_parent, With_icon, With_menu
     >;
-    using Toplevel_window_options       = Toplevel_window_option_types::Specialization_of_<Option_refs_>;
+    template< class... Options >
+    using Toplevel_window_options_      = Option_pack_<Toplevel_window_option_types, Options...>;
 
     template< class... Options >
     inline auto new_toplevel_window( const Name class_id, in_<Options>... options )
         -> HWND
     {
-        const Toplevel_window_options option_refs( options... );
-        const DWORD     styles      = option_refs | With_styles{ WS_OVERLAPPEDWINDOW };
-        const Point     position    = option_refs | With_position{ CW_USEDEFAULT, CW_USEDEFAULT };
-        const Rect_size rect_size   = option_refs | With_rect_size{ 640, 400 };
+        const Toplevel_window_options_<Options...> option_pack( options... );
+        const DWORD     styles      = option_pack | With_styles{ WS_OVERLAPPEDWINDOW };
+        const Point     position    = option_pack | With_position{ CW_USEDEFAULT, CW_USEDEFAULT };
+        const Rect_size rect_size   = option_pack | With_rect_size{ 640, 400 };
 
         static_assert( WS_OVERLAPPED == 0 );        // I.e. this style is the default.
         assert( (styles & WS_CHILD) == 0 );
 
         const HWND window = ::CreateWindow(
             class_id.as_pointer(),                                                  // lpClassName,
-            option_refs | With_title{ "<unspecified title>" },                      // lpWindowName
+            option_pack | With_title{ "<unspecified title>" },                      // lpWindowName
             styles,                                                                 // dwStyle
             position.x, position.y,                                                 // x, y
             rect_size.cx, rect_size.cy,                                             // w, h
-            option_refs | With_parent{},                                            // hWndParent
-            option_refs | With_menu{},                                              // hMenu
+            option_pack | With_parent{},                                            // hWndParent
+            option_pack | With_menu{},                                              // hMenu
             h_instance,                                                             // hInstance
-            option_refs | With_custom_param{}                                       // lpParam
+            option_pack | With_custom_param{}                                       // lpParam
             );
         hopefully( window != 0 ) or SM_FAIL( "::CreateWindow failed." );
 
         set_font_of( window, ui_font() );
-        if( const HICON icon = option_refs | With_icon{} ) {
+        if( const HICON icon = option_pack | With_icon{} ) {
             set_icon_of( window, icon );
         }
         return window;
     }
 
     using Child_window_option_types     = Common_window_option_types::Plus_< With_text, With_id >;
-    using Child_window_options          = Child_window_option_types::Specialization_of_<Option_refs_>;
+    template< class... Options >
+    using Child_window_options_         = Option_pack_<Child_window_option_types, Options...>;
 
     template< class... Options >
     inline auto new_child_window_of( const HWND parent, const Name class_id, in_<Options>... options )
         -> HWND
     {
-        const Child_window_options option_refs( options... );
-        const DWORD     styles      = (option_refs | With_styles{ WS_CHILD | WS_VISIBLE }) | WS_CHILD;
-        const Point     position    = option_refs | With_position{ CW_USEDEFAULT, CW_USEDEFAULT };
-        const Rect_size rect_size   = option_refs | With_rect_size{ 64, 40 };
+        const Child_window_options_<Options...> option_pack( options... );
+        const DWORD     styles      = (option_pack | With_styles{ WS_CHILD | WS_VISIBLE }) | WS_CHILD;
+        const Point     position    = option_pack | With_position{ CW_USEDEFAULT, CW_USEDEFAULT };
+        const Rect_size rect_size   = option_pack | With_rect_size{ 64, 40 };
 
         static_assert( WS_OVERLAPPED == 0 );        // I.e. this style is the default.
         assert( (styles & WS_POPUP) == 0 );
@@ -241,14 +222,14 @@ namespace winapi {
 
         const HWND window = ::CreateWindow(
             class_id.as_pointer(),                                                  // lpClassName,
-            option_refs | With_text{ "" },                                          // lpWindowName
+            option_pack | With_text{ "" },                                          // lpWindowName
             styles,                                                                 // dwStyle
             position.x, position.y,                                                 // x, y
             rect_size.cx, rect_size.cy,                                             // w, h
             parent,                                                                 // hWndParent
-            reinterpret_cast<HMENU>( (option_refs | With_id{}).value ),             // Id
+            reinterpret_cast<HMENU>( (option_pack | With_id{}).value ),             // Id
             h_instance,                                                             // hInstance
-            option_refs | With_custom_param{}                                       // lpParam
+            option_pack | With_custom_param{}                                       // lpParam
             );
         hopefully( window != 0 ) or SM_FAIL( "::CreateWindow failed." );
         set_font_of( window, ui_font() );
@@ -259,19 +240,6 @@ namespace winapi {
         -> DWORD
     { return ::GetWindowLongPtr( window, GWL_STYLE ); }
     
-    inline auto title_of( const HWND window )
-        -> string
-    {
-        if( (styles_of( window ) & WS_CAPTION) == 0 ) {
-            return "";
-        }
-        const int buffer_size = 1 + ::GetWindowTextLength( window );
-        auto result = string( buffer_size, '\0' );
-        const int string_length = ::GetWindowText( window, result.data(), result.size() );
-        result.resize( string_length );
-        return result;
-    }
-
     inline auto rect_of( const HWND window )
         -> Rect
     {
@@ -368,26 +336,22 @@ namespace winapi {
         };
 
         SM_WITH( Cbt_hook() ) {
-            const string title = (parent? title_of( parent ) : exe_name());
+            const string title = (parent? string( cached_title_of( parent ) ) : exe_name());
             Cbt_hook::is_active() = true;
             return ::MessageBox( parent, text, title.c_str(), flags | (parent? 0 : MB_TASKMODAL) );
         }
     }
 
+    // A function that posts the specified message, e.g. to notify the GUI thread from a worker thread.
+    inline auto message_poster( const HWND window, const UINT msg_id, const WPARAM w_param = 0, const LPARAM ell_param = 0 )
+        -> function<void()>
+    {
+        return [=]() noexcept { ::PostMessage( window, msg_id, w_param, ell_param ); };
+    }
+
+    // Dispatches window messages, waitable object signals and timers until `WM_QUIT`.
     inline void dispatch_messages()
     {
-        for( ;; ) {
-            MSG msg = {};
-            if( ::GetMessage( &msg, 0, 0, 0 ) < 0 ) {
-                SM_FAIL( "::GetMessage failed" );
-            } else if( msg.message == WM_QUIT ) {
-                hopefully( msg.wParam == 0 )
-                    or SM_FAIL( "Something failed, error code " + to_string( msg.wParam ) + "." );
-                return;
-            }
-            ::TranslateMessage( &msg );
-            ::DispatchMessage( &msg );
-            rethrow_popped_exception();     // If any.
-        }
+        event_loop().run();
     }
 }  // namespace winapi
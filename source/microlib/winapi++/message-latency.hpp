@@ -0,0 +1,103 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Opt-in timing of window message handling, per message id, in a per-thread `Latency_table`.
+//
+// E.g. at the start of a window procedure, `const auto timing = Message_timing( msg_id, enabled );`.
+// A nested message, e.g. one sent by a handler, is also included in the outer message's time.
+
+#include <microlib/support-machinery.hpp>                   // Latency_table, Non_copyable
+#include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
+
+#include <stdint.h>         // uint32_t
+#include <stdio.h>          // FILE, stderr, snprintf
+
+#include <chrono>
+#include <string>
+
+namespace winapi {
+    namespace sm = support_machinery;
+    using   sm::Latency_table, sm::Non_copyable;
+    using   std::string;
+    namespace chrono = std::chrono;
+
+    inline auto message_name( const UINT msg_id )
+        -> string
+    {
+        struct Named{ UINT id; const char* name; };
+        #define WINAPI_NAMED( m ) Named{ m, #m }
+        static const Named common_messages[] =
+        {
+            WINAPI_NAMED( WM_CREATE ),          WINAPI_NAMED( WM_DESTROY ),         WINAPI_NAMED( WM_MOVE ),
+            WINAPI_NAMED( WM_SIZE ),            WINAPI_NAMED( WM_ACTIVATE ),        WINAPI_NAMED( WM_SETFOCUS ),
+            WINAPI_NAMED( WM_KILLFOCUS ),       WINAPI_NAMED( WM_SETREDRAW ),       WINAPI_NAMED( WM_SETTEXT ),
+            WINAPI_NAMED( WM_GETTEXT ),         WINAPI_NAMED( WM_GETTEXTLENGTH ),   WINAPI_NAMED( WM_PAINT ),
+            WINAPI_NAMED( WM_CLOSE ),           WINAPI_NAMED( WM_ERASEBKGND ),      WINAPI_NAMED( WM_SHOWWINDOW ),
+            WINAPI_NAMED( WM_SETTINGCHANGE ),   WINAPI_NAMED( WM_ACTIVATEAPP ),     WINAPI_NAMED( WM_SETCURSOR ),
+            WINAPI_NAMED( WM_MOUSEACTIVATE ),   WINAPI_NAMED( WM_GETMINMAXINFO ),   WINAPI_NAMED( WM_SETFONT ),
+            WINAPI_NAMED( WM_WINDOWPOSCHANGING ),   WINAPI_NAMED( WM_WINDOWPOSCHANGED ),
+            WINAPI_NAMED( WM_NOTIFY ),          WINAPI_NAMED( WM_GETICON ),         WINAPI_NAMED( WM_SETICON ),
+            WINAPI_NAMED( WM_NCCREATE ),        WINAPI_NAMED( WM_NCDESTROY ),       WINAPI_NAMED( WM_NCCALCSIZE ),
+            WINAPI_NAMED( WM_NCHITTEST ),       WINAPI_NAMED( WM_NCPAINT ),         WINAPI_NAMED( WM_NCACTIVATE ),
+            WINAPI_NAMED( WM_NCMOUSEMOVE ),     WINAPI_NAMED( WM_KEYDOWN ),         WINAPI_NAMED( WM_KEYUP ),
+            WINAPI_NAMED( WM_CHAR ),            WINAPI_NAMED( WM_COMMAND ),         WINAPI_NAMED( WM_SYSCOMMAND ),
+            WINAPI_NAMED( WM_TIMER ),           WINAPI_NAMED( WM_CTLCOLORBTN ),     WINAPI_NAMED( WM_CTLCOLORSTATIC ),
+            WINAPI_NAMED( WM_MOUSEMOVE ),       WINAPI_NAMED( WM_LBUTTONDOWN ),     WINAPI_NAMED( WM_LBUTTONUP ),
+            WINAPI_NAMED( WM_CAPTURECHANGED ),  WINAPI_NAMED( WM_ENTERSIZEMOVE ),   WINAPI_NAMED( WM_EXITSIZEMOVE ),
+            WINAPI_NAMED( WM_DPICHANGED ),      WINAPI_NAMED( WM_PRINTCLIENT )
+        };
+        #undef WINAPI_NAMED
+
+        for( const Named& m: common_messages ) {
+            if( m.id == msg_id ) { return m.name; }
+        }
+        char buffer[32];
+        if( msg_id >= WM_APP ) {
+            snprintf( buffer, sizeof( buffer ), "WM_APP + %u", unsigned( msg_id - WM_APP ) );
+        } else if( msg_id >= WM_USER ) {
+            snprintf( buffer, sizeof( buffer ), "WM_USER + %u", unsigned( msg_id - WM_USER ) );
+        } else {
+            snprintf( buffer, sizeof( buffer ), "0x%04X", unsigned( msg_id ) );
+        }
+        return buffer;
+    }
+
+    // Allocated on first use in the thread, so that recording doesn't allocate.
+    inline auto message_latencies()
+        -> Latency_table&
+    {
+        thread_local Latency_table the_table;
+        return the_table;
+    }
+
+    class Message_timing:
+        public Non_copyable
+    {
+        using Clock = chrono::steady_clock;
+
+        UINT                m_msg_id;
+        bool                m_is_enabled;
+        Clock::time_point   m_start;
+
+    public:
+        ~Message_timing()
+        {
+            if( m_is_enabled ) {
+                const auto ns = chrono::duration_cast<chrono::nanoseconds>( Clock::now() - m_start ).count();
+                message_latencies().record( uint32_t( m_msg_id ), ns );
+            }
+        }
+
+        Message_timing( const UINT msg_id, const bool is_enabled ):
+            m_msg_id( msg_id ),
+            m_is_enabled( is_enabled ),
+            m_start( is_enabled? Clock::now() : Clock::time_point() )
+        {}
+    };
+
+    // The current thread's message latencies, e.g. at shutdown.
+    inline void write_message_latency_summary_to( FILE* const f = stderr )
+    {
+        fprintf( f, "Window message handling times in this thread:\n" );
+        message_latencies().write_summary_to( f, []( const uint32_t id ) { return message_name( id ); } );
+    }
+}  // namespace winapi
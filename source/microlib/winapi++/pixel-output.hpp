@@ -0,0 +1,110 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Output of portable `graphics` pixel views to a device context, geometry conversions, and the
+// rectangles to repaint.
+
+#include <microlib/graphics/geometry.hpp>                   // Point, Rect, contains
+#include <microlib/graphics/pixels.hpp>                     // Const_bgra_view
+#include <microlib/support-machinery.hpp>                   // in_, zero_to
+#include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
+
+#include <assert.h>         // assert
+
+namespace winapi {
+    namespace sm = support_machinery;
+    using   sm::in_;
+
+    inline auto to_graphics_rect( in_<RECT> r )
+        -> graphics::Rect
+    {
+        const auto i = []( const LONG v ) -> int { return static_cast<int>( v ); };
+        return { i( r.left ), i( r.top ), i( r.right ), i( r.bottom ) };
+    }
+
+    inline auto to_winapi_rect( in_<graphics::Rect> r )
+        -> RECT
+    { return { r.left, r.top, r.right, r.bottom }; }
+
+    // A BITMAPINFO for top-down 32bpp pixels, as in a `graphics::Bgra_image`.
+    inline auto bgra_bitmap_info( const int width, const int height )
+        -> BITMAPINFO
+    {
+        BITMAPINFO result = {};
+        BITMAPINFOHEADER& header = result.bmiHeader;
+        header.biSize           = sizeof( BITMAPINFOHEADER );
+        header.biWidth          = width;
+        header.biHeight         = -height;      // Negative for top-down.
+        header.biPlanes         = 1;
+        header.biBitCount       = 32;
+        header.biCompression    = BI_RGB;
+        return result;
+    }
+
+    // The pixels must be stored top-down with contiguous rows, e.g. a whole `Bgra_image`.
+    // Alpha is ignored.
+    inline void draw_pixels( const HDC dc, in_<graphics::Point> position, in_<graphics::Const_bgra_view> pixels )
+    {
+        assert( pixels.has_contiguous_rows() );
+        const BITMAPINFO info = bgra_bitmap_info( pixels.width(), pixels.height() );
+        ::SetDIBitsToDevice(
+            dc, position.x, position.y, pixels.width(), pixels.height(),
+            0, 0, 0, pixels.height(),
+            pixels.row( 0 ), &info, DIB_RGB_COLORS
+            );
+    }
+
+    // Draws only the `part` of the pixels, e.g. a dirty rectangle, at the given position.
+    inline void draw_pixels(
+        const HDC                       dc,
+        in_<graphics::Point>            position,
+        in_<graphics::Const_bgra_view>  pixels,
+        in_<graphics::Rect>             part
+        )
+    {
+        assert( pixels.has_contiguous_rows() );
+        assert( graphics::contains( pixels.bounds(), part ) );
+        const BITMAPINFO info = bgra_bitmap_info( pixels.width(), pixels.height() );
+        ::SetDIBitsToDevice(        // For a top-down DIB the source origin is the upper left corner.
+            dc, position.x, position.y, graphics::width_of( part ), graphics::height_of( part ),
+            part.left, part.top, 0, pixels.height(),
+            pixels.row( 0 ), &info, DIB_RGB_COLORS
+            );
+    }
+
+    // The rectangles of a window's update region, which `BeginPaint` only reports as their
+    // bounding rectangle. Must be obtained before `BeginPaint`, which validates the region. With
+    // more than `max_rects` rectangles it's just the bounding rectangle.
+    class Update_rects
+    {
+    public:
+        static constexpr int max_rects = 8;
+
+    private:
+        int                 m_n_rects;
+        graphics::Rect      m_rects[max_rects];
+
+    public:
+        // The `scratch_region` is any region, e.g. `CreateRectRgn( 0, 0, 0, 0 )`, reused across calls.
+        Update_rects( const HWND window, const HRGN scratch_region ):
+            m_n_rects( 0 ), m_rects()
+        {
+            const int region_kind = ::GetUpdateRgn( window, scratch_region, false );
+            if( region_kind == NULLREGION or region_kind == ERROR ) {
+                return;
+            }
+            struct{ RGNDATAHEADER header; RECT rects[max_rects]; } data;
+            if( ::GetRegionData( scratch_region, sizeof( data ), reinterpret_cast<RGNDATA*>( &data ) ) != 0 ) {
+                m_n_rects = static_cast<int>( data.header.nCount );
+                for( const int i: sm::zero_to( m_n_rects ) ) { m_rects[i] = to_graphics_rect( data.rects[i] ); }
+            } else {
+                RECT bounds;
+                ::GetRgnBox( scratch_region, &bounds );
+                m_rects[0] = to_graphics_rect( bounds );
+                m_n_rects = 1;
+            }
+        }
+
+        auto begin() const  -> const graphics::Rect*    { return m_rects; }
+        auto end() const    -> const graphics::Rect*    { return m_rects + m_n_rects; }
+    };
+}  // namespace winapi
@@ -1,5 +1,6 @@
 ﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
 
+#include <microlib/support-machinery.hpp>                           // Byte_span, SM_FAIL
 #include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
 
 #include <type_traits>
@@ -8,7 +9,8 @@
 namespace winapi {
     namespace sm = support_machinery;
     using   sm::const_, sm::in_,
-            sm::bits_per_;
+            sm::bits_per_,
+            sm::Byte, sm::Byte_span, sm::Size, sm::hopefully;
     using   std::is_integral_v,                 // <type_traits>
             std::string, std::to_string;        // <string>
 
@@ -33,4 +35,18 @@ namespace winapi {
     inline auto atom_id_string( const ATOM id )
         -> string
     { return "#" + to_string( id ); }
+
+    // The bytes of a resource are mapped into memory with the executable, so no copying is needed.
+    inline auto resource_bytes( const ATOM id, const_<const char*> type )
+        -> Byte_span
+    {
+        const HRSRC h_info = ::FindResource( h_instance, as_pseudo_ptr( id ), type );
+        hopefully( h_info != 0 )
+            or SM_FAIL( "::FindResource failed for resource " + atom_id_string( id ) + "." );
+        const HGLOBAL h_data = ::LoadResource( h_instance, h_info );
+        const auto p_first = static_cast<const Byte*>( h_data? ::LockResource( h_data ) : nullptr );
+        hopefully( p_first != nullptr )
+            or SM_FAIL( "::LoadResource failed for resource " + atom_id_string( id ) + "." );
+        return Byte_span( p_first, Size( ::SizeofResource( h_instance, h_info ) ) );
+    }
 }  // namespace winapi
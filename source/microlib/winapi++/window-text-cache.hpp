@@ -0,0 +1,136 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Cached window texts, e.g. titles, as `string_view`s of null-terminated strings.
+//
+// A window whose text is cached is subclassed so that `WM_SETTEXT`, `WM_STYLECHANGED` and
+// `WM_SETTINGCHANGE` invalidate its entry, and `WM_NCDESTROY` removes it. A repeat read is a
+// hash table lookup, with no Windows API call and no allocation. The text of a window that can't be
+// subclassed, e.g. one that belongs to another thread, is read anew each time and not cached.
+//
+// Each entry owns its window's current text, so a window whose text changes often, e.g. a title
+// with a progress percentage, uses the memory for one text, not one per distinct text.
+
+#include <microlib/support-machinery.hpp>                           // Non_copyable
+#include <microlib/winapi-header-wrappers/windows-h.for-utf8.hpp>
+#include <commctrl.h>                                               // SetWindowSubclass
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace winapi {
+    namespace sm = support_machinery;
+    using   sm::Non_copyable;
+    using   std::string,
+            std::string_view,
+            std::unordered_map;
+
+    // Windows belong to the thread that created them, so there's one cache per thread.
+    class Window_text_cache:
+        public Non_copyable
+    {
+        struct Entry
+        {
+            string          text;
+            bool            has_caption;
+        };
+
+        static constexpr UINT_PTR subclass_id = 0x7E47;     // Arbitrary.
+
+        unordered_map<HWND, Entry>      m_entries;
+        Entry                           m_uncached_entry;   // For a window that can't be subclassed.
+
+        static auto CALLBACK subclass_proc(
+            const HWND          window,
+            const UINT          msg_id,
+            const WPARAM        w_param,
+            const LPARAM        ell_param,
+            UINT_PTR            ,               // Subclass id.
+            const DWORD_PTR     ref_data
+            ) -> LRESULT
+        {
+            auto& self = *reinterpret_cast<Window_text_cache*>( ref_data );
+            const LRESULT result = ::DefSubclassProc( window, msg_id, w_param, ell_param );
+            switch( msg_id ) {
+                case WM_SETTEXT:
+                case WM_STYLECHANGED:       { self.m_entries.erase( window );  break; }
+                case WM_SETTINGCHANGE:      { self.m_entries.clear();  break; }
+                case WM_NCDESTROY:          { self.forget( window );  break; }
+            }
+            return result;
+        }
+
+        // Reuses the buffer of `entry.text`.
+        static void read_into( Entry& entry, const HWND window )
+        {
+            const int length = ::GetWindowTextLength( window );
+            entry.text.resize( length + 1 );
+            const int n = ::GetWindowText( window, entry.text.data(), length + 1 );
+            entry.text.resize( n );
+            entry.has_caption = ((::GetWindowLongPtr( window, GWL_STYLE ) & WS_CAPTION) != 0);
+        }
+
+        auto entry_for( const HWND window )
+            -> const Entry&
+        {
+            const auto it = m_entries.find( window );
+            if( it != m_entries.end() ) {
+                return it->second;
+            }
+            const bool is_subclassed = (::SetWindowSubclass(
+                window, &subclass_proc, subclass_id, reinterpret_cast<DWORD_PTR>( this )
+                ) != 0);
+            Entry& entry = (is_subclassed? m_entries[window] : m_uncached_entry);
+            read_into( entry, window );
+            return entry;
+        }
+
+        void forget( const HWND window )
+        {
+            m_entries.erase( window );
+            ::RemoveWindowSubclass( window, &subclass_proc, subclass_id );
+        }
+
+    public:
+        ~Window_text_cache()
+        {
+            for( const auto& [window, entry]: m_entries ) {
+                (void) entry;
+                ::RemoveWindowSubclass( window, &subclass_proc, subclass_id );
+            }
+        }
+
+        Window_text_cache(): m_uncached_entry() {}
+
+        auto n_cached() const -> int { return static_cast<int>( m_entries.size() ); }
+
+        // The `data()` is null-terminated. It's valid until the window's text or style changes or the
+        // window is destroyed, or, for a window that can't be subclassed, until the next read.
+        auto text_of( const HWND window )
+            -> string_view
+        { return entry_for( window ).text; }
+
+        // Empty for a window without a title bar.
+        auto title_of( const HWND window )
+            -> string_view
+        {
+            const Entry& entry = entry_for( window );
+            return (entry.has_caption? entry.text : string_view( "" ));
+        }
+    };
+
+    inline auto window_texts()
+        -> Window_text_cache&
+    {
+        thread_local Window_text_cache the_cache;
+        return the_cache;
+    }
+
+    inline auto cached_text_of( const HWND window )
+        -> string_view
+    { return window_texts().text_of( window ); }
+
+    inline auto cached_title_of( const HWND window )
+        -> string_view
+    { return window_texts().title_of( window ); }
+}  // namespace winapi
@@ -0,0 +1,612 @@
+﻿// Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+// Benchmarks of the portable kernels, for each SIMD level the CPU supports.
+// Run with `--quick` for a short smoke run, as done by `ctest`; the numbers are then rough.
+
+#include <microlib/graphics.hpp>
+#include <microlib/support-machinery.hpp>
+
+#include <stdio.h>          // printf
+#include <stdlib.h>         // malloc, free
+#include <string.h>         // strcmp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace sm = support_machinery;
+using   sm::C_string_ptr, sm::Simd_level, sm::zero_to, sm::Interval, sm::in_;
+using   std::max, std::min,             // <algorithm>
+        std::exception_ptr, std::current_exception, std::rethrow_exception, std::throw_with_nested,
+        std::bad_alloc,                 // <new>
+        std::optional,                  // <optional>
+        std::mt19937,                   // <random>
+        std::runtime_error,             // <stdexcept>
+        std::string, std::to_string,
+        std::string_view,
+        std::unordered_set,
+        std::vector;
+namespace chrono = std::chrono;
+using namespace graphics;
+
+namespace {
+    using Clock = chrono::steady_clock;
+
+    const C_string_ptr level_names[] = {"scalar", "sse2", "avx2"};
+
+    // The best of `n_runs` timings of `f`, in seconds.
+    template< class Func >
+    auto best_seconds( const int n_runs, const Func& f )
+        -> double
+    {
+        double result = 1e99;
+        for( const int i: zero_to( n_runs ) ) {
+            (void) i;
+            const auto start = Clock::now();
+            f();
+            result = min( result, chrono::duration<double>( Clock::now() - start ).count() );
+        }
+        return result;
+    }
+
+    // Throughput in destination megapixels per second, a 64×64 sprite blitted at native and 4× scale.
+    void benchmark_blitting( const bool quick )
+    {
+        Bgra_image sprite( 64, 64 );
+        for( const int y: zero_to( 64 ) ) for( const int x: zero_to( 64 ) ) {
+            const bool is_background = ((x - 32)*(x - 32) + (y - 32)*(y - 32) > 28*28);
+            sprite.view()( x, y ) = (is_background? Bgra_pixel{255, 255, 255, 0} : Bgra_pixel{Byte( x ), Byte( y ), 90, Byte( 4*x )});
+        }
+        Bgra_image destination( 1280, 800 );
+        const int n_blits = (quick? 20 : 2000);
+
+        printf( "Blitting a 64×64 sprite, destination MP/s:\n" );
+        printf( "    %-8s %-16s %12s %12s\n", "level", "mode", "scale 1", "scale 4" );
+        const Blit_mode modes[] = {Blit_mode::opaque_copy(), Blit_mode::with_color_key( {255, 255, 255, 0} ), Blit_mode::alpha_blending()};
+        const C_string_ptr mode_names[] = {"opaque copy", "color key", "alpha blending"};
+        for( const int level: zero_to( int( sm::simd_level() ) + 1 ) ) {
+            const auto& kernels = blit_row_kernels_for( Simd_level::Enum( level ) );
+            for( const int i_mode: zero_to( 3 ) ) {
+                printf( "    %-8s %-16s", level_names[level], mode_names[i_mode] );
+                for( const int scale: {1, 4} ) {
+                    const double seconds = best_seconds( 3, [&]
+                    {
+                        for( const int i: zero_to( n_blits ) ) {
+                            const Point position = {(37*i) % (1280 - 64*scale), (13*i) % (800 - 64*scale)};
+                            blit( sprite.view(), destination.view(), position, modes[i_mode], scale, kernels );
+                        }
+                    } );
+                    printf( " %12.0f", double( n_blits )*(64*scale)*(64*scale)/seconds/1e6 );
+                }
+                printf( "\n" );
+            }
+        }
+    }
+
+    void benchmark_mirroring( const bool quick )
+    {
+        vector<Bgra_pixel> source( 4096 ), result( 4096 );
+        const int n_rows = (quick? 100 : 100'000);
+        printf( "Mirroring 4096 pixel rows, MP/s:\n" );
+        for( const int level: zero_to( int( sm::simd_level() ) + 1 ) ) {
+            const auto mirror_row = mirror_row_kernel_for( Simd_level::Enum( level ) );
+            const double seconds = best_seconds( 3, [&]
+            {
+                for( const int i: zero_to( n_rows ) ) { (void) i; mirror_row( source.data(), result.data(), 4096 ); }
+            } );
+            printf( "    %-8s %12.0f\n", level_names[level], 4096.0*n_rows/seconds/1e6 );
+        }
+    }
+
+    // A 64×64 sprite, shown at scale 2 from 32×32 cells, that walks across a 640×400 client area with
+    // frame bounds that vary, as the gladiator's do, plus a growing progress bar. The pixels of the
+    // dirty rectangles, versus of full client area repaints, and the time to fill them each frame.
+    void benchmark_dirty_repainting( const bool quick )
+    {
+        const Size client_size = {640, 400};
+        const Rect client_area = {0, 0, client_size.w, client_size.h};
+        const Rect bar_area = {10, 124, 260, 132};
+        const int n_frames = (quick? 50 : 2000);
+        Bgra_image back_buffer( client_size.w, client_size.h );
+        const Bgra_pixel bg_color = {240, 240, 240, 255};
+
+        const auto sprite_bounds = [&]( const int i_frame ) -> Rect
+        {
+            const int x = 10 + 2*(i_frame % 280);                    // Walking right, then starting over.
+            const int half_width = 18 + 2*(i_frame % 5);
+            return {x + 32 - half_width, 50 + 8, x + 32 + half_width, 50 + 64};
+        };
+        const auto bar_slice = [&]( const int i_frame ) -> Rect
+        {
+            const int right = bar_area.left + width_of( bar_area )*(i_frame % 100 + 1)/100;
+            return {right - width_of( bar_area )/100 - 1, bar_area.top, right, bar_area.bottom};
+        };
+
+        long long n_dirty_pixels = 0;
+        Dirty_rects dirty_rects;
+        const double dirty_seconds = best_seconds( 3, [&]
+        {
+            n_dirty_pixels = 0;
+            for( const int i: sm::one_through( n_frames - 1 ) ) {
+                dirty_rects.add( sprite_bounds( i - 1 ) );
+                dirty_rects.add( sprite_bounds( i ) );
+                dirty_rects.add( bar_slice( i ) );
+                for( const Rect& r: dirty_rects.rects() ) { fill( back_buffer.view().part( r ), bg_color ); }
+                n_dirty_pixels += dirty_rects.area();
+                dirty_rects.clear();
+            }
+        } );
+        const double full_seconds = best_seconds( 3, [&]
+        {
+            for( const int i: sm::one_through( n_frames - 1 ) ) { (void) i; fill( back_buffer.view(), bg_color ); }
+        } );
+        const long long n_full_pixels = (n_frames - 1)*area_of( client_area );
+        printf( "Repainting a walking sprite and a progress bar in a 640×400 client area, per frame:\n" );
+        printf( "    %-24s %12s %12s\n", "", "pixels", "µs fill" );
+        printf( "    %-24s %12lld %12.2f\n", "dirty rectangles", n_dirty_pixels/(n_frames - 1), dirty_seconds/(n_frames - 1)*1e6 );
+        printf( "    %-24s %12lld %12.2f\n", "full client area", n_full_pixels/(n_frames - 1), full_seconds/(n_frames - 1)*1e6 );
+    }
+
+    // Publishing a progress value via a `Triple_buffer_`, with and without the consumer's update in
+    // between, and with a consumer thread polling meanwhile, if there's more than one hardware thread.
+    void benchmark_triple_buffer( const bool quick )
+    {
+        struct Progress{ int n_steps_done; int n_steps; };
+        const int n_publishes = (quick? 1000 : 10'000'000);
+        sm::Triple_buffer_<Progress> buffer;
+        volatile int sink = 0;
+
+        const double publish_seconds = best_seconds( 3, [&]
+        {
+            for( const int i: zero_to( n_publishes ) ) { buffer.publish( {i, n_publishes} ); }
+        } );
+        const double round_trip_seconds = best_seconds( 3, [&]
+        {
+            for( const int i: zero_to( n_publishes ) ) {
+                buffer.publish( {i, n_publishes} );
+                if( buffer.update() ) { sink = buffer.front().n_steps_done; }
+            }
+        } );
+        printf( "Publishing via a triple buffer, ns per publish:\n" );
+        printf( "    %-24s %12.1f\n", "publish", publish_seconds/n_publishes*1e9 );
+        printf( "    %-24s %12.1f\n", "publish and update", round_trip_seconds/n_publishes*1e9 );
+        if( std::thread::hardware_concurrency() > 1 ) {
+            std::atomic<bool> is_done = false;
+            std::thread consumer( [&]
+            {
+                while( not is_done ) { if( buffer.update() ) { sink = buffer.front().n_steps_done; } }
+            } );
+            const double contended_seconds = best_seconds( 3, [&]
+            {
+                for( const int i: zero_to( n_publishes ) ) { buffer.publish( {i, n_publishes} ); }
+            } );
+            is_done = true;
+            consumer.join();
+            printf( "    %-24s %12.1f\n", "publish, polled", contended_seconds/n_publishes*1e9 );
+        }
+    }
+
+    // The cost of polling a `Cancellation_token`, and the time from `cancel()` until a worker thread
+    // has exited, for a worker that polls between 1 ms sleeps and for one woken by a callback.
+    void benchmark_cancellation( const bool quick )
+    {
+        const int n_polls = (quick? 1000 : 10'000'000);
+        const sm::Cancellation_source source;
+        const sm::Cancellation_token tokens[] = { source.token(), source.token().with_timeout( chrono::hours( 1 ) ) };
+        const C_string_ptr token_names[] = {"token", "token with deadline"};
+        volatile bool sink = false;
+        printf( "Polling for cancellation, ns per poll:\n" );
+        for( const int i: zero_to( 2 ) ) {
+            const double seconds = best_seconds( 3, [&]
+            {
+                for( const int j: zero_to( n_polls ) ) { (void) j; sink = tokens[i].is_cancelled(); }
+            } );
+            printf( "    %-24s %12.1f\n", token_names[i], seconds/n_polls*1e9 );
+        }
+
+        const int n_runs = (quick? 3 : 50);
+        printf( "Cancellation to worker exit, µs, average and max of %d:\n", n_runs );
+        for( const bool is_woken: {false, true} ) {
+            double sum_us = 0;
+            double max_us = 0;
+            for( const int i: zero_to( n_runs ) ) {
+                (void) i;
+                sm::Cancellation_source work_cancellation;
+                const sm::Cancellation_token cancellation = work_cancellation.token();
+                std::atomic<bool> is_started = false;
+                Clock::time_point exit_time;
+                std::thread worker( [&]
+                {
+                    is_started = true;
+                    if( is_woken ) {
+                        std::mutex m;
+                        std::condition_variable wakeup;
+                        const auto registration = cancellation.on_cancellation( [&]
+                        {
+                            const std::lock_guard<std::mutex> lock( m );
+                            wakeup.notify_one();
+                        } );
+                        std::unique_lock<std::mutex> lock( m );
+                        wakeup.wait( lock, [&]{ return cancellation.is_cancelled(); } );
+                    } else {
+                        while( not cancellation.is_cancelled() ) { std::this_thread::sleep_for( chrono::milliseconds( 1 ) ); }
+                    }
+                    exit_time = Clock::now();
+                } );
+                while( not is_started ) { std::this_thread::yield(); }
+                std::this_thread::sleep_for( chrono::microseconds( 2500 ) );
+                const Clock::time_point cancel_time = Clock::now();
+                work_cancellation.cancel();
+                worker.join();
+                const double us = chrono::duration<double, std::micro>( exit_time - cancel_time ).count();
+                sum_us += us;
+                max_us = max( max_us, us );
+            }
+            printf( "    %-24s %12.0f %12.0f\n", (is_woken? "woken by callback" : "polling each 1 ms"), sum_us/n_runs, max_us );
+        }
+    }
+
+    // Window message like ids: the handled ones, and ones that a window procedure typically ignores.
+    const unsigned handled_ids[]    = {0x0001, 0x0002, 0x0005, 0x000F, 0x0010, 0x0014, 0x0111, 0x0113, 0x0201, 0x8001};
+    const unsigned ignored_ids[]    = {0x0006, 0x0007, 0x0020, 0x0084, 0x00A0, 0x0200, 0x0281, 0x02A3};
+
+    long handled_sum = 0;
+    template< unsigned k > auto on_( const int a ) -> long { handled_sum += a + k; return long( k ); }
+
+    auto switch_dispatch( const unsigned id, const int a )
+        -> optional<long>
+    {
+        switch( id ) {
+            case 0x0001:    return on_<0x0001>( a );
+            case 0x0002:    return on_<0x0002>( a );
+            case 0x0005:    return on_<0x0005>( a );
+            case 0x000F:    return on_<0x000F>( a );
+            case 0x0010:    return on_<0x0010>( a );
+            case 0x0014:    return on_<0x0014>( a );
+            case 0x0111:    return on_<0x0111>( a );
+            case 0x0113:    return on_<0x0113>( a );
+            case 0x0201:    return on_<0x0201>( a );
+            case 0x8001:    return on_<0x8001>( a );
+        }
+        return {};
+    }
+
+    using Message_map = sm::Dispatch_map_<long( unsigned, int ),
+        sm::On_<0x0001u, &on_<0x0001>>, sm::On_<0x0002u, &on_<0x0002>>, sm::On_<0x0005u, &on_<0x0005>>,
+        sm::On_<0x000Fu, &on_<0x000F>>, sm::On_<0x0010u, &on_<0x0010>>, sm::On_<0x0014u, &on_<0x0014>>,
+        sm::On_<0x0111u, &on_<0x0111>>, sm::On_<0x0113u, &on_<0x0113>>, sm::On_<0x0201u, &on_<0x0201>>,
+        sm::On_<0x8001u, &on_<0x8001>>
+        >;
+
+    // A `switch` versus a `Dispatch_map_` on random message streams, with some or most ids ignored, and
+    // in bursts of 64 equal ids, e.g. mouse moves, where the branches are predictable.
+    void benchmark_message_dispatch( const bool quick )
+    {
+        const int n_messages = (quick? 1000 : 1'000'000);
+        printf( "Dispatching messages, ns per message:\n" );
+        printf( "    %-12s %12s %12s\n", "ignored", "switch", "map" );
+        for( const int percent_ignored: {0, 50, 90} ) for( const int burst_length: {1, 64} ) {
+            mt19937 bits( 42 );
+            vector<unsigned> ids( n_messages );
+            for( const int i: zero_to( n_messages ) ) {
+                if( i % burst_length != 0 ) { ids[i] = ids[i - 1]; continue; }
+                const bool is_ignored = int( bits() % 100 ) < percent_ignored;
+                ids[i] = (is_ignored? ignored_ids[bits() % sm::int_size_of( ignored_ids )] : handled_ids[bits() % sm::int_size_of( handled_ids )]);
+            }
+            long n_handled[2] = {};
+            const double switch_seconds = best_seconds( 3, [&]
+            {
+                for( const unsigned id: ids ) { n_handled[0] += switch_dispatch( id, 1 ).has_value(); }
+            } );
+            const double map_seconds = best_seconds( 3, [&]
+            {
+                for( const unsigned id: ids ) { n_handled[1] += Message_map::dispatch( id, 1 ).has_value(); }
+            } );
+            printf( "    %-12s %12.2f %12.2f%s\n",
+                (to_string( percent_ignored ) + "%" + (burst_length > 1? " bursts" : "")).c_str(),
+                switch_seconds/n_messages*1e9, map_seconds/n_messages*1e9,
+                (n_handled[0] == n_handled[1]? "" : "   (mismatch!)")
+                );
+        }
+    }
+
+    // Allocations are counted only in `n_allocations_in`, by the replaced `operator new` below. The
+    // benchmarks run one at a time, so no other thread allocates meanwhile.
+    bool    is_counting_allocations = false;
+    long    n_counted_allocations   = 0;
+
+    template< class Func >
+    auto n_allocations_in( const Func& f )
+        -> long
+    {
+        n_counted_allocations = 0;
+        is_counting_allocations = true;
+        f();
+        is_counting_allocations = false;
+        return n_counted_allocations;
+    }
+
+    // The former `String_builder`: a `std::string`, with numbers appended via `std::to_string`.
+    struct Old_string_builder: string
+    {
+        template< class T >
+        auto operator<<( in_<T> value )
+            -> Old_string_builder&
+        {
+            if constexpr( std::is_arithmetic_v<T> ) { append( to_string( value ) ); } else { append( value ); }
+            return *this;
+        }
+    };
+
+    // A short message, a report with 9 numbers, and a 300+ character string, which is too long for
+    // the inline buffer of `String_builder`.
+    template< class Builder >
+    void build_message( const int i_kind, Builder& builder, const int i )
+    {
+        if( i_kind == 0 ) {
+            builder << "Button press, id " << i << ".";
+        } else if( i_kind == 1 ) {
+            builder << "Done: " << i << " items in " << 0.25*i << " s, " << 3*i << " kB, frames "
+                << i + 1 << ".." << i + 99 << ", latency " << 1.5 << "/" << 2.75 << "/" << 16.5
+                << " ms, " << -i << " dropped.";
+        } else {
+            for( const int k: zero_to( 30 ) ) { builder << "part " << k + i << ", "; }
+        }
+    }
+
+    // The former and the current `String_builder`, the latter also with a `Char_arena`.
+    void benchmark_string_building( const bool quick )
+    {
+        const int n_builds = (quick? 100 : 200'000);
+        const C_string_ptr kind_names[] = {"short", "9 numbers", "long"};
+        char arena_buffer[4096];
+        sm::Char_arena arena( {arena_buffer, sizeof( arena_buffer )} );
+        volatile sm::Size sink = 0;
+
+        printf( "Building strings, ns and allocations per build:\n" );
+        printf( "    %-12s %18s %18s %18s\n", "message", "old", "new", "new, arena" );
+        for( const int i_kind: zero_to( 3 ) ) {
+            const auto build_old = [&]( const int i ) { Old_string_builder b; build_message( i_kind, b, i ); sink = b.size(); };
+            const auto build_new = [&]( const int i ) { sm::String_builder b; build_message( i_kind, b, i ); sink = b.size(); };
+            const auto build_in_arena = [&]( const int i )
+            {
+                { sm::String_builder b( arena ); build_message( i_kind, b, i ); sink = b.size(); }
+                arena.clear();
+            };
+
+            printf( "    %-12s", kind_names[i_kind] );
+            const auto report = [&]( const auto& build )
+            {
+                const double seconds = best_seconds( 3, [&]{ for( const int i: zero_to( n_builds ) ) { build( i ); } } );
+                const long n_allocations = n_allocations_in( [&]{ for( const int i: zero_to( 100 ) ) { build( i ); } } );
+                printf( " %10.0f ns %4.1f", seconds/n_builds*1e9, n_allocations/100.0 );
+            };
+            report( build_old );
+            report( build_new );
+            report( build_in_arena );
+            printf( "\n" );
+        }
+    }
+
+    // A chain of `depth` exceptions, via `SM_FAIL` or, if `foreign`, via `std::throw_with_nested`.
+    auto exception_chain( const int depth, const bool foreign )
+        -> exception_ptr
+    {
+        exception_ptr result;
+        for( const int level: sm::one_through( depth ) ) {
+            try {
+                if( not result ) {
+                    throw runtime_error( "level 1" );
+                }
+                try {
+                    rethrow_exception( result );
+                } catch( ... ) {
+                    if( foreign ) { throw_with_nested( runtime_error( "level " + to_string( level ) ) ); }
+                    SM_FAIL( "level " + to_string( level ) );
+                }
+            } catch( ... ) {
+                result = current_exception();
+            }
+        }
+        return result;
+    }
+
+    // The cost of walking an exception's cause chain, with `SM_FAIL` and with `std::throw_with_nested`.
+    void benchmark_exception_chains( const bool quick )
+    {
+        const int n_walks = (quick? 10 : 10'000);
+        printf( "Walking exception chains, ns per walk:\n" );
+        printf( "    %-8s %12s %12s\n", "depth", "SM_FAIL", "nested" );
+        for( const int depth: {1, 4, 16, 64} ) {
+            printf( "    %-8d", depth );
+            for( const bool foreign: {false, true} ) {
+                const exception_ptr px = exception_chain( depth, foreign );
+                try {
+                    rethrow_exception( px );
+                } catch( const std::exception& x ) {
+                    volatile int n_messages = 0;
+                    const double seconds = best_seconds( 3, [&]
+                    {
+                        for( const int i: zero_to( n_walks ) ) {
+                            (void) i; sm::with_messages_of( x, [&]( C_string_ptr ){ n_messages = n_messages + 1; } );
+                        }
+                    } );
+                    printf( " %12.0f", seconds/n_walks*1e9 );
+                }
+            }
+            printf( "\n" );
+        }
+    }
+
+    // The cost of deferring an exception, i.e. a push to an `Exception_queue` and the pop, compared
+    // to throwing and catching it.
+    void benchmark_exception_pushing( const bool quick )
+    {
+        const int n_pushes = (quick? 100 : 1'000'000);
+        sm::Exception_queue queue( 64 );
+        volatile long n_popped = 0;
+
+        double push_seconds = 0;
+        try {
+            throw runtime_error( "deferred" );
+        } catch( ... ) {
+            push_seconds = best_seconds( 3, [&]
+            {
+                for( const int i: zero_to( n_pushes ) ) {
+                    (void) i; (void) sm::push_current_exception_to( queue );
+                    n_popped = n_popped + queue.popped().has_value();
+                }
+            } );
+        }
+        const int n_throws = n_pushes/10;
+        const double throw_seconds = best_seconds( 3, [&]
+        {
+            for( const int i: zero_to( n_throws ) ) {
+                try { throw runtime_error( "deferred" ); } catch( ... ) { n_popped = n_popped + i%2; }
+            }
+        } );
+        printf( "Deferring an exception, ns:\n" );
+        printf( "    %-24s %12.0f\n", "push and pop", push_seconds/n_pushes*1e9 );
+        printf( "    %-24s %12.0f\n", "throw and catch", throw_seconds/n_throws*1e9 );
+    }
+
+    // Interning window title like strings, most of them already there, compared to looking them up in
+    // an `unordered_set<string>`, which makes a `string` of each, and to the first interning.
+    void benchmark_string_interning( const bool quick )
+    {
+        const int n_lookups = (quick? 1000 : 1'000'000);
+        vector<string> texts;
+        for( const int i: zero_to( 64 ) ) { texts.push_back( "Gladiator - work item " + to_string( 1000*i ) ); }
+        volatile sm::Size sink = 0;
+
+        sm::String_interner interner;
+        const double first_seconds = best_seconds( 1, [&]{ for( const string& s: texts ) { sink = interner.intern( s ).size(); } } );
+        const double hit_seconds = best_seconds( 3, [&]
+        {
+            for( const int i: zero_to( n_lookups ) ) { sink = interner.intern( texts[i % 64] ).size(); }
+        } );
+        const unordered_set<string> set( texts.begin(), texts.end() );
+        const double set_seconds = best_seconds( 3, [&]
+        {
+            for( const int i: zero_to( n_lookups ) ) {
+                const string_view text = texts[i % 64];
+                sink = set.find( string( text ) )->size();
+            }
+        } );
+        printf( "Interning 64 strings of ~28 characters, ns per string:\n" );
+        printf( "    %-24s %12.0f\n", "first time", first_seconds/64*1e9 );
+        printf( "    %-24s %12.0f\n", "already interned", hit_seconds/n_lookups*1e9 );
+        printf( "    %-24s %12.0f\n", "unordered_set<string>", set_seconds/n_lookups*1e9 );
+    }
+
+    // The first difference from the start, and from the end, of strings that differ only in the
+    // last, respectively the first, byte, i.e. with all bytes compared.
+    void benchmark_string_diff( const bool quick )
+    {
+        const double n_bytes_per_run = (quick? 1e6 : 500e6);
+        printf( "First difference in equal-but-one strings, ns per compare and GB/s:\n" );
+        printf( "    %-8s %-8s %25s %25s\n", "level", "size", "from start", "from end" );
+        for( const int level: zero_to( int( sm::simd_level() ) + 1 ) ) {
+            const sm::Mismatch_kernels& kernels = sm::mismatch_kernels_for( Simd_level::Enum( level ) );
+            for( const int n: {16, 1 << 10, 1 << 20} ) {
+                const string a( n, 'q' );
+                string b_last = a;
+                string b_first = a;
+                b_last.back() = 'r';
+                b_first.front() = 'r';
+                const int n_compares = max( 1, int( n_bytes_per_run/n ) );
+                volatile sm::Index sink = 0;
+                const double start_seconds = best_seconds( 3, [&]
+                {
+                    for( const int i: zero_to( n_compares ) ) { (void) i; sink = sm::i_first_difference( a, b_last, kernels ); }
+                } );
+                const double end_seconds = best_seconds( 3, [&]
+                {
+                    for( const int i: zero_to( n_compares ) ) { (void) i; sink = sm::i_first_difference_from_end( a, b_first, kernels ); }
+                } );
+                const string size_name = (n < 1024? to_string( n ) + " B" : n < (1 << 20)? to_string( n >> 10 ) + " KB" : to_string( n >> 20 ) + " MB");
+                printf( "    %-8s %-8s", level_names[level], size_name.c_str() );
+                for( const double seconds: {start_seconds, end_seconds} ) {
+                    printf( " %12.1f %11.2f", seconds/n_compares*1e9, double( n )*n_compares/seconds/1e9 );
+                }
+                printf( "\n" );
+            }
+        }
+    }
+
+    void benchmark_tiled_rendering( const bool quick )
+    {
+        const int w = 3840;  const int h = 2160;
+        vector<Bgra_pixel> pixels( w*h );
+        const Bgra_view view( pixels.data(), w, h );
+        const Fill fills[] =
+        {
+            Fill::solid_color( {1, 2, 3, 255} ),
+            Fill::gradient( Fill::vertical_gradient, {0, 0, 0, 255}, {255, 128, 0, 255}, Interval( 0, h - 1 ) ),
+            Fill::gradient( Fill::horizontal_gradient, {0, 0, 0, 255}, {255, 128, 0, 255}, Interval( 0, w - 1 ) ),
+        };
+        const C_string_ptr fill_names[] = {"solid", "vert. gradient", "horiz. gradient"};
+        const int n_runs = (quick? 1 : 15);
+        const int max_threads = max( 4, int( std::thread::hardware_concurrency() ) );
+
+        printf( "Filling 3840×2160 pixels, µs (%u hardware threads):\n", std::thread::hardware_concurrency() );
+        for( const int i_fill: zero_to( 3 ) ) {
+            printf( "    %-16s serial %6.0f", fill_names[i_fill], 1e6*best_seconds( n_runs, [&]
+            {
+                graphics::impl::render_fill_tile( view, view.bounds(), fills[i_fill] );
+            } ) );
+            for( int n_threads = 1; n_threads <= max_threads; n_threads *= 2 ) {
+                sm::Work_stealing_pool pool( n_threads );
+                printf( "  %d: %6.0f", n_threads, 1e6*best_seconds( n_runs, [&]
+                {
+                    render_fill( view, view.bounds(), fills[i_fill], pool );
+                } ) );
+            }
+            printf( "\n" );
+        }
+    }
+}  // namespace <anon>
+
+// Replaced global allocation functions, for counting allocations in `n_allocations_in`.
+auto operator new( const size_t n )
+    -> void*
+{
+    if( is_counting_allocations ) { ++n_counted_allocations; }
+    if( void* const p = malloc( n == 0? 1 : n ) ) { return p; }
+    throw bad_alloc();
+}
+
+auto operator new[]( const size_t n ) -> void* { return operator new( n ); }
+void operator delete( void* const p ) noexcept { free( p ); }
+void operator delete[]( void* const p ) noexcept { free( p ); }
+void operator delete( void* const p, size_t ) noexcept { free( p ); }
+void operator delete[]( void* const p, size_t ) noexcept { free( p ); }
+
+auto main( const int n_args, char** args ) -> int
+{
+    const bool quick = (n_args > 1 and strcmp( args[1], "--quick" ) == 0);
+    printf( "Best SIMD level: %s.\n", level_names[sm::simd_level()] );
+    benchmark_blitting( quick );
+    benchmark_mirroring( quick );
+    benchmark_dirty_repainting( quick );
+    benchmark_triple_buffer( quick );
+    benchmark_cancellation( quick );
+    benchmark_message_dispatch( quick );
+    benchmark_string_building( quick );
+    benchmark_exception_chains( quick );
+    benchmark_exception_pushing( quick );
+    benchmark_string_interning( quick );
+    benchmark_string_diff( quick );
+    benchmark_tiled_rendering( quick );
+}
@@ -0,0 +1,396 @@
+﻿// Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+// Tests of the portable pixel handling in `microlib/graphics`.
+
+#include "testing.hpp"
+
+#include <microlib/graphics.hpp>
+#include <microlib/support-machinery.hpp>
+
+#include <stdio.h>          // fopen, fread, fclose, remove
+#include <string.h>         // memcmp
+
+#include <random>
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sm = support_machinery;
+using   sm::Byte, sm::Byte_span, sm::Index, sm::in_, sm::hopefully, sm::Simd_level, sm::zero_to, sm::one_through;
+using   std::mt19937,                   // <random>
+        std::fill_n, std::sort, std::unique,    // <algorithm>
+        std::string,
+        std::string_view,               // <string_view>
+        std::vector;
+using namespace graphics;
+
+namespace {
+    auto sprites_bmp_bytes()
+        -> vector<Byte>
+    {
+        vector<Byte> result;
+        FILE* const f = fopen( TEST_SPRITES_BMP_PATH, "rb" );
+        hopefully( f != nullptr ) or SM_FAIL( "Failed to open “" TEST_SPRITES_BMP_PATH "”." );
+        Byte buffer[4096];
+        while( const size_t n = fread( buffer, 1, sizeof( buffer ), f ) ) {
+            result.insert( result.end(), buffer, buffer + n );
+        }
+        fclose( f );
+        return result;
+    }
+
+    auto span_of( const vector<Byte>& bytes ) -> Byte_span { return {bytes.data(), Index( bytes.size() )}; }
+
+    const std::initializer_list<string_view> animation_names = {"idle", "move", "attack", "hurt", "death"};
+
+    auto sprites_image()
+        -> Bgra_image
+    { return to_bgra_image( parse_bmp( span_of( sprites_bmp_bytes() ) ) ); }
+
+    auto random_pixel( mt19937& rng )
+        -> Bgra_pixel
+    {
+        const auto bits = uint32_t( rng() );
+        return {Byte( bits ), Byte( bits >> 8 ), Byte( bits >> 16 ), Byte( bits >> 24 )};
+    }
+
+    auto supported_simd_levels()
+        -> sm::Interval
+    { return zero_to( int( sm::simd_level() ) + 1 ); }
+
+    void test_bmp_parsing()
+    {
+        const vector<Byte> bytes = sprites_bmp_bytes();
+        const Bmp_view with_file_header = parse_bmp( span_of( bytes ) );
+        const Bmp_view without_file_header = parse_bmp( Byte_span( bytes.data() + 14, Index( bytes.size() ) - 14 ) );
+        TEST_CHECK( with_file_header.width() > 0 and with_file_header.height() > 0 );
+        TEST_CHECK( without_file_header.width() == with_file_header.width() );
+        TEST_CHECK( without_file_header.height() == with_file_header.height() );
+
+        const Bgra_image image = to_bgra_image( with_file_header );
+        TEST_CHECK( image.view()( 0, 0 ).a == 0xFF );
+
+        vector<Byte> truncated( bytes.begin(), bytes.begin() + Index( bytes.size() )/2 );
+        bool failed = false;
+        try { parse_bmp( span_of( truncated ) ); } catch( ... ) { failed = true; }
+        TEST_CHECK( failed );
+
+        // A hostile header where the pixel data size, row size × height, overflows 64 bits.
+        vector<Byte> huge = bytes;
+        const auto set_i32 = [&]( const Index i, const uint32_t v )
+        {
+            for( const int j: zero_to( 4 ) ) { huge[i + j] = Byte( v >> (8*j) ); }
+        };
+        set_i32( 14 + 4, 0x7FFF'FFFF );     // Width.
+        set_i32( 14 + 8, 0x7FFF'FFFF );     // Height.
+        failed = false;
+        try { parse_bmp( span_of( huge ) ); } catch( ... ) { failed = true; }
+        TEST_CHECK( failed );
+    }
+
+    void test_sprite_atlas()
+    {
+        const Bgra_image image = sprites_image();
+        const Bgra_pixel key = image.view()( 0, 0 );
+        const Sprite_atlas atlas = Sprite_atlas::from_grid( image.view(), {32, 32}, key, animation_names );
+        TEST_CHECK( atlas.n_animations() == 5 );
+        for( const auto name: animation_names ) { TEST_CHECK( atlas.animation( string( name ) ).n_frames > 0 ); }
+
+        const vector<Byte> bytes = atlas.to_bytes();
+        const Sprite_atlas copy = Sprite_atlas::from_bytes( span_of( bytes ), atlas.sheet_size() );
+        TEST_CHECK( copy.n_frames() == atlas.n_frames() );
+        TEST_CHECK( copy.to_bytes() == bytes );
+
+        bool failed = false;
+        try { Sprite_atlas::from_bytes( span_of( bytes ), {1, 1} ); } catch( ... ) { failed = true; }
+        TEST_CHECK( failed );
+
+        // An animation without frames is rejected, whether from data or from a sheet.
+        vector<Byte> without_frames = bytes;
+        fill_n( without_frames.end() - 4, 4, Byte( 0 ) );     // The last animation's number of frames.
+        failed = false;
+        try { Sprite_atlas::from_bytes( span_of( without_frames ), atlas.sheet_size() ); } catch( ... ) { failed = true; }
+        TEST_CHECK( failed );
+        Bgra_image blank( 64, 64 );
+        fill( blank.view(), key );
+        failed = false;
+        try { Sprite_atlas::from_grid( blank.view(), {32, 32}, key, {"idle"} ); } catch( ... ) { failed = true; }
+        TEST_CHECK( failed );
+
+        const Sprite_atlas separated = Sprite_atlas::from_separators( image.view(), key, animation_names, 3 );
+        TEST_CHECK( separated.n_animations() == 5 );
+        for( const auto name: animation_names ) { TEST_CHECK( separated.animation( string( name ) ).n_frames > 0 ); }
+    }
+
+    // Every SIMD level gives exactly the same result as the scalar code.
+    void test_blitting()
+    {
+        mt19937 rng( 42 );
+        const Bgra_pixel key = {255, 255, 255, 255};
+        int n_differences = 0;
+        for( const int i_test: zero_to( 300 ) ) {
+            (void) i_test;
+            Bgra_image source( 1 + int( rng() % 70 ), 1 + int( rng() % 9 ) );
+            for( const int y: zero_to( source.view().height() ) ) {
+                for( const int x: zero_to( source.view().width() ) ) {
+                    Bgra_pixel pixel = random_pixel( rng );
+                    if( pixel.b % 5 == 0 ) { pixel = key; }
+                    if( pixel.g % 7 == 0 ) { pixel.a = (pixel.r % 2 == 0? 0 : 255); }
+                    source.view()( x, y ) = pixel;
+                }
+            }
+            Bgra_image destination( 1 + int( rng() % 100 ), 1 + int( rng() % 40 ) );
+            for( const int y: zero_to( destination.view().height() ) ) {
+                for( const int x: zero_to( destination.view().width() ) ) { destination.view()( x, y ) = random_pixel( rng ); }
+            }
+            const Point position = {int( rng() % 120 ) - 30, int( rng() % 50 ) - 20};
+            const int scale = 1 + int( rng() % 4 );
+            for( const Blit_mode mode: {Blit_mode::opaque_copy(), Blit_mode::with_color_key( key ), Blit_mode::alpha_blending()} ) {
+                Bgra_image expected = destination;
+                blit( source.view(), expected.view(), position, mode, scale, blit_row_kernels_for( Simd_level::scalar ) );
+                for( const int level: supported_simd_levels() ) {
+                    Bgra_image result = destination;
+                    blit( source.view(), result.view(), position, mode, scale, blit_row_kernels_for( Simd_level::Enum( level ) ) );
+                    for( const int y: zero_to( result.view().height() ) ) {
+                        for( const int x: zero_to( result.view().width() ) ) {
+                            n_differences += (result.view()( x, y ) != expected.view()( x, y ));
+                        }
+                    }
+                }
+            }
+        }
+        TEST_CHECK( n_differences == 0 );
+
+        int n_rounding_errors = 0;
+        for( const int s: zero_to( 256 ) ) for( const int d: zero_to( 256 ) ) for( const int a: zero_to( 256 ).by_stride( 5 ) ) {
+            n_rounding_errors += (impl::scalar::blended( s, d, a ) != (2*(s*a + d*(255 - a)) + 255)/510);
+        }
+        TEST_CHECK( n_rounding_errors == 0 );
+    }
+
+    void test_mirroring()
+    {
+        mt19937 rng( 1 );
+        for( const int n: one_through( 67 ) ) {
+            vector<Bgra_pixel> source( n );
+            for( Bgra_pixel& pixel: source ) { pixel = random_pixel( rng ); }
+            for( const int level: supported_simd_levels() ) {
+                vector<Bgra_pixel> result( n );
+                mirror_row_kernel_for( Simd_level::Enum( level ) )( source.data(), result.data(), n );
+                bool ok = true;
+                for( const int i: zero_to( n ) ) { ok = ok and result[i] == source[n - 1 - i]; }
+                TEST_CHECK( ok );
+            }
+        }
+
+        const Bgra_image image = sprites_image();
+        const Sprite_atlas atlas = Sprite_atlas::from_grid( image.view(), {32, 32}, image.view()( 0, 0 ), animation_names );
+        Mirrored_frame_cache cache( image.view(), atlas, 4 );
+        int n_differences = 0;
+        for( const int i: zero_to( 30 ) ) {
+            const Const_bgra_view mirrored = cache.frame_pixels( i % 7 );
+            const Rect cell = atlas.frame( i % 7 ).cell;
+            for( const int y: zero_to( height_of( cell ) ) ) {
+                for( const int x: zero_to( width_of( cell ) ) ) {
+                    n_differences += (mirrored( x, y ) != image.view()( cell.right - 1 - x, cell.top + y ));
+                }
+            }
+        }
+        TEST_CHECK( n_differences == 0 );
+        TEST_CHECK( cache.n_cached() <= cache.capacity() );
+    }
+
+    void test_dirty_rects()
+    {
+        mt19937 rng( 7 );
+        for( const int i_test: zero_to( 2000 ) ) {
+            (void) i_test;
+            Dirty_rects dirty_rects( 4 );
+            vector<Rect> added;
+            for( const int i: zero_to( 1 + int( rng() % 8 ) ) ) {
+                (void) i;
+                const int x = int( rng() % 1200 );  const int y = int( rng() % 700 );
+                added.push_back( Rect{x, y, x + 1 + int( rng() % 64 ), y + 1 + int( rng() % 64 )} );
+                dirty_rects.add( added.back() );
+            }
+            TEST_CHECK( dirty_rects.n_rects() <= 4 );
+            const vector<Rect>& rects = dirty_rects.rects();
+            for( const int i: zero_to( dirty_rects.n_rects() ) ) {
+                for( const int j: zero_to( i ) ) { TEST_CHECK( not intersects( rects[i], rects[j] ) ); }
+            }
+            for( const Rect& r: added ) { TEST_CHECK( dirty_rects.covers( r ) ); }
+        }
+    }
+
+    void test_back_buffer()
+    {
+        Back_buffer buffer;
+        for( int w = 300, h = 200; w <= 1900; w += 5, h = std::min( 1000, h + 3 ) ) { buffer.resize( {w, h} ); }
+        TEST_CHECK( buffer.n_allocations() < 20 );
+        buffer.resize( {640, 480} );
+        TEST_CHECK( buffer.view().width() == 640 and buffer.view().height() == 480 );
+        TEST_CHECK( buffer.capacity().w >= 640 and buffer.capacity().h >= 480 );
+    }
+
+    // A mock backend that fails at the third control.
+    struct Mock_controls
+    {
+        using Handle = int;
+
+        vector<int>     live;
+        int             n_batches_open  = 0;
+
+        void begin_batch() { ++n_batches_open; }
+        void end_batch( in_<Rect> ) { --n_batches_open; }
+        void destroy( const int id ) { live.erase( std::find( live.begin(), live.end(), id ) ); }
+
+        auto create( in_<Control_spec> spec, in_<Rect> )
+            -> int
+        {
+            hopefully( live.size() < 2 ) or SM_FAIL( "Mock failure." );
+            live.push_back( spec.id );
+            return spec.id;
+        }
+    };
+
+    void test_form_layout()
+    {
+        const vector<Control_spec> specs =
+        {
+            Control_spec{ "button", "A", 1, 0, {100, 20} },
+            Control_spec{ "button", "B", 2, 0, {100, 20} },
+            Control_spec{ "button", "C", 3, 0, {100, 20} },
+        };
+        const Flow_layout layout = {{10, 10, 230, 0}, {10, 10}};
+        const vector<Rect> placements = placements_of( specs, layout );
+        TEST_CHECK( (placements[0] == Rect{10, 10, 110, 30}) );
+        TEST_CHECK( (placements[1] == Rect{120, 10, 220, 30}) );
+        TEST_CHECK( (placements[2] == Rect{10, 40, 110, 60}) );      // Doesn't fit in the first row.
+
+        Mock_controls backend;
+        bool failed = false;
+        try { create_controls( backend, specs, layout ); } catch( ... ) { failed = true; }
+        TEST_CHECK( failed );
+        TEST_CHECK( backend.live.empty() );
+        TEST_CHECK( backend.n_batches_open == 0 );
+    }
+
+    int n_live_fonts = 0;
+
+    struct Stub_font:
+        sm::Non_copyable
+    {
+        Font_key key;
+        Stub_font( in_<Font_key> a_key ): key( a_key ) { ++n_live_fonts; }
+        ~Stub_font() { --n_live_fonts; }
+    };
+
+    void test_font_cache()
+    {
+        const Font_key key = Font_key::of( "Segoe UI", -12, 400, false, 96 );
+        TEST_CHECK( key == Font_key::of( "Segoe UI", -12, 400, false, 96 ) and key.face_name() == "Segoe UI" );
+        TEST_CHECK( Font_key::of( string( 40, 'x' ), -12, 400, false, 96 ).face_name().size() == Font_key::max_face_length );
+        TEST_CHECK( scaled_for_dpi( -12, 144 ) == -18 and scaled_for_dpi( 11, 120 ) == 14 );
+
+        vector<size_t> hashes;
+        for( const int dpi: {96, 120, 144, 192} ) for( const int weight: {400, 700} ) for( const bool is_italic: {false, true} ) {
+            const Font_key k = Font_key::of( "Segoe UI", scaled_for_dpi( -12, dpi ), weight, is_italic, dpi );
+            TEST_CHECK( (k == key) == (dpi == 96 and weight == 400 and not is_italic) );
+            hashes.push_back( Font_key::Hash()( k ) );
+        }
+        sort( hashes.begin(), hashes.end() );
+        TEST_CHECK( unique( hashes.begin(), hashes.end() ) == hashes.end() );
+
+        // Fonts that have been handed out are destroyed only after an invalidation.
+        n_live_fonts = 0;
+        {
+            Font_cache_<Stub_font> cache( 2 );
+            int n_made = 0;
+            const auto font_for = [&]( const int dpi ) -> const Stub_font&
+            {
+                const Font_key k = Font_key::of( "Segoe UI", scaled_for_dpi( -12, dpi ), 400, false, dpi );
+                return cache.font( k, [&]{ ++n_made; return k; } );
+            };
+            const Stub_font* const p_font = &font_for( 96 );
+            TEST_CHECK( &font_for( 96 ) == p_font and n_made == 1 );
+            for( const int dpi: {120, 144, 192, 240} ) { font_for( dpi ); }     // Evicts 3 fonts.
+            TEST_CHECK( cache.size() == 2 and cache.n_retired() == 3 and n_live_fonts == 5 );
+            TEST_CHECK( p_font->key == Font_key::of( "Segoe UI", -12, 400, false, 96 ) );
+            {
+                const Font_cache_<Stub_font>::Removed_fonts removed = cache.invalidate();
+                TEST_CHECK( removed.size() == 5 and cache.size() == 0 and cache.n_retired() == 0 );
+                TEST_CHECK( n_live_fonts == 5 );
+            }
+            TEST_CHECK( n_live_fonts == 0 );
+            font_for( 96 );
+            TEST_CHECK( n_made == 6 and n_live_fonts == 1 );
+        }
+        TEST_CHECK( n_live_fonts == 0 );
+    }
+
+    void test_tiling()
+    {
+        static_assert( tiles_of( {0, 0, 100, 50}, {64, 32} ).size() == 4 );
+        static_assert( tiles_of( {0, 0, 100, 50}, {64, 32} )[3] == Rect{64, 32, 100, 50} );
+
+        const Rect area = {5, 7, 5 + 333, 7 + 201};
+        int n_covered = 0;
+        for( const Rect tile: tiles_of( area, {64, 32} ) ) {
+            TEST_CHECK( intersection_of( tile, area ) == tile );
+            n_covered += area_of( tile );
+        }
+        TEST_CHECK( n_covered == area_of( area ) );
+    }
+
+    // Rendering as tiles in parallel gives the same pixels as rendering the area in one go.
+    void test_tiled_rendering()
+    {
+        vector<Bgra_pixel> pattern_pixels( 13*7 );
+        for( const int i: zero_to( int( pattern_pixels.size() ) ) ) { pattern_pixels[i] = {Byte( i ), Byte( 3*i ), Byte( 7*i ), 255}; }
+        const Const_bgra_view pattern( pattern_pixels.data(), 13, 7 );
+        const Fill fills[] =
+        {
+            Fill::solid_color( {1, 2, 3, 255} ),
+            Fill::pattern_of( pattern, {-5, 3} ),
+            Fill::gradient( Fill::vertical_gradient, {0, 0, 0, 255}, {255, 128, 0, 255}, sm::Interval( 10, 300 ) ),
+            Fill::gradient( Fill::horizontal_gradient, {0, 0, 0, 255}, {255, 128, 0, 255}, sm::Interval( 0, 499 ) ),
+        };
+        const int w = 517;  const int h = 333;
+        const Rect area = {20, 30, 500, 320};
+        sm::Work_stealing_pool pool( 3 );
+        for( const Fill& fill: fills ) {
+            vector<Bgra_pixel> expected( w*h );
+            impl::render_fill_tile( Bgra_view( expected.data(), w, h ), area, fill );
+            for( const Size tile_size: {Size{48, 40}, Size{480, 4}, Size{0, 0}} ) {
+                vector<Bgra_pixel> result( w*h );
+                render_fill( Bgra_view( result.data(), w, h ), area, fill, pool, tile_size );
+                TEST_CHECK( memcmp( result.data(), expected.data(), result.size()*sizeof( Bgra_pixel ) ) == 0 );
+            }
+            vector<Bgra_pixel> result( w*h );
+            render_fill( Bgra_view( result.data(), w, h ), area, fill );       // Without a pool.
+            TEST_CHECK( memcmp( result.data(), expected.data(), result.size()*sizeof( Bgra_pixel ) ) == 0 );
+        }
+
+        const Bgra_view view( nullptr, w, h );
+        TEST_CHECK( is_rendered_in_parallel( view, area, Size{48, 40} ) );
+        TEST_CHECK( not is_rendered_in_parallel( view, area ) );                // 3 default tiles.
+        TEST_CHECK( not is_rendered_in_parallel( view, Rect{600, 0, 700, 100}, Size{8, 8} ) );   // Outside.
+    }
+}  // namespace <anon>
+
+auto main() -> int
+{
+    return testing::run_tests( {
+        {"bmp parsing",         test_bmp_parsing},
+        {"sprite atlas",        test_sprite_atlas},
+        {"blitting",            test_blitting},
+        {"mirroring",           test_mirroring},
+        {"dirty rects",         test_dirty_rects},
+        {"back buffer",         test_back_buffer},
+        {"form layout",         test_form_layout},
+        {"font cache",          test_font_cache},
+        {"tiling",              test_tiling},
+        {"tiled rendering",     test_tiled_rendering},
+        } );
+}
@@ -0,0 +1,99 @@
+﻿// Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+// Tests of `linuxapi::Event_loop`, which shares the timer scheduling with `winapi::Event_loop`.
+
+#include "testing.hpp"
+
+#include <microlib/linuxapi++/Event_loop.hpp>
+
+#include <sys/eventfd.h>
+#include <unistd.h>         // write
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace sm = support_machinery;
+using   linuxapi::Event_loop;
+using   std::thread,                    // <thread>
+        std::vector;
+namespace chrono = std::chrono;
+namespace this_thread = std::this_thread;
+
+namespace {
+    void test_timers_and_posting()
+    {
+        Event_loop loop;
+        sm::Timer_queue& timers = loop.timers();
+        vector<int> order;
+        timers.add_after( chrono::milliseconds( 30 ), [&]{ order.push_back( 3 ); } );
+        timers.add_after( chrono::milliseconds( 10 ), [&]{ order.push_back( 1 ); } );
+        const auto cancelled = timers.add_after( chrono::milliseconds( 20 ), [&]{ order.push_back( 99 ); } );
+        timers.cancel( cancelled );
+        int n_periodic_calls = 0;
+        sm::Timer_queue::Id periodic = 0;
+        periodic = timers.add_periodic( chrono::milliseconds( 5 ), [&]{ if( ++n_periodic_calls == 4 ) { timers.cancel( periodic ); } } );
+
+        thread poster( [&]
+        {
+            this_thread::sleep_for( chrono::milliseconds( 60 ) );
+            loop.post( [&]{ order.push_back( 7 ); } );
+            loop.post_quit();
+        } );
+        loop.run();
+        poster.join();
+
+        TEST_CHECK( (order == vector<int>{1, 3, 7}) );
+        TEST_CHECK( n_periodic_calls == 4 );
+        TEST_CHECK( timers.n_timers() == 0 );
+        TEST_CHECK( loop.stats().n_timer_callbacks == 2 + 4 );
+    }
+
+    // A posted function that throws doesn't take the functions posted after it with it.
+    void test_posting_after_exception()
+    {
+        Event_loop loop;
+        vector<int> order;
+        loop.post( [&]{ order.push_back( 1 ); } );
+        loop.post( []{ throw std::runtime_error( "Boom." ); } );
+        loop.post( [&]{ order.push_back( 2 ); } );
+        loop.post_quit();
+
+        bool caught = false;
+        try { loop.run(); } catch( const std::runtime_error& ) { caught = true; }
+        TEST_CHECK( caught );
+        TEST_CHECK( (order == vector<int>{1}) );
+        loop.run();         // Returns only via the posted quit.
+        TEST_CHECK( (order == vector<int>{1, 2}) );
+    }
+
+    void test_waitables()
+    {
+        Event_loop loop;
+        const int fd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+        int n_signals = 0;
+        loop.add_waitable( fd, [&]
+        {
+            uint64_t count;
+            (void) ::read( fd, &count, sizeof( count ) );
+            ++n_signals;
+            loop.remove_waitable( fd );
+            loop.post_quit();
+        } );
+        const uint64_t one = 1;
+        (void) ::write( fd, &one, sizeof( one ) );
+        loop.run();
+        ::close( fd );
+        TEST_CHECK( n_signals == 1 );
+        TEST_CHECK( loop.stats().n_signals == 1 );
+    }
+}  // namespace <anon>
+
+auto main() -> int
+{
+    return testing::run_tests( {
+        {"timers and posting",      test_timers_and_posting},
+        {"posting after exception", test_posting_after_exception},
+        {"waitables",               test_waitables},
+        } );
+}
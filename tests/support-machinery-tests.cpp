@@ -0,0 +1,658 @@
+﻿// Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+// Tests of the portable `microlib/support-machinery`.
+
+#include "testing.hpp"
+
+#include <microlib/support-machinery.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sm = support_machinery;
+using   sm::C_string_ptr, sm::zero_to, sm::one_through, sm::Interval, sm::Simd_level;
+using   std::reverse,                   // <algorithm>
+        std::atomic,                    // <atomic>
+        std::throw_with_nested,         // <exception>
+        std::make_shared, std::weak_ptr,    // <memory>
+        std::mt19937,                   // <random>
+        std::runtime_error,             // <stdexcept>
+        std::string, std::to_string,    // <string>
+        std::string_view,               // <string_view>
+        std::thread,                    // <thread>
+        std::move,                      // <utility>
+        std::vector;
+namespace chrono = std::chrono;
+namespace this_thread = std::this_thread;
+
+namespace {
+    void test_interval_views()
+    {
+        static_assert( zero_to( 10 ).by_stride( 3 ).size() == 4 and zero_to( 10 ).by_stride( 3 )[3] == 9 );
+        static_assert( zero_to( 10 ).chunked( 4 ).size() == 3 and zero_to( 10 ).chunked( 4 )[2].first == 8 );
+        static_assert( zero_to( 0 ).chunked( 4 ).size() == 0 and zero_to( -3 ).size() == 0 );
+        static_assert( zero_to( size_t( 0 ) ).chunked( 4 ).size() == 0 and zero_to( size_t( 10 ) ).chunked( 4 ).size() == 3 );
+        static_assert( zero_to( 3u ).reversed()[0] == 2u and zero_to( 3u ).reversed()[2] == 0u );
+
+        for( const int n: zero_to( 70 ) ) for( const int stride: one_through( 8 ) ) {
+            vector<int> expected, strided, chunked;
+            for( int i = 0; i < n; i += stride ) { expected.push_back( i ); }
+            for( const int i: zero_to( n ).by_stride( stride ) ) { strided.push_back( i ); }
+            TEST_CHECK( strided == expected );
+
+            reverse( expected.begin(), expected.end() );
+            strided.clear();
+            for( const int i: zero_to( n ).by_stride( stride ).reversed() ) { strided.push_back( i ); }
+            TEST_CHECK( strided == expected );
+
+            strided.clear();       // With an unsigned integer type, and a negative stride.
+            for( const size_t i: zero_to( size_t( n ) ).by_stride( size_t( stride ) ).reversed() ) { strided.push_back( int( i ) ); }
+            TEST_CHECK( strided == expected );
+            if( stride == 1 ) {
+                strided.clear();
+                for( const size_t i: zero_to( size_t( n ) ).reversed() ) { strided.push_back( int( i ) ); }
+                TEST_CHECK( strided == expected );
+            }
+
+            for( const Interval chunk: zero_to( n ).chunked( stride ) ) {
+                TEST_CHECK( chunk.size() <= stride );
+                for( const int i: chunk ) { chunked.push_back( i ); }
+            }
+            TEST_CHECK( int( chunked.size() ) == n and (n == 0 or chunked.back() == n - 1) );
+
+            vector<int> chunked_unsigned;
+            for( const sm::Interval_<size_t> chunk: zero_to( size_t( n ) ).chunked( size_t( stride ) ) ) {
+                for( const size_t i: chunk ) { chunked_unsigned.push_back( int( i ) ); }
+            }
+            TEST_CHECK( chunked_unsigned == chunked );
+        }
+    }
+
+    auto first_difference_by_loop( const string_view a, const string_view b )
+        -> sm::Index
+    {
+        const auto n = sm::Index( std::min( a.size(), b.size() ) );
+        for( const sm::Index i: zero_to( n ) ) { if( a[i] != b[i] ) { return i; } }
+        return (a.size() == b.size()? -1 : n);
+    }
+
+    void test_string_diff()
+    {
+        mt19937 rng( 42 );
+        for( const int i_test: zero_to( 20'000 ) ) {
+            (void) i_test;
+            string a( rng() % 100, 'a' );
+            for( char& ch: a ) { ch = "ab\x80\xFF"[rng() % 4]; }
+            string b = a.substr( 0, rng() % (a.size() + 1) );
+            if( not b.empty() and rng() % 2 ) { b[rng() % b.size()] ^= char( 1 << (rng() % 8) ); }
+            if( rng() % 2 ) { b.resize( a.size(), 'a' ); }
+
+            string a_reversed( a.rbegin(), a.rend() );
+            string b_reversed( b.rbegin(), b.rend() );
+            const sm::Index expected = first_difference_by_loop( a, b );
+            const sm::Index expected_from_end = first_difference_by_loop( a_reversed, b_reversed );
+            for( const int level: zero_to( int( sm::simd_level() ) + 1 ) ) {
+                const sm::Mismatch_kernels& kernels = sm::mismatch_kernels_for( Simd_level::Enum( level ) );
+                TEST_CHECK( sm::i_first_difference( a, b, kernels ) == expected );
+                TEST_CHECK( sm::i_first_difference_from_end( a, b, kernels ) == expected_from_end );
+            }
+        }
+    }
+
+    int n_destroyed_ints = 0;
+    void destroy_int( int ) { ++n_destroyed_ints; }
+
+    void test_unique_handle()
+    {
+        using Handle = sm::Unique_handle_<int, destroy_int>;
+        static_assert( sizeof( Handle ) == sizeof( int ) );
+
+        n_destroyed_ints = 0;
+        {
+            Handle a( 3 );
+            Handle b( move( a ) );
+            Handle c;
+            c = move( b );
+            c = 5;
+            (void) c.release();
+            Handle d( 7 );
+            d.reset();
+        }
+        TEST_CHECK( n_destroyed_ints == 2 );
+
+        // Like a file descriptor: 0 is a valid handle, and -1 is the empty state.
+        using Fd_handle = sm::Unique_handle_with_<int, sm::Destroy_function_with_null_<int, destroy_int, -1>>;
+        n_destroyed_ints = 0;
+        {
+            Fd_handle a;
+            TEST_CHECK( a.is_empty() and a.value() == -1 );
+            Fd_handle b( 0 );
+            TEST_CHECK( not b.is_empty() );
+            a = move( b );
+            TEST_CHECK( b.is_empty() and b.value() == -1 );
+        }
+        TEST_CHECK( n_destroyed_ints == 1 );
+
+        n_destroyed_ints = 0;
+        {
+            sm::Handle_pool_<int, sm::Destroy_function_<int, destroy_int>> pool( 1 );
+            int n_made = 0;
+            {
+                const auto h1 = pool.acquire( [&]{ return ++n_made; } );
+                const auto h2 = pool.acquire( [&]{ return ++n_made; } );
+            }
+            TEST_CHECK( n_made == 2 and pool.n_idle() == 1 and n_destroyed_ints == 1 );
+            const auto h3 = pool.acquire( [&]{ return ++n_made; } );
+            TEST_CHECK( n_made == 2 );
+        }
+        TEST_CHECK( n_destroyed_ints == 2 );
+    }
+
+    int n_live_values = 0;
+
+    struct Counted:
+        sm::Non_copyable
+    {
+        int value;
+        Counted( const int v ): value( v ) { ++n_live_values; }
+        ~Counted() { --n_live_values; }
+    };
+
+    void test_lru_caches()
+    {
+        {
+            sm::Lru_cache_<int, Counted> cache( 3 );
+            for( const int key: {1, 2, 3, 1, 4, 2, 5, 1, 1} ) {
+                TEST_CHECK( cache.get_or_make( key, [&]{ return 10*key; } ).value == 10*key );
+            }
+            const sm::Cache_stats stats = cache.stats();
+            TEST_CHECK( stats.n_hits == 2 and stats.n_misses == 7 and stats.n_evictions == 4 );
+            TEST_CHECK( cache.size() == 3 and n_live_values == 3 );
+        }
+        TEST_CHECK( n_live_values == 0 );
+
+        {
+            sm::Shared_lru_cache_<int, Counted> cache( 3 );
+            const auto get = [&]( const int key ) { return cache.get_or_make( key, [&]{ return 10*key; } ); };
+            const auto p1 = get( 1 );  get( 2 );  get( 3 );  get( 1 );
+            get( 4 );                                   // Evicts 2, the least recently used.
+            TEST_CHECK( get( 1 ) == p1 );
+            const auto held = get( 2 );
+            {
+                const auto removed = cache.invalidate();
+                TEST_CHECK( removed.size() == 3 and cache.n_retired() == 2 );  // 2 and 3 were evicted.
+            }
+            cache.release_retired();
+            TEST_CHECK( cache.size() == 0 and n_live_values == 2 );        // `p1` and `held`.
+        }
+        TEST_CHECK( n_live_values == 0 );
+
+        {
+            sm::Shared_lru_cache_<int, Counted> cache( 3 );
+            for( const int key: zero_to( 100 ) ) {
+                (void) cache.get_or_make( key, [&]{ return key; } );
+            }
+            TEST_CHECK( cache.n_retired() == 3 and n_live_values == 3 + 3 );   // Bounded by the capacity.
+        }
+        TEST_CHECK( n_live_values == 0 );
+    }
+
+    void test_triple_buffer()
+    {
+        struct Progress{ int64_t n; int64_t n_doubled; };
+        sm::Triple_buffer_<Progress> buffer;
+        const int64_t n_updates = 200'000;
+        atomic<bool> done = false;
+        int64_t n_bad = 0;
+        int64_t last = -1;
+        thread consumer( [&]
+        {
+            while( not done.load() or buffer.update() ) {
+                if( buffer.update() ) {
+                    const Progress& p = buffer.front();
+                    n_bad += (p.n_doubled != 2*p.n or p.n < last);
+                    last = p.n;
+                }
+            }
+        } );
+        for( const int64_t i: zero_to( n_updates ) ) {
+            Progress& p = buffer.back();
+            p.n = i;  p.n_doubled = 2*i;
+            buffer.publish();
+        }
+        done = true;
+        consumer.join();
+        buffer.update();
+        TEST_CHECK( n_bad == 0 );
+        TEST_CHECK( buffer.front().n == n_updates - 1 );
+    }
+
+    void test_cancellation()
+    {
+        sm::Cancellation_source source;
+        const sm::Cancellation_token token = source.token();
+        int n_calls = 0;
+        {
+            const auto registration = token.on_cancellation( [&]{ ++n_calls; } );
+        }
+        const auto registration = token.on_cancellation( [&]{ n_calls += 10; } );
+        TEST_CHECK( not token.is_cancelled() );
+        TEST_CHECK( token.with_timeout( chrono::hours( 0 ) ).is_cancelled() );
+
+        source.cancel();
+        source.cancel();
+        TEST_CHECK( token.is_cancelled() and n_calls == 10 );
+        const auto late_registration = token.on_cancellation( [&]{ n_calls += 100; } );
+        TEST_CHECK( n_calls == 110 );
+        TEST_CHECK( not sm::Cancellation_token().is_cancelled() );
+
+        // Destroying a registration waits for its callback if that's running on another thread.
+        sm::Cancellation_source other_source;
+        atomic<bool> is_started = false;
+        atomic<bool> is_finished = false;
+        std::unique_ptr<sm::Cancellation_callback_registration> p_registration(
+            new sm::Cancellation_callback_registration( other_source.token().on_cancellation( [&]
+            {
+                is_started = true;
+                this_thread::sleep_for( chrono::milliseconds( 50 ) );
+                is_finished = true;
+            } ) ) );
+        thread canceller( [&]{ other_source.cancel(); } );
+        while( not is_started ) { this_thread::yield(); }
+        p_registration.reset();
+        TEST_CHECK( is_finished );
+        canceller.join();
+    }
+
+    void test_wait_operation()
+    {
+        {
+            sm::Wait_operation operation( []{ throw runtime_error( "Boom." ); } );
+            bool caught = false;
+            try { operation.finish(); } catch( const runtime_error& ) { caught = true; }
+            TEST_CHECK( caught );
+        }
+        {
+            sm::Cancellation_source source;
+            const sm::Cancellation_token token = source.token();
+            sm::Wait_operation operation( [&]{ while( not token.is_cancelled() ) { this_thread::yield(); } } );
+            TEST_CHECK( not operation.wait_for( chrono::milliseconds( 20 ) ) );
+            source.cancel();
+            TEST_CHECK( operation.wait_for( chrono::seconds( 10 ) ) );
+            TEST_CHECK( operation.is_completed() );
+        }
+    }
+
+    // A callback that dispatches again, as a modal loop does, and then cancels its own timer.
+    void test_timer_queue()
+    {
+        using Timers = sm::Timer_queue;
+        Timers timers;
+        const Timers::Time_point start = Timers::Clock::now();
+        vector<int> calls;
+        auto p_marker = make_shared<int>( 0 );
+        const weak_ptr<int> marker = p_marker;
+        Timers::Id outer = 0;
+        outer = timers.add( start, [&, p_marker = move( p_marker )]
+        {
+            calls.push_back( 1 );
+            timers.add( start, [&]{ calls.push_back( 2 ); } );
+            TEST_CHECK( timers.dispatch_due( start + chrono::seconds( 1 ) ) == 1 );
+            timers.cancel( outer );
+            TEST_CHECK( not marker.expired() );         // The running callback still exists.
+            calls.push_back( 3 );
+        }, chrono::hours( 1 ) );
+        TEST_CHECK( timers.dispatch_due( start ) == 1 );
+        TEST_CHECK( (calls == vector<int>{1, 2, 3}) );
+        TEST_CHECK( marker.expired() and timers.n_timers() == 0 and not timers.next_deadline() );
+    }
+
+    void test_frame_pacer()
+    {
+        using sm::Frame_pacer;
+        const auto start = Frame_pacer::Clock::now();
+        Frame_pacer pacer( 60, start );
+        mt19937 rng( 42 );
+        int64_t last_frame_number = 0;
+        for( const int i: zero_to( 10'000 ) ) {
+            auto now = pacer.next_deadline() + chrono::microseconds( rng() % 800 );
+            if( i % 1000 == 999 ) { now += chrono::milliseconds( 100 ); }     // A stall.
+            const auto tick = pacer.tick( now );
+            TEST_CHECK( tick.has_value() );
+            if( not tick ) { return; }
+            TEST_CHECK( tick->frame_number == last_frame_number + 1 + tick->n_dropped );
+            TEST_CHECK( chrono::nanoseconds( 0 ) <= tick->lateness and tick->lateness <= chrono::nanoseconds( 1'000'000'000/60 ) );
+            TEST_CHECK( pacer.deadline_of( tick->frame_number ) == start + chrono::nanoseconds( tick->frame_number*1'000'000'000/60 ) );
+            last_frame_number = tick->frame_number;
+        }
+        TEST_CHECK( not pacer.tick( pacer.next_deadline() - chrono::nanoseconds( 1 ) ) );
+        TEST_CHECK( pacer.n_dropped() > 0 );
+    }
+
+    void test_latency_histogram()
+    {
+        using H = sm::Latency_histogram;
+        for( const int i: zero_to( H::n_buckets - 1 ) ) {
+            TEST_CHECK( H::lowest_value_in( i + 1 ) == H::highest_value_in( i ) + 1 );
+        }
+        mt19937 rng( 1 );
+        for( const int i_test: zero_to( 100'000 ) ) {
+            (void) i_test;
+            const int64_t v = int64_t( (uint64_t( rng() ) << 32 | rng()) >> (rng() % 64) ) & H::max_trackable;
+            const int i = H::bucket_index_of( v );
+            TEST_CHECK( H::lowest_value_in( i ) <= v and v <= H::highest_value_in( i ) );
+        }
+        TEST_CHECK( H::bucket_index_of( H::max_trackable ) == H::n_buckets - 1 and H::bucket_index_of( -5 ) == 0 );
+
+        H histogram;
+        for( const int v: one_through( 1000 ) ) { histogram.record( 1000*v ); }
+        TEST_CHECK( histogram.max_value() >= 1'000'000 );
+        TEST_CHECK( std::abs( histogram.value_at( 0.5 ) - 500'000 ) <= 500'000/16 );
+
+        sm::Latency_table table( 8 );
+        for( const uint32_t id: zero_to( 20u ) ) for( const uint32_t k: zero_to( id + 1 ) ) { (void) k; table.record( id, 1000 ); }
+        int n_ids = 0;
+        table.for_each( [&]( uint32_t, const H& ) { ++n_ids; } );
+        TEST_CHECK( n_ids == 9 );
+    }
+
+    long handled_sum = 0;
+    template< unsigned k > auto on_( const int a, const long b ) -> long { handled_sum += a*k + b; return long( k ); }
+    auto not_handled( int, long ) -> std::optional<long> { return {}; }
+
+    void test_dispatch_map()
+    {
+        using sm::On_;
+        using Map = sm::Dispatch_map_<long( unsigned, int, long ),
+            On_<1u, &on_<1>>, On_<2u, &on_<2>>, On_<0x0Fu, &on_<0x0F>>, On_<0x111u, &on_<0x111>>,
+            On_<0x8001u, &on_<0x8001>>, On_<0x2E0u, &not_handled>
+            >;
+        static_assert( Map::size() == 6 );
+        for( const unsigned id: {1u, 2u, 0x0Fu, 0x111u, 0x8001u} ) {
+            TEST_CHECK( Map::dispatch( id, 1, 2 ) == long( id ) );
+        }
+        for( const unsigned id: {0u, 3u, 0x10u, 0x2E0u, 0x8000u, 0xFFFFu} ) {
+            TEST_CHECK( not Map::dispatch( id, 1, 2 ).has_value() );
+        }
+        TEST_CHECK( not sm::Dispatch_map_<long( unsigned, int, long )>::dispatch( 3, 1, 2 ) );
+    }
+
+    void test_string_building()
+    {
+        using sm::String_builder;
+        const String_builder s = String_builder() << "a" << 42 << " " << -7L << " " << 3.25 << " " << true;
+        TEST_CHECK( s.view() == "a42 -7 3.25 1" );
+
+        String_builder long_string;
+        for( const int i: zero_to( 200 ) ) { (void) i; long_string << "0123456789"; }
+        TEST_CHECK( long_string.size() == 2000 and long_string.view().substr( 1990 ) == "0123456789" );
+        const String_builder moved = move( long_string );
+        TEST_CHECK( moved.size() == 2000 );
+
+        char buffer[4096];
+        sm::Char_arena arena( {buffer, sizeof( buffer )} );
+        String_builder in_arena( arena );
+        for( const int i: zero_to( 100 ) ) { in_arena << "0123456789" << i; }
+        TEST_CHECK( in_arena.size() == 1000 + 10 + 2*90 );
+    }
+
+    [[noreturn]] void throw_chain( const int depth )
+    {
+        if( depth == 1 ) { SM_FAIL( "level 1" ); }
+        try {
+            throw_chain( depth - 1 );
+        } catch( ... ) {
+            SM_FAIL( "level " + to_string( depth ) );
+        }
+    }
+
+    // A foreign chain, as made by code that uses `std::throw_with_nested`, optionally ending in an `int`.
+    [[noreturn]] void throw_foreign_chain( const int depth, const bool ends_with_int = false )
+    {
+        if( depth == 1 ) {
+            if( ends_with_int ) { throw 42; }
+            throw runtime_error( "foreign 1" );
+        }
+        try {
+            throw_foreign_chain( depth - 1, ends_with_int );
+        } catch( ... ) {
+            throw_with_nested( runtime_error( "foreign " + to_string( depth ) ) );
+        }
+    }
+
+    void test_exception_handling()
+    {
+        try {
+            throw_chain( 5 );
+        } catch( const std::exception& x ) {
+            const vector<string> messages = sm::messages_of( x );
+            TEST_CHECK( messages.size() == 5 );
+            TEST_CHECK( messages.front().find( "level 5" ) != string::npos );
+            TEST_CHECK( messages.back().find( "level 1" ) != string::npos );
+        }
+
+        // A foreign chain is walked by rethrowing.
+        try {
+            throw_foreign_chain( 3 );
+        } catch( const std::exception& x ) {
+            TEST_CHECK( sm::messages_of( x ) == vector<string>( {"foreign 3", "foreign 2", "foreign 1"} ) );
+        }
+        try {
+            throw_foreign_chain( 3, true );
+        } catch( const std::exception& x ) {
+            vector<string> messages;
+            const bool all_standard = sm::with_messages_of( x, [&]( C_string_ptr s ){ messages.emplace_back( s ); } );
+            TEST_CHECK( not all_standard and messages == vector<string>( {"foreign 3", "foreign 2"} ) );
+        }
+
+        // A foreign chain as the cause of a `With_cause_` is converted, and is still a nested exception.
+        try {
+            try { throw_foreign_chain( 2 ); } catch( ... ) { SM_FAIL( "outer" ); }
+        } catch( const std::exception& x ) {
+            const vector<string> messages = sm::messages_of( x );
+            TEST_CHECK( messages.size() == 3 and messages[0].find( "outer" ) != string::npos );
+            TEST_CHECK( messages[1] == "foreign 2" and messages[2] == "foreign 1" );
+            TEST_CHECK( dynamic_cast<const sm::Has_cause_chain*>( &x ) != nullptr );
+
+            string nested_message;
+            try { std::rethrow_if_nested( x ); } catch( const std::exception& nested ) { nested_message = nested.what(); }
+            TEST_CHECK( nested_message == "foreign 2" );
+        }
+        try {
+            try { throw_foreign_chain( 2, true ); } catch( ... ) { SM_FAIL( "outer" ); }
+        } catch( const std::exception& x ) {
+            int n_messages = 0;
+            const bool all_standard = sm::with_messages_of( x, [&]( C_string_ptr ){ ++n_messages; } );
+            TEST_CHECK( not all_standard and n_messages == 2 );
+        }
+
+        try { SM_FAIL( "a" ); } catch( ... ) { sm::push_current_exception(); }
+        bool caught_single = false;
+        try { sm::rethrow_popped_exception(); } catch( const std::exception& ) { caught_single = true; }
+        TEST_CHECK( caught_single );
+
+        for( const int i: zero_to( 3 ) ) {
+            try { SM_FAIL( "number " + to_string( i ) ); } catch( ... ) { sm::push_current_exception(); }
+        }
+        bool caught_group = false;
+        try {
+            sm::rethrow_popped_exception();
+        } catch( const sm::Exception_group& x ) {
+            caught_group = (x.exceptions().size() == 3);
+        }
+        TEST_CHECK( caught_group );
+        TEST_CHECK( not sm::rethrow_popped_exception() );
+
+        // Worker threads push to a queue of the consuming thread, retrying while it's full.
+        TEST_CHECK( sm::push_current_exception().error_code == 2 );     // No current exception.
+        const int n_producers = 4;
+        const int n_per_producer = 200;
+        sm::Exception_queue queue( 8 );
+        vector<thread> producers;
+        for( const int i_producer: zero_to( n_producers ) ) {
+            producers.emplace_back( [&, i_producer]
+            {
+                for( const int i: zero_to( n_per_producer ) ) {
+                    try {
+                        throw runtime_error( to_string( i_producer*n_per_producer + i ) );
+                    } catch( ... ) {
+                        while( not sm::push_current_exception_to( queue ) ) { this_thread::yield(); }
+                    }
+                }
+            } );
+        }
+        vector<int> last_seen( n_producers, -1 );
+        int n_seen = 0;
+        bool in_order = true;
+        while( n_seen < n_producers*n_per_producer ) {
+            if( const auto px = queue.popped() ) {
+                try {
+                    std::rethrow_exception( *px );
+                } catch( const runtime_error& x ) {
+                    const int v = std::stoi( x.what() );
+                    in_order = in_order and v % n_per_producer == last_seen[v/n_per_producer] + 1;
+                    last_seen[v/n_per_producer] = v % n_per_producer;
+                }
+                ++n_seen;
+            } else {
+                this_thread::yield();
+            }
+        }
+        for( thread& t: producers ) { t.join(); }
+        TEST_CHECK( in_order and not queue.popped() );
+    }
+
+    // Many producers into a small queue; every item is seen exactly once and in order per producer.
+    void test_mpsc_queue()
+    {
+        const int n_producers = 8;
+        const int n_per_producer = 5'000;
+        sm::Bounded_mpsc_queue_<int> queue( 64 );
+        vector<thread> producers;
+        for( const int i_producer: zero_to( n_producers ) ) {
+            producers.emplace_back( [&, i_producer]
+            {
+                for( const int i: zero_to( n_per_producer ) ) {
+                    while( not queue.push( i_producer*n_per_producer + i ) ) { this_thread::yield(); }
+                }
+            } );
+        }
+        vector<int> last_seen( n_producers, -1 );
+        int n_seen = 0;
+        bool in_order = true;
+        while( n_seen < n_producers*n_per_producer ) {
+            if( const auto v = queue.popped() ) {
+                const int i_producer = *v/n_per_producer;
+                in_order = in_order and *v % n_per_producer == last_seen[i_producer] + 1;
+                last_seen[i_producer] = *v % n_per_producer;
+                ++n_seen;
+            } else {
+                this_thread::yield();
+            }
+        }
+        for( thread& t: producers ) { t.join(); }
+        TEST_CHECK( in_order );
+        TEST_CHECK( not queue.popped() );
+    }
+
+    struct With_id:         sm::Option_<int>{};
+    struct With_title:      sm::Option_<C_string_ptr>{};
+    struct With_style:      sm::Option_<unsigned>{};
+
+    template< class... Options >
+    using Options_ = sm::Option_pack_<sm::Type_list_<With_id, With_title, With_style>, Options...>;
+
+    // Only the present options are stored, and lookups and defaults are constant expressions.
+    //
+    // A repeated option doesn't compile: `Options_<With_id, With_id>( With_id{ 1 }, With_id{ 2 } )`
+    // fails the static_assert "An option type is specified more than once.", and an option type
+    // that's not in the list fails "Unsupported option type.".
+    void test_option_pack()
+    {
+        static_assert( sizeof( Options_<> ) == 1 );
+        static_assert( sizeof( Options_<With_id> ) == sizeof( int ) );
+        static_assert( sizeof( Options_<With_title, With_id> ) == 2*sizeof( C_string_ptr ) );
+
+        constexpr auto options = Options_<With_style, With_id>( With_style{ 7 }, With_id{ 42 } );
+        static_assert( options.has_<With_id> and options.has_<With_style> and not options.has_<With_title> );
+        static_assert( (options | With_id{ 0 }).value == 42 and (options | With_style{ 0 }).value == 7 );
+        static_assert( string_view( (options | With_title{ "Default" }).value ) == "Default" );
+        static_assert( (Options_<>() | With_id{ -1 }).value == -1 );
+
+        const auto title_only = Options_<With_title>( With_title{ "Title" } );
+        TEST_CHECK( string_view( (title_only | With_title{ "Default" }).value ) == "Title" );
+        TEST_CHECK( (title_only | With_id{ 3 }).value == 3 );
+    }
+
+    void test_string_interner()
+    {
+        sm::String_interner interner;
+        vector<string> texts;
+        for( const int i: zero_to( 1000 ) ) { texts.push_back( "Title " + to_string( i ) + string( i % 7 == 0? 2000 : 0, 'x' ) ); }
+        vector<string_view> interned;
+        for( const string& s: texts ) { interned.push_back( interner.intern( s ) ); }
+        for( const int i: zero_to( 1000 ) ) {
+            const string_view v = interner.intern( texts[i] );
+            TEST_CHECK( v.data() == interned[i].data() and v == texts[i] and v.data()[v.size()] == '\0' );
+        }
+        TEST_CHECK( interner.n_strings() == 1000 );
+        TEST_CHECK( interner.intern( "" ).empty() and interner.intern( "" ).data() != nullptr );
+    }
+
+    void test_work_stealing_pool()
+    {
+        for( const int n_threads: one_through( 4 ) ) {
+            sm::Work_stealing_pool pool( n_threads );
+            for( const int i_job: zero_to( 100 ) ) {
+                const int n = i_job % 97;
+                vector<atomic<int>> n_calls( n );
+                pool.for_each_index( n, [&]( const int i ) { ++n_calls[i]; if( i % 7 == 0 ) { this_thread::yield(); } } );
+                for( const atomic<int>& count: n_calls ) { TEST_CHECK( count == 1 ); }
+            }
+
+            bool caught = false;
+            try {
+                pool.for_each_index( 100, []( const int i ) { if( i == 42 ) { throw runtime_error( "Boom." ); } } );
+            } catch( const runtime_error& ) {
+                caught = true;
+            }
+            TEST_CHECK( caught );
+
+            atomic<int> n_calls = 0;
+            pool.for_each_index( 10, [&]( int ) { ++n_calls; } );
+            TEST_CHECK( n_calls == 10 );
+        }
+    }
+}  // namespace <anon>
+
+auto main() -> int
+{
+    return testing::run_tests( {
+        {"interval views",          test_interval_views},
+        {"string diff",             test_string_diff},
+        {"unique handle",           test_unique_handle},
+        {"lru caches",              test_lru_caches},
+        {"triple buffer",           test_triple_buffer},
+        {"cancellation",            test_cancellation},
+        {"wait operation",          test_wait_operation},
+        {"timer queue",             test_timer_queue},
+        {"frame pacer",             test_frame_pacer},
+        {"latency histogram",       test_latency_histogram},
+        {"dispatch map",            test_dispatch_map},
+        {"string building",         test_string_building},
+        {"exception handling",      test_exception_handling},
+        {"mpsc queue",              test_mpsc_queue},
+        {"option pack",             test_option_pack},
+        {"string interner",         test_string_interner},
+        {"work stealing pool",      test_work_stealing_pool},
+        } );
+}
@@ -0,0 +1,60 @@
+﻿#pragma once    // Source encoding: UTF-8 with BOM (π is a lowercase Greek "pi").
+
+// Minimal test support for the portable headers, without a test framework: `TEST_CHECK( cond )`
+// reports a failed condition, and `run_tests` runs named test functions and gives `main`'s result.
+// A test function that throws counts as failed, with the exception's messages reported.
+
+#include <microlib/support-machinery/basic-types.hpp>           // C_string_ptr
+#include <microlib/support-machinery/exception-handling.hpp>    // with_messages_of
+#include <microlib/support-machinery/type-builders.hpp>         // in_
+
+#include <stdio.h>          // fprintf, printf, stderr
+#include <stdlib.h>         // EXIT_FAILURE, EXIT_SUCCESS
+
+#include <exception>
+#include <initializer_list>
+
+#define TEST_CHECK( ... )   testing::check( !!(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__ )
+
+namespace testing {
+    namespace sm = support_machinery;
+    using   sm::C_string_ptr, sm::in_;
+    using   std::exception,                 // <exception>
+            std::initializer_list;
+
+    inline int n_failed_checks = 0;
+
+    inline void check( const bool condition, const C_string_ptr text, const C_string_ptr file, const int line )
+    {
+        if( not condition ) {
+            fprintf( stderr, "!%s(%d): check failed: %s\n", file, line, text );
+            ++n_failed_checks;
+        }
+    }
+
+    struct Test{ C_string_ptr name; void( *func )(); };
+
+    inline auto run_tests( in_<initializer_list<Test>> tests )
+        -> int
+    {
+        int n_failed_tests = 0;
+        for( const Test& test: tests ) {
+            const int n_failed_before = n_failed_checks;
+            try {
+                test.func();
+            } catch( const exception& x ) {
+                fprintf( stderr, "!%s: exception:\n", test.name );
+                sm::with_messages_of( x, []( const C_string_ptr s ) { fprintf( stderr, "    %s\n", s ); } );
+                ++n_failed_checks;
+            } catch( ... ) {
+                fprintf( stderr, "!%s: non-standard exception.\n", test.name );
+                ++n_failed_checks;
+            }
+            const bool ok = (n_failed_checks == n_failed_before);
+            printf( "%s %s\n", (ok? "[ok]    " : "[FAILED]"), test.name );
+            n_failed_tests += not ok;
+        }
+        printf( "%d of %d tests failed.\n", n_failed_tests, int( tests.size() ) );
+        return (n_failed_tests == 0? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+}  // namespace testing